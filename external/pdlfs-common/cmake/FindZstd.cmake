@@ -0,0 +1,32 @@
+#
+# find zstd library and set up an imported target for it since
+# zstd doesn't provide this for us...
+#
+
+#
+# inputs:
+#   - ZSTD_INCLUDE_DIR: hint for finding zstd.h
+#   - ZSTD_LIBRARY_DIR: hint for finding zstd lib
+#
+# output:
+#   - "zstd" library target
+#   - ZSTD_FOUND  (set if found)
+#
+
+include (FindPackageHandleStandardArgs)
+
+find_path (ZSTD_INCLUDE zstd.h HINTS ${ZSTD_INCLUDE_DIR})
+find_library (ZSTD_LIBRARY zstd HINTS ${ZSTD_LIBRARY_DIR})
+
+find_package_handle_standard_args (Zstd DEFAULT_MSG
+    ZSTD_INCLUDE ZSTD_LIBRARY)
+
+mark_as_advanced (ZSTD_INCLUDE ZSTD_LIBRARY)
+
+if (ZSTD_FOUND AND NOT TARGET zstd)
+    add_library (zstd UNKNOWN IMPORTED)
+    set_target_properties (zstd PROPERTIES
+        INTERFACE_INCLUDE_DIRECTORIES "${ZSTD_INCLUDE}")
+    set_property (TARGET zstd APPEND PROPERTY
+        IMPORTED_LOCATION "${ZSTD_LIBRARY}")
+endif ()
@@ -34,6 +34,9 @@ include (xpkg-import)
 #   -DPDLFS_SNAPPY=ON                      -- compile in snappy compression
 #     - SNAPPY_INCLUDE_DIR: optional hint for finding snappy.h
 #     - SNAPPY_LIBRARY_DIR: optional hint for finding snappy lib
+#   -DPDLFS_ZSTD=ON                        -- compile in zstd compression
+#     - ZSTD_INCLUDE_DIR: optional hint for finding zstd.h
+#     - ZSTD_LIBRARY_DIR: optional hint for finding zstd lib
 #   -DPDLFS_VERBOSE=1                      -- set max log verbose level
 #
 # output variables:
@@ -110,6 +113,8 @@ set (PDLFS_RADOS "OFF" CACHE
      BOOL "Include RADOS object store")
 set (PDLFS_SNAPPY "OFF" CACHE
      BOOL "Include (libsnappy-dev) for compression")
+set (PDLFS_ZSTD "OFF" CACHE
+     BOOL "Include (libzstd-dev) for dictionary compression")
 
 #
 # now start pulling the parts in.  currently we set find_package to
@@ -155,3 +160,9 @@ if (PDLFS_SNAPPY)
     list (APPEND PDLFS_COMPONENT_CFG "Snappy")
     message (STATUS "Enabled Snappy - PDLFS_SNAPPY=ON")
 endif ()
+
+if (PDLFS_ZSTD)
+    find_package(Zstd MODULE REQUIRED)
+    list (APPEND PDLFS_COMPONENT_CFG "Zstd")
+    message (STATUS "Enabled Zstd - PDLFS_ZSTD=ON")
+endif ()
@@ -20,7 +20,10 @@ enum CompressionType {
   // NOTE: do not change the values of existing entries, as these are
   // part of the persistent format on disk.
   kNoCompression = 0x0,
-  kSnappyCompression = 0x1
+  kSnappyCompression = 0x1,
+  // Data blocks of a Table may be compressed with a dictionary stored
+  // in the Table's meta blocks.
+  kZstdCompression = 0x2
 };
 
 }  // namespace pdlfs
@@ -68,6 +68,7 @@ struct DirEntry {
   DirEntry* prev;
   size_t charge;
   size_t key_length;
+  uint64_t birth;  // Number of cache inserts before this entry was inserted
   uint32_t refs;
   uint32_t hash;  // Hash of key(); used for fast partitioning and comparisons
   char key_data[1];  // Beginning of key
@@ -70,6 +70,16 @@ class Env {
   // The returned file may be concurrently accessed by multiple threads.
   virtual Status NewRandomAccessFile(const char* f, RandomAccessFile** r) = 0;
 
+  // Same as NewRandomAccessFile() except that reads should bypass the OS
+  // page cache whenever possible.  Intended for large files that are read
+  // only once, so reading them does not evict data other readers depend on.
+  // Reads need not be aligned, but reads whose offset, size, and buffer are
+  // all multiples of the device block size avoid an extra copy.
+  // The default implementation simply calls NewRandomAccessFile().
+  //
+  // The returned file may be concurrently accessed by multiple threads.
+  virtual Status NewDirectRandomAccessFile(const char* f, RandomAccessFile** r);
+
   // Create an object that writes to a new file with the specified name.
   // Deletes any existing file with the same name and creates a new file.
   // On success, stores a pointer to the new file in *r and returns OK.
@@ -78,6 +88,14 @@ class Env {
   // The returned file will only be accessed by one thread at a time.
   virtual Status NewWritableFile(const char* f, WritableFile** r) = 0;
 
+  // Same as NewWritableFile() except that the written data should bypass
+  // the OS page cache whenever possible.  Intended for large files that will
+  // not be read back soon, so writing them does not evict data other readers
+  // depend on.  The default implementation simply calls NewWritableFile().
+  //
+  // The returned file will only be accessed by one thread at a time.
+  virtual Status NewDirectWritableFile(const char* f, WritableFile** r);
+
   // Returns true iff the named file exists.
   virtual bool FileExists(const char* f) = 0;
 
@@ -390,6 +408,15 @@ class EnvWrapper : public Env {
     return target_->NewWritableFile(f, r);
   }
 
+  virtual Status NewDirectWritableFile(const char* f, WritableFile** r) {
+    return target_->NewDirectWritableFile(f, r);
+  }
+
+  virtual Status NewDirectRandomAccessFile(const char* f,
+                                           RandomAccessFile** r) {
+    return target_->NewDirectRandomAccessFile(f, r);
+  }
+
   virtual bool FileExists(const char* f) { return target_->FileExists(f); }
 
   virtual Status GetChildren(const char* d, std::vector<std::string>* r) {
@@ -358,6 +358,44 @@ class MeasuredRandomAccessFile : public RandomAccessFile {
   RandomAccessFile* base_;
 };
 
+// Serve small reads from a buffer that is refilled with "readahead_size"
+// bytes starting at the offset of the first read that misses the buffer.
+// Reads never go beyond "file_size", which must be the size of *base.
+// Useful when a random access file is mostly read from beginning to end,
+// such as a table being compacted, so that the underlying storage sees a
+// few large reads instead of many small ones.
+class ReadaheadRandomAccessFile : public RandomAccessFile {
+ public:
+  // *base will be deleted when this class is deleted.
+  ReadaheadRandomAccessFile(RandomAccessFile* base, uint64_t file_size,
+                            size_t readahead_size)
+      : base_(base),
+        file_size_(file_size),
+        readahead_size_(readahead_size),
+        buf_offset_(0),
+        buf_size_(0) {
+    buf_ = new char[readahead_size_];
+  }
+
+  virtual ~ReadaheadRandomAccessFile() {
+    delete[] buf_;
+    delete base_;
+  }
+
+  // Data is always copied into "scratch".
+  // NOT safe for concurrent use by multiple threads.
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const;
+
+ private:
+  RandomAccessFile* base_;
+  const uint64_t file_size_;
+  const size_t readahead_size_;
+  mutable uint64_t buf_offset_;
+  mutable size_t buf_size_;
+  char* buf_;
+};
+
 // Convert a sequential file into a fully buffered random access file by
 // pre-fetching all file contents into memory and use that to serve all future
 // read requests to the underlying file. At most "max_buf_size_" worth of data
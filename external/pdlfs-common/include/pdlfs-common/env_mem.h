@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2015-2018 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#pragma once
+
+#include "pdlfs-common/env.h"
+
+namespace pdlfs {
+
+// Return a new Env that keeps all files and directories in memory and
+// forwards all non-file operations (threads, clock, host info) to *base.
+// File data is kept in 64KB blocks and the memory of all blocks is bounded
+// by "capacity" bytes; appends that would go beyond it fail with a
+// BufferFull status. Use 0 for no bound. Files can only be created in
+// existing directories.
+// File data is dropped when the Env is deleted.
+//
+// The result is thread safe. Files obtained from it must be deleted
+// before the Env itself. *base must remain alive while the result is
+// in use. The caller owns the result and should delete it when it is
+// no longer needed.
+extern Env* NewMemEnv(Env* base, uint64_t capacity = 0);
+
+// Store the number of bytes of memory currently allocated for file data by
+// an Env returned by NewMemEnv() in *usage. Return OK on success, or
+// InvalidArgument if "env" was not returned by NewMemEnv().
+extern Status MemEnvUsage(Env* env, uint64_t* usage);
+
+}  // namespace pdlfs
@@ -80,6 +80,16 @@ class DirIndex {
   // Return the server responsible for the given file name hash.
   int HashToServer(const Slice& hash) const;
 
+  // Compute the partitions responsible for a batch of "n" file names.
+  // Names are hashed in one pass before partitions are resolved.
+  // REQUIRES: indices[] has room for at least "n" entries.
+  void GetIndices(const Slice* names, size_t n, int* indices) const;
+
+  // Compute the servers responsible for a batch of "n" file names.
+  // Callers may use the result to group requests by server.
+  // REQUIRES: servers[] has room for at least "n" entries.
+  void SelectServers(const Slice* names, size_t n, int* servers) const;
+
   // Return true iff the bit of a partition is set.
   bool IsSet(int index) const;
 
@@ -119,6 +129,11 @@ class DirIndex {
   // Return the hash value of the specified name string.
   static Slice Hash(const Slice& name, char* scratch);
 
+  // Store the hash values of "n" name strings into scratch[], which
+  // must have room for at least 8 * n bytes. The i-th hash is
+  // stored at scratch + 8 * i.
+  static void HashBatch(const Slice* names, size_t n, char* scratch);
+
   // Return the server responsible for a given index.
   static int MapIndexToServer(int index, int zeroth_server, int num_servers);
 
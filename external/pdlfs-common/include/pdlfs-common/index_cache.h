@@ -35,6 +35,10 @@ class IndexCache {
   Handle* Insert(const DirId& id, DirIndex* index);
   void Erase(const DirId& id);
 
+  // Estimate hit ratios at larger cache capacities.
+  void EnableSimulation();
+  void GetStats(LRUCacheStats* stats);
+
  private:
   static Slice LRUKey(const DirId&, char* scratch);
   LRUCache<IndexEntry> lru_;
@@ -78,6 +78,7 @@ struct LeaseEntry {
   LeaseEntry* prev;
   size_t charge;
   size_t key_length;
+  uint64_t birth;  // Number of cache inserts before this entry was inserted
   uint32_t refs;
   uint32_t hash;  // Hash of key(); used for fast partitioning and comparisons
   char key_data[1];  // Beginning of key
@@ -109,6 +110,10 @@ class LeaseTable {
   Lease::Ref* Insert(const DirId& pid, const Slice& nhash, Lease* lease);
   void Erase(const DirId& pid, const Slice& nhash);
 
+  // Estimate hit ratios at larger table capacities.
+  void EnableSimulation();
+  void GetStats(LRUCacheStats* stats);
+
  private:
   static Slice LRUKey(const DirId&, const Slice&, char* scratch);
   LeaseOptions options_;
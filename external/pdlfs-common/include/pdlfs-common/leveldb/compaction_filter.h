@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+ * Copyright (c) 2013 The RocksDB Authors.
+ * Copyright (c) 2015-2017 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include <string>
+
+#include "pdlfs-common/slice.h"
+
+namespace pdlfs {
+
+// Interface for user-defined functions that decide, for each key
+// encountered during memtable flushes and compactions, whether the
+// key should be kept, removed, or have its value rewritten.
+//
+// The filter is only consulted for the newest value of a key that is
+// not visible to any live snapshot. Older values of the key and deletion
+// markers are never passed to the filter.
+class CompactionFilter {
+ public:
+  CompactionFilter() {}
+  virtual ~CompactionFilter();
+
+  enum Decision {
+    kKeep = 0,
+    kRemove = 1,
+    kChangeValue = 2  // Replace the value with *new_value
+  };
+
+  // "level" is the level the key is being compacted into. Memtable
+  // flushes are reported as level 0. A removed key may be turned into a
+  // deletion marker if older values of it may exist in deeper levels.
+  //
+  // The filter may be called concurrently from different threads.
+  virtual Decision Filter(int level, const Slice& key, const Slice& value,
+                          std::string* new_value) const = 0;
+
+  // The name of the filter. Used for logging.
+  virtual const char* Name() const = 0;
+};
+
+}  // namespace pdlfs
@@ -60,6 +60,16 @@ class DB {
   // Note: consider setting options.sync = true.
   virtual Status Delete(const WriteOptions& options, const Slice& key) = 0;
 
+  // Remove all database entries (if any) in the key range [begin, end)
+  // using a single range tombstone.  Returns OK on success, and a non-OK
+  // status on error.  Implementations that do not support range
+  // deletions return NotSupported.
+  // Note: a tombstone is only dropped by a compaction that finds its range
+  // empty. With options.disable_compaction, tombstones and the data they
+  // hide are kept until the DB is compacted manually.
+  virtual Status DeleteRange(const WriteOptions& options, const Slice& begin,
+                             const Slice& end);
+
   // Apply the specified updates to the database.
   // Returns OK on success, non-OK on failure.
   // Note: consider setting options.sync = true.
@@ -103,6 +113,15 @@ class DB {
   virtual Status Get(const ReadOptions& options, const Slice& key, Slice* value,
                      char* scratch, size_t scratch_size) = 0;
 
+  // Return OK if the database contains an entry for "key", or a status
+  // for which Status::IsNotFound() returns true otherwise. Implementations
+  // may answer from memtables, filters, and index blocks alone, reading
+  // a data block only to confirm a potential match. The default
+  // implementation calls Get() without copying any value bytes.
+  //
+  // May return some other Status on an error.
+  virtual Status Exists(const ReadOptions& options, const Slice& key);
+
   // Return a heap-allocated iterator over the contents of the database.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
@@ -135,6 +154,11 @@ class DB {
   //     about the internal operation of the DB.
   //  "leveldb.sstables" - returns a multi-line string that describes all
   //     of the sstables that make up the db contents.
+  //  "leveldb.exists-blocks-avoided" - returns the number of data block
+  //     reads that Exists() has skipped because a table filter ruled out
+  //     the key.
+  //  "leveldb.exists-blocks-read" - returns the number of data blocks that
+  //     Exists() has read from storage. Block cache hits are not counted.
   virtual bool GetProperty(const Slice& property, std::string* value) = 0;
 
   // For each i in [0,n-1], store in "sizes[i]", the approximate
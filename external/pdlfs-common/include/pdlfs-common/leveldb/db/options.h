@@ -18,6 +18,7 @@
 namespace pdlfs {
 
 class Cache;
+class CompactionFilter;
 class Comparator;
 class Env;
 class FilterPolicy;
@@ -33,6 +34,18 @@ enum IndexType {
   kCompact = 0x1
 };
 
+// Strategy used to merge Tables in the background.
+enum CompactionStyle {
+  // Tables are organized into levels of exponentially increasing sizes.
+  // Reads are cheap but each byte is rewritten about "level_factor"
+  // times per level.
+  kCompactionStyleLeveled = 0x0,
+  // Tables are kept as sorted runs in Level-0 and runs of similar sizes
+  // are merged together.  Writes are much cheaper at the expense of
+  // reads, which may have to search up to "l0_compaction_trigger" runs.
+  kCompactionStyleTiered = 0x1
+};
+
 // Options to control the behavior of a database (passed to DB::Open)
 struct DBOptions {
   // -------------------
@@ -85,14 +98,36 @@ struct DBOptions {
   // on disk) before converting to a sorted on-disk file.
   //
   // Larger values increase performance, especially during bulk loads.
-  // Up to two write buffers may be held in memory at the same time,
-  // so you may wish to adjust this parameter to control memory usage.
+  // Up to max_imm_memtables + 1 write buffers may be held in memory at
+  // the same time, so you may wish to adjust this parameter to control
+  // memory usage.
   // Also, a larger write buffer will result in a longer recovery time
   // the next time the database is opened.
   //
   // Default: 4MB
   size_t write_buffer_size;
 
+  // Max number of full write buffers that may wait in memory to be
+  // compacted.  Writes only stall when the active write buffer fills up
+  // while this many are still pending, so larger values let short bursts
+  // of writes be absorbed without waiting for the background thread.
+  //
+  // Default: 1
+  int max_imm_memtables;
+
+  // Max total memory used by full write buffers waiting to be compacted.
+  // Writes stall once this limit is reached even if fewer than
+  // max_imm_memtables are pending.  0 means no limit.
+  //
+  // Default: 0
+  size_t max_imm_memory;
+
+  // If true, all pending write buffers are merged into a single table
+  // at each memtable compaction instead of producing one table each.
+  //
+  // Default: false
+  bool merge_imm_memtables;
+
   // Control over open tables (max number of tables that can be opened).
   // You may need to increase this if your database has a large working set (
   // budget one open file per 2MB of working set).
@@ -155,6 +190,15 @@ struct DBOptions {
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression;
 
+  // If positive and "compression" is kZstdCompression, a dictionary of at
+  // most this many bytes is trained from the first memtable flushed by
+  // each DB instance and used to compress the data blocks of all Tables
+  // written afterwards.  Blocks of small records with similar structure
+  // compress much better with a dictionary.  Each Table stores a copy of
+  // the dictionary it uses.
+  // Default: 0
+  size_t compression_dict_size;
+
   // If non-NULL, use the specified filter policy to reduce disk reads.
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
@@ -162,6 +206,13 @@ struct DBOptions {
   // Default: NULL
   const FilterPolicy* filter_policy;
 
+  // If non-NULL, use the specified compaction filter to drop or rewrite
+  // keys during memtable flushes and compactions.  This allows dead
+  // keys to be reclaimed lazily without writing explicit deletions.
+  //
+  // Default: NULL
+  const CompactionFilter* compaction_filter;
+
   // -------------------
   // Dangerous zone - parameters for experts
 
@@ -189,10 +240,17 @@ struct DBOptions {
   // Default: false
   bool disable_write_ahead_log;
 
+  // Set to true to have readonly db instances also replay the write-ahead
+  // logs of the read-write instance each time they load or reload, making
+  // updates visible before they are flushed to tables.
+  // Default: false
+  bool tail_write_ahead_log;
+
   // If true, no background compaction will be performed except for
   // those triggered by MemTable dumps.
   // All Tables will stay in Level-0 forever.
   // This facilitates fast insertion speed at the expense of read performance.
+  // Range tombstones also accumulate since only compactions drop them.
   // Default: false
   bool disable_compaction;
 
@@ -227,6 +285,38 @@ struct DBOptions {
   // Default: 12
   int l0_hard_limit;
 
+  // The compaction strategy.  With kCompactionStyleTiered, all Tables stay
+  // in Level-0 as sorted runs and "l0_compaction_trigger" bounds the number
+  // of runs.  "level_factor" and "l1_compaction_trigger" are not used.
+  // Default: kCompactionStyleLeveled
+  CompactionStyle compaction_style;
+
+  // Used by tiered compaction.  A run is merged with the newer runs
+  // picked before it if its size is at most this percentage larger than
+  // their total size.
+  // Default: 1
+  int tiered_size_ratio;
+
+  // If positive, compaction inputs are read through private file handles
+  // that fetch this many bytes at a time instead of through the handles
+  // shared with foreground reads.
+  // Default: 0
+  size_t compaction_readahead_size;
+
+  // Set to true to write compaction outputs through
+  // Env::NewDirectWritableFile() so that they bypass the OS page cache and
+  // do not evict the data foreground reads depend on.
+  // Default: false
+  bool compaction_direct_writes;
+
+  // If positive and a block cache is set, up to this many bytes of the
+  // data blocks written by each compaction are inserted into the block
+  // cache once the output tables are complete.  Only blocks covering keys
+  // whose input blocks were cached when the compaction started qualify,
+  // so reads of hot keys keep hitting the cache after the compaction.
+  // Default: 0
+  size_t compaction_cache_warmup_size;
+
   DBOptions();
 };
 
@@ -258,6 +348,15 @@ struct ReadOptions {
   // Default: NULL
   const Snapshot* snapshot;
 
+  // If non-NULL, iterators only return user keys at or after
+  // "*iterate_lower_bound" and strictly before "*iterate_upper_bound".
+  // Tables that cannot hold such keys are never opened and scans stop as
+  // soon as they reach the upper bound.  The bounds are copied when the
+  // iterator is created.  Point lookups ignore them.
+  // Default: NULL
+  const Slice* iterate_lower_bound;
+  const Slice* iterate_upper_bound;
+
   ReadOptions();
 };
 
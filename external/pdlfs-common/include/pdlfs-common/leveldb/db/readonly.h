@@ -33,15 +33,20 @@ class ReadonlyDB : public DB {
   virtual Status FlushMemTable(const FlushOptions&);
   virtual Status Put(const WriteOptions&, const Slice& key, const Slice& value);
   virtual Status Delete(const WriteOptions&, const Slice& key);
+  virtual Status DeleteRange(const WriteOptions&, const Slice& begin,
+                             const Slice& end);
   virtual Status Write(const WriteOptions&, WriteBatch* updates);
   virtual Status AddL0Tables(const InsertOptions&, const std::string& dir);
   virtual void CompactRange(const Slice* begin, const Slice* end);
   virtual Status DrainCompactions();
 
   // Load an existing db image produced by another db.
+  // Safe to call concurrently with reads.
   virtual Status Load() = 0;
 
-  // Incrementally reload new updates.
+  // Incrementally reload new updates. A db returned by Open() may be
+  // static_cast to ReadonlyDB to call this.
+  // Safe to call concurrently with reads.
   virtual Status Reload() = 0;
 };
 
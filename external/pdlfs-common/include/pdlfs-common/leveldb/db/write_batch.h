@@ -44,6 +44,10 @@ class WriteBatch {
   // If the database contains a mapping for "key", erase it.  Else do nothing.
   void Delete(const Slice& key);
 
+  // Erase all mappings with keys in the range [begin, end) that were
+  // stored before this update.  Keys stored later are not affected.
+  void DeleteRange(const Slice& begin, const Slice& end);
+
   // Clear all updates buffered in this batch.
   void Clear();
 
@@ -53,6 +57,7 @@ class WriteBatch {
     virtual ~Handler();
     virtual void Put(const Slice& key, const Slice& value) = 0;
     virtual void Delete(const Slice& key) = 0;
+    virtual void DeleteRange(const Slice& begin, const Slice& end) = 0;
   };
   Status Iterate(Handler* handler) const;
 
@@ -11,6 +11,9 @@
  */
 
 #include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "pdlfs-common/status.h"
 
@@ -68,24 +71,49 @@ class Table {
   // if no valid properties can be found.
   const TableProperties* GetProperties() const;
 
+  // Append to *ranges the key range of each data block that is currently
+  // in the block cache.  A range is given by the index key of the
+  // preceding block (empty for the first block), which is less than all
+  // keys in the block, and the index key of the block, which is no less
+  // than all keys in the block.
+  void GetCachedBlockRanges(
+      std::vector<std::pair<std::string, std::string> >* ranges) const;
+
+  // Insert the uncompressed contents of the data block at "offset" into
+  // the block cache, if any.  Used to warm the cache for new tables.
+  void InsertCachedBlock(uint64_t offset, const Slice& contents) const;
+
+  // Counters updated by point lookups that are given a stats object.
+  struct ReadStats {
+    ReadStats() : filter_rejects(0), blocks_read(0) {}
+    uint64_t filter_rejects;  // Data block reads ruled out by the filter
+    uint64_t blocks_read;     // Data blocks read from storage
+  };
+
  private:
   struct Rep;
   Rep* rep_;
 
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+  // Same as above but sets *from_storage to true if the block is not
+  // served from the block cache.
+  static Iterator* BlockReader(Table*, const ReadOptions&, const Slice&,
+                               bool* from_storage);
 
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
-  // that key is not present.
+  // that key is not present.  Updates *stats if it is not NULL.
   friend class TableCache;
   Status InternalGet(const ReadOptions&, const Slice& key, void* arg,
                      void (*handle_result)(void* arg, const Slice& k,
-                                           const Slice& v));
+                                           const Slice& v),
+                     ReadStats* stats = NULL);
 
   void ReadMeta(const Footer& footer);
   void ReadFilter(const Slice& filter_handle_value);
   void ReadProps(const Slice& props_handle_value);
+  void ReadCompressionDict(const Slice& dict_handle_value);
 
   // No copying allowed
   void operator=(const Table&);
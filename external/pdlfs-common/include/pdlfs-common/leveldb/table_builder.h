@@ -11,6 +11,9 @@
  */
 
 #include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "pdlfs-common/leveldb/db/options.h"
 #include "pdlfs-common/status.h"
@@ -50,6 +53,25 @@ class TableBuilder {
   // without changing any fields.
   Status ChangeOptions(const Options& options);
 
+  // Compress data blocks using the given zstd dictionary, which is stored
+  // in the table's meta blocks.  Only used with kZstdCompression.
+  // REQUIRES: no data block has been written
+  void SetCompressionDictionary(const Slice& dict);
+
+  // Keep a copy of the uncompressed contents of each data block that
+  // receives a key marked by MarkNextKeyHot(), up to "budget" bytes in
+  // total.  The copies can be used to warm a block cache once the table
+  // is opened.  See TakeRetainedBlocks().
+  void RetainHotBlocks(size_t budget);
+
+  // Mark the data block that will receive the next key as hot.
+  void MarkNextKeyHot();
+
+  // Move the retained blocks into *blocks.  Each entry holds the offset
+  // of a data block in the file and its uncompressed contents.
+  void TakeRetainedBlocks(
+      std::vector<std::pair<uint64_t, std::string> >* blocks);
+
   // Add key,value to the table being constructed.
   // REQUIRES: key is after any previously added key according to comparator.
   // REQUIRES: Finish(), Abandon() have not been called
@@ -93,7 +115,8 @@ class TableBuilder {
   uint64_t FileSize() const;
 
  private:
-  void WriteBlock(const Slice& block_contents, BlockHandle* handle);
+  void WriteBlock(const Slice& block_contents, BlockHandle* handle,
+                  bool use_dict = false);
   void WriteRawBlock(const Slice& raw_block_contents, CompressionType,
                      BlockHandle* handle);
 
@@ -35,6 +35,10 @@ class LookupCache {
   Handle* Insert(const DirId& pid, const Slice& nhash, LookupStat* stat);
   void Erase(const DirId& pid, const Slice& nhash);
 
+  // Estimate hit ratios at larger cache capacities.
+  void EnableSimulation();
+  void GetStats(LRUCacheStats* stats);
+
  private:
   static Slice LRUKey(const DirId&, const Slice&, char* scratch);
   LRUCache<LookupEntry> lru_;
@@ -10,14 +10,61 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 #include "pdlfs-common/hash.h"
 #include "pdlfs-common/hashmap.h"
+#include "pdlfs-common/histogram.h"
 #include "pdlfs-common/slice.h"
 
 namespace pdlfs {
 
+// Statistics collected by an LRU cache. Counters are updated under the same
+// synchronization that protects the cache itself so no atomic
+// operations are needed.
+struct LRUCacheStats {
+  LRUCacheStats();
+  void Clear();
+  // Add the counters of another cache (e.g. another shard) to this one.
+  void Merge(const LRUCacheStats& other);
+  // Return the fraction of lookups that found a cached entry.
+  double HitRatio() const;
+  // Return the estimated hit ratio had the cache been 2^(level+1) times
+  // larger. Only meaningful when ghost simulation is enabled.
+  double SimulatedHitRatio(int level) const;
+  std::string ToString() const;
+
+  enum { kNumGhostLevels = 3 };  // Simulate 2x, 4x, and 8x capacities
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t inserts;
+  uint64_t evictions;
+  // Number of misses that would have been hits at each simulated capacity
+  uint64_t ghost_hits[kNumGhostLevels];
+  size_t usage;  // Total charge held
+  size_t capacity;
+  // Number of inserts made after an entry was inserted and before it was
+  // evicted
+  Histogram eviction_ages;
+};
+
+// A key recently evicted from an LRU cache. Ghost entries hold no values and
+// are only used to estimate the hit ratio at alternative cache capacities.
+struct LRUGhostEntry {
+  LRUGhostEntry* next_hash;
+  LRUGhostEntry* next;
+  LRUGhostEntry* prev;
+  size_t charge;
+  size_t key_length;
+  uint64_t evicted_at;  // Total charge evicted up to and including this entry
+  uint32_t hash;
+  char key_data[1];  // Beginning of key
+
+  Slice key() const { return Slice(key_data, key_length); }
+};
+
 template <typename T = void>
 struct LRUEntry {
   T* value;
@@ -27,6 +74,7 @@ struct LRUEntry {
   LRUEntry<T>* prev;
   size_t charge;
   size_t key_length;
+  uint64_t birth;  // Number of cache inserts before this entry was inserted
   uint32_t refs;
   uint32_t hash;  // Hash of key(); used for fast partitioning and comparisons
   char key_data[1];  // Beginning of key
@@ -59,10 +107,96 @@ class LRUCache {
 
   HashTable<E> table_;
 
+  LRUCacheStats stats_;
+
+  // Ghost entries for simulating larger capacities.
+  // ghosts_.prev is newest entry, ghosts_.next is oldest entry.
+  bool simulate_;
+  LRUGhostEntry ghosts_;
+  HashTable<LRUGhostEntry> ghost_table_;
+  size_t ghost_usage_;
+  uint64_t evicted_charge_;
+
   // No copying allowed
   void operator=(const LRUCache&);
   LRUCache(const LRUCache&);
 
+  static void Ghost_Remove(LRUGhostEntry* g) {
+    g->next->prev = g->prev;
+    g->prev->next = g->next;
+  }
+
+  void Ghost_Drop(const Slice& key, uint32_t hash) {
+    LRUGhostEntry* g = ghost_table_.Remove(key, hash);
+    if (g != NULL) {
+      Ghost_Remove(g);
+      ghost_usage_ -= g->charge;
+      free(g);
+    }
+  }
+
+  // Remember a key that has just been evicted. Old ghosts are dropped so that
+  // the cache and its ghosts together cover the largest simulated capacity.
+  void Ghost_Add(const E* e) {
+    LRUGhostEntry* g = static_cast<LRUGhostEntry*>(
+        malloc(sizeof(LRUGhostEntry) - 1 + e->key_length));
+    g->charge = e->charge;
+    g->key_length = e->key_length;
+    g->evicted_at = evicted_charge_;
+    g->hash = e->hash;
+    memcpy(g->key_data, e->key_data, e->key_length);
+    g->next = &ghosts_;
+    g->prev = ghosts_.prev;
+    g->prev->next = g;
+    g->next->prev = g;
+    ghost_usage_ += g->charge;
+    LRUGhostEntry* old = ghost_table_.Insert(g);
+    if (old != NULL) {
+      Ghost_Remove(old);
+      ghost_usage_ -= old->charge;
+      free(old);
+    }
+    const size_t limit =
+        ((static_cast<size_t>(1) << LRUCacheStats::kNumGhostLevels) - 1) *
+        capacity_;
+    while (ghost_usage_ > limit && ghosts_.next != &ghosts_) {
+      LRUGhostEntry* oldest = ghosts_.next;
+      ghost_table_.Remove(oldest->key(), oldest->hash);
+      Ghost_Remove(oldest);
+      ghost_usage_ -= oldest->charge;
+      free(oldest);
+    }
+  }
+
+  // Account a cache miss against the ghosts. A key found among the ghosts
+  // would still be cached had the cache been larger than its current
+  // capacity by the total charge evicted after that key.
+  void Ghost_Lookup(const Slice& key, uint32_t hash) {
+    LRUGhostEntry* g = ghost_table_.Remove(key, hash);
+    if (g != NULL) {
+      const uint64_t distance =
+          capacity_ + (evicted_charge_ - g->evicted_at) + g->charge;
+      for (int i = 0; i < LRUCacheStats::kNumGhostLevels; i++) {
+        if (distance <= (static_cast<uint64_t>(capacity_) << (i + 1))) {
+          stats_.ghost_hits[i]++;
+        }
+      }
+      Ghost_Remove(g);
+      ghost_usage_ -= g->charge;
+      free(g);
+    }
+  }
+
+  void Evict(E* e) {
+    stats_.evictions++;
+    stats_.eviction_ages.Add(
+        static_cast<double>(stats_.inserts - e->birth - 1));
+    if (simulate_) {
+      evicted_charge_ += e->charge;
+      Ghost_Add(e);
+    }
+  }
+
   void Unref(E* e) {
     assert(e->refs > 0);
     e->refs--;
@@ -87,10 +221,17 @@ class LRUCache {
   }
 
  public:
-  LRUCache(size_t capacity = 0) : capacity_(capacity), usage_(0) {
+  LRUCache(size_t capacity = 0)
+      : capacity_(capacity),
+        usage_(0),
+        simulate_(false),
+        ghost_usage_(0),
+        evicted_charge_(0) {
     // Make empty circular linked list
     lru_.next = &lru_;
     lru_.prev = &lru_;
+    ghosts_.next = &ghosts_;
+    ghosts_.prev = &ghosts_;
   }
 
   ~LRUCache() {
@@ -100,11 +241,27 @@ class LRUCache {
       Unref(e);
       e = next;
     }
+    for (LRUGhostEntry* g = ghosts_.next; g != &ghosts_;) {
+      LRUGhostEntry* next = g->next;
+      free(g);
+      g = next;
+    }
   }
 
   // Separate from constructor so caller can easily make an array of LRUCache
   void SetCapacity(size_t c) { capacity_ = c; }
 
+  // Keep track of recently evicted keys in order to estimate the hit
+  // ratio at larger capacities. Costs one small heap object per ghost key.
+  void EnableSimulation() { simulate_ = true; }
+
+  // Store a snapshot of the statistics of the cache in *stats.
+  void GetStats(LRUCacheStats* stats) const {
+    *stats = stats_;
+    stats->usage = usage_;
+    stats->capacity = capacity_;
+  }
+
   template <typename T>
   E* Insert(const Slice& key, uint32_t hash, T* value, size_t charge,
             void (*deleter)(const Slice& key, T* value)) {
@@ -113,11 +270,15 @@ class LRUCache {
     e->deleter = deleter;
     e->charge = charge;
     e->key_length = key.size();
+    e->birth = stats_.inserts++;
     e->hash = hash;
     e->refs = 2;  // One from LRUCache, one for the returned handle
     memcpy(e->key_data, key.data(), key.size());
     LRU_Append(e);
     usage_ += charge;
+    if (simulate_) {
+      Ghost_Drop(key, hash);
+    }
 
     E* old = table_.Insert(e);
     if (old != NULL) {
@@ -135,6 +296,7 @@ class LRUCache {
       LRU_Remove(old);
       if (!old->is_pinned()) {
         table_.Remove(old->key(), old->hash);
+        Evict(old);
         Unref(old);
       } else {
         LRU_Append(old);
@@ -148,9 +310,15 @@ class LRUCache {
   E* Lookup(const Slice& key, uint32_t hash) {
     E* e = *table_.FindPointer(key, hash);
     if (e != NULL) {
+      stats_.hits++;
       e->refs++;
       LRU_Remove(e);
       LRU_Append(e);
+    } else {
+      stats_.misses++;
+      if (simulate_) {
+        Ghost_Lookup(key, hash);
+      }
     }
     return e;
   }
@@ -118,6 +118,9 @@ class MDB {
   Status SetNode(const DirId& id, const Slice& hash, const Stat& stat,
                  const Slice& name, Tx* tx);
   Status DelNode(const DirId& id, const Slice& hash, Tx* tx);
+  // Remove all entries of a directory using a single range deletion.
+  // The deletion takes effect immediately and is not part of any Tx.
+  Status DelDir(const DirId& id);
 
   Status GetInfo(const DirId& id, DirInfo* info, Tx* tx);
   Status SetInfo(const DirId& id, const DirInfo& info, Tx* tx);
@@ -127,6 +130,11 @@ class MDB {
   typedef std::vector<Stat> StatList;
   size_t List(const DirId& id, StatList* stats, NameList* names, Tx* tx,
               size_t limit);
+  // List up to "limit" entries that immediately follow the given name hash
+  // in key order. The hash of each entry is stored in *hashes.
+  typedef std::vector<std::string> HashList;
+  size_t ListNext(const DirId& id, const Slice& hash, StatList* stats,
+                  HashList* hashes, Tx* tx, size_t limit);
   bool Exists(const DirId& id, const Slice& hash, Tx* tx);
 
   Status Commit(Tx* tx) {
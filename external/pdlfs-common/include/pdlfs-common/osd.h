@@ -39,7 +39,16 @@ class Osd {
   // path. If "env" is NULL, the result of Env::Default() will be used. The
   // caller must delete the result when it is no longer needed. The "*env" must
   // remain live while the result is in use.
-  static Osd* FromEnv(const char* prefix, Env* env = NULL);
+  //
+  // If "fanout" is greater than 1, objects are hashed by name into that many
+  // sub-directories under the prefix instead of sharing a single directory,
+  // keeping each directory small when the number of objects is large.
+  // Object names seen by the caller are not affected. The fan-out is
+  // recorded under the prefix when a store is first opened and later opens
+  // always use the recorded value, logging a warning if "fanout" differs.
+  // If the recorded fan-out cannot be read, every operation on the result
+  // fails with that error.
+  static Osd* FromEnv(const char* prefix, Env* env = NULL, int fanout = 0);
 
   // Create a brand new sequentially-readable object with the specified name.
   // On success, stores a pointer to the new object in *r and returns OK.
@@ -13,6 +13,7 @@
 #include "pdlfs-common/pdlfs_config.h"
 
 #include <string>
+#include <vector>
 #undef PLATFORM_IS_LITTLE_ENDIAN
 #if defined(PDLFS_OS_MACOSX)
 #include <machine/endian.h>
@@ -176,6 +177,45 @@ inline bool Snappy_Uncompress(const char* input, size_t length, char* output) {
 #endif
 }
 
+// Zstd compressors and uncompressors keep a pre-digested dictionary so that
+// it can be reused for many blocks.  All zstd functions return false (or
+// NULL) if zstd is not compiled in.
+struct ZstdCompressor;
+struct ZstdUncompressor;
+
+// Create a compressor using the given dictionary.  An empty dictionary
+// is allowed.  The result should be deleted by Zstd_DeleteCompressor().
+extern ZstdCompressor* Zstd_NewCompressor(const char* dict, size_t dict_size);
+extern void Zstd_DeleteCompressor(ZstdCompressor* compressor);
+
+// Compress with the compressor's dictionary iff "use_dict" is true.
+// NOT safe for concurrent use on the same compressor.
+extern bool Zstd_Compress(ZstdCompressor* compressor, bool use_dict,
+                          const char* input, size_t length,
+                          ::std::string* output);
+
+// Create an uncompressor using the given dictionary.  The result should be
+// deleted by Zstd_DeleteUncompressor().
+extern ZstdUncompressor* Zstd_NewUncompressor(const char* dict,
+                                              size_t dict_size);
+extern void Zstd_DeleteUncompressor(ZstdUncompressor* uncompressor);
+
+extern bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                       size_t* result);
+
+// Uncompress exactly "output_size" bytes into "output".  "uncompressor" may
+// be NULL if the input was compressed without a dictionary.
+// Safe for concurrent use.
+extern bool Zstd_Uncompress(ZstdUncompressor* uncompressor, const char* input,
+                            size_t length, char* output, size_t output_size);
+
+// Train a dictionary of at most "max_dict_size" bytes.  "samples" is the
+// concatenation of all samples, whose individual sizes are listed in
+// "sample_sizes".
+extern bool Zstd_TrainDictionary(const ::std::string& samples,
+                                 const ::std::vector<size_t>& sample_sizes,
+                                 size_t max_dict_size, ::std::string* dict);
+
 inline bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg) {
   return false;
 }
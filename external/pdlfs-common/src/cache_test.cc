@@ -12,6 +12,7 @@
 
 #include "pdlfs-common/cache.h"
 #include "pdlfs-common/coding.h"
+#include "pdlfs-common/lru.h"
 #include "pdlfs-common/testharness.h"
 
 namespace pdlfs {
@@ -179,6 +180,39 @@ TEST(CacheTest, NewId) {
   ASSERT_NE(a, b);
 }
 
+static void NoopDeleter(const Slice& key, void* value) {}
+
+TEST(CacheTest, LRUStats) {
+  typedef LRUEntry<> E;
+  LRUCache<E> lru(10);
+  lru.EnableSimulation();
+  for (int i = 0; i < 20; i++) {
+    std::string k = EncodeKey(i);
+    lru.Release(lru.Insert(k, Hash(k.data(), k.size(), 0), EncodeValue(i), 1,
+                           NoopDeleter));
+  }
+  // Keys 10-19 are cached; keys 0-9 have been evicted
+  for (int i = 0; i < 20; i++) {
+    std::string k = EncodeKey(i);
+    E* e = lru.Lookup(k, Hash(k.data(), k.size(), 0));
+    if (e != NULL) {
+      lru.Release(e);
+    }
+  }
+  LRUCacheStats stats;
+  lru.GetStats(&stats);
+  ASSERT_EQ(stats.hits, 10);
+  ASSERT_EQ(stats.misses, 10);
+  ASSERT_EQ(stats.inserts, 20);
+  ASSERT_EQ(stats.evictions, 10);
+  ASSERT_EQ(stats.usage, 10);
+  ASSERT_EQ(stats.capacity, 10);
+  // All evicted keys would have been cached at twice the capacity
+  ASSERT_EQ(stats.ghost_hits[0], 10);
+  ASSERT_TRUE(stats.SimulatedHitRatio(0) == 1.0);
+  ASSERT_TRUE(stats.HitRatio() == 0.5);
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char** argv) {
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015-2017 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include <errno.h>
+#include <vector>
+
+#include "pdlfs-common/dcntl.h"
+#include "pdlfs-common/testharness.h"
+
+namespace pdlfs {
+
+class DirTableTest {
+ public:
+  Dir* NewDir(bool locked = false) {
+    Dir* dir = new Dir(&mu_, &giga_);
+    dir->num_leases = 0;
+    dir->locked = locked;
+    dir->tx.NoBarrier_Store(NULL);
+    return dir;
+  }
+
+  port::Mutex mu_;
+  DirIndexOptions giga_;
+};
+
+TEST(DirTableTest, InsertLookupErase) {
+  DirTable table(4096);
+  for (int i = 0; i < 100; i++) {
+    Dir::Ref* r = table.Insert(DirId(0, 0, i), NewDir());
+    table.Release(r);
+  }
+  for (int i = 0; i < 100; i++) {
+    Dir::Ref* r = table.Lookup(DirId(0, 0, i));
+    ASSERT_TRUE(r != NULL);
+    table.Release(r);
+  }
+  for (int i = 0; i < 100; i++) {
+    table.Erase(DirId(0, 0, i));
+    ASSERT_TRUE(table.Lookup(DirId(0, 0, i)) == NULL);
+  }
+}
+
+// Busy directories cannot be evicted.
+TEST(DirTableTest, Full) {
+  DirTable table(16);
+  std::vector<Dir::Ref*> refs;
+  int err = 0;
+  for (int i = 0; i < 64 && err == 0; i++) {
+    Dir* dir = NewDir(true);
+    try {
+      refs.push_back(table.Insert(DirId(0, 0, i), dir));
+    } catch (int e) {
+      err = e;
+      delete dir;
+    }
+  }
+  // The table may go one over its capacity while the new entry is pinned.
+  ASSERT_EQ(err, ENOBUFS);
+  ASSERT_GE(refs.size(), 16);
+  ASSERT_LE(refs.size(), 17);
+  for (size_t i = 0; i < refs.size(); i++) {
+    refs[i]->value->locked = false;
+    table.Release(refs[i]);
+  }
+  for (int i = 0; i < 64; i++) {
+    table.Erase(DirId(0, 0, i));
+  }
+}
+
+}  // namespace pdlfs
+
+int main(int argc, char** argv) {
+  return ::pdlfs::test::RunAllTests(&argc, &argv);
+}
@@ -13,9 +13,11 @@
 #include "pdlfs-common/env.h"
 #include "pdlfs-common/env_files.h"
 #include "pdlfs-common/env_lazy.h"
+#include "pdlfs-common/env_mem.h"
 #include "pdlfs-common/logging.h"
 #include "pdlfs-common/pdlfs_config.h"
 #include "pdlfs-common/port.h"
+#include "pdlfs-common/strutil.h"
 
 #if defined(PDLFS_RADOS)
 #include "pdlfs-common/rados/rados_ld.h"
@@ -35,6 +37,14 @@ static const size_t kBufferSize = 8192;
 
 Env::~Env() {}
 
+Status Env::NewDirectWritableFile(const char* f, WritableFile** r) {
+  return NewWritableFile(f, r);
+}
+
+Status Env::NewDirectRandomAccessFile(const char* f, RandomAccessFile** r) {
+  return NewRandomAccessFile(f, r);
+}
+
 SequentialFile::~SequentialFile() {}
 
 RandomAccessFile::~RandomAccessFile() {}
@@ -74,6 +84,15 @@ Env* Env::Open(const char* name, const char* conf, bool* is_system) {
     return (Env*)PDLFS_Load_rados_env(env_conf.c_str());
   }
 #endif
+// MEM: conf is an optional capacity bound, such as "512M"
+  if (env_name == "mem") {
+    uint64_t capacity = 0;
+    if (!env_conf.empty() && !ParsePrettyNumber(env_conf, &capacity)) {
+      return NULL;
+    }
+    *is_system = false;
+    return NewMemEnv(Env::Default(), capacity);
+  }
 // POSIX
 #if defined(PDLFS_PLATFORM_POSIX)
   if (env_name == "posix" || env_name == "posix.default") {
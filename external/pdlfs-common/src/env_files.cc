@@ -11,6 +11,9 @@
 #include "pdlfs-common/mutexlock.h"
 #include "pdlfs-common/port.h"
 
+#include <string.h>
+#include <algorithm>
+
 // If c++11 or newer, directly use c++ std atomic counters.
 #if __cplusplus >= 201103L
 #include <atomic>
@@ -77,6 +80,44 @@ void RandomAccessFileStats::Reset() {
   rep_->ops = 0;
 }
 
+Status ReadaheadRandomAccessFile::Read(uint64_t offset, size_t n,
+                                       Slice* result, char* scratch) const {
+  if (offset >= file_size_) {
+    *result = Slice();
+    return Status::OK();
+  } else if (n > file_size_ - offset) {
+    n = static_cast<size_t>(file_size_ - offset);
+  }
+  if (n >= readahead_size_) {
+    return base_->Read(offset, n, result, scratch);
+  }
+  Status s;
+  if (offset < buf_offset_ || offset + n > buf_offset_ + buf_size_) {
+    const size_t m = static_cast<size_t>(
+        std::min<uint64_t>(readahead_size_, file_size_ - offset));
+    Slice r;
+    s = base_->Read(offset, m, &r, buf_);
+    if (s.ok()) {
+      if (r.data() != buf_) {
+        memcpy(buf_, r.data(), r.size());
+      }
+      buf_offset_ = offset;
+      buf_size_ = r.size();
+    } else {
+      buf_size_ = 0;
+      return s;
+    }
+  }
+  if (offset < buf_offset_ + buf_size_) {
+    n = std::min(n, static_cast<size_t>(buf_offset_ + buf_size_ - offset));
+    memcpy(scratch, buf_ + (offset - buf_offset_), n);
+    *result = Slice(scratch, n);
+  } else {
+    *result = Slice();
+  }
+  return s;
+}
+
 Status WholeFileBufferedRandomAccessFile::Load() {
   Status status;
   assert(base_ != NULL);
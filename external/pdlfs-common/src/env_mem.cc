@@ -0,0 +1,556 @@
+/*
+ * Copyright (c) 2011 The LevelDB Authors.
+ * Copyright (c) 2015-2018 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include "pdlfs-common/env_mem.h"
+#include "pdlfs-common/mutexlock.h"
+#include "pdlfs-common/port.h"
+
+#include <assert.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pdlfs {
+
+namespace {
+
+// Tracks the total amount of memory allocated for file data by a MemEnv.
+class MemUsage {
+ public:
+  explicit MemUsage(uint64_t capacity) : capacity_(capacity), used_(0) {}
+
+  // Return true and charge "n" bytes if the capacity is not exceeded.
+  bool Reserve(uint64_t n) {
+    MutexLock ml(&mu_);
+    if (capacity_ != 0 && used_ + n > capacity_) {
+      return false;
+    } else {
+      used_ += n;
+      return true;
+    }
+  }
+
+  void Release(uint64_t n) {
+    MutexLock ml(&mu_);
+    assert(used_ >= n);
+    used_ -= n;
+  }
+
+  uint64_t Used() {
+    MutexLock ml(&mu_);
+    return used_;
+  }
+
+ private:
+  port::Mutex mu_;
+  const uint64_t capacity_;
+  uint64_t used_;
+};
+
+// File data is stored in a list of fixed-sized blocks so that appends
+// never have to move previously written data.
+class FileState {
+ public:
+  explicit FileState(MemUsage* usage) : usage_(usage), refs_(0), size_(0) {}
+
+  void Ref() {
+    MutexLock ml(&mu_);
+    ++refs_;
+  }
+
+  void Unref() {
+    bool do_delete = false;
+    {
+      MutexLock ml(&mu_);
+      --refs_;
+      assert(refs_ >= 0);
+      if (refs_ <= 0) {
+        do_delete = true;
+      }
+    }
+
+    if (do_delete) {
+      delete this;
+    }
+  }
+
+  uint64_t Size() {
+    MutexLock ml(&mu_);
+    return size_;
+  }
+
+  Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) {
+    MutexLock ml(&mu_);
+    if (offset >= size_) {
+      *result = Slice();
+      return Status::OK();
+    }
+    const uint64_t available = size_ - offset;
+    if (n > available) {
+      n = static_cast<size_t>(available);
+    }
+    size_t block = static_cast<size_t>(offset / kBlockSize);
+    size_t block_offset = static_cast<size_t>(offset % kBlockSize);
+    char* dst = scratch;
+    size_t left = n;
+    while (left > 0) {
+      size_t avail = kBlockSize - block_offset;
+      size_t bytes_to_copy = left < avail ? left : avail;
+      memcpy(dst, blocks_[block] + block_offset, bytes_to_copy);
+      dst += bytes_to_copy;
+      left -= bytes_to_copy;
+      block_offset = 0;
+      block++;
+    }
+
+    *result = Slice(scratch, n);
+    return Status::OK();
+  }
+
+  Status Append(const Slice& data) {
+    const char* src = data.data();
+    size_t left = data.size();
+    MutexLock ml(&mu_);
+    // Whole blocks are charged against the capacity as they are allocated
+    const uint64_t num_blocks = (size_ + left + kBlockSize - 1) / kBlockSize;
+    if (num_blocks > blocks_.size()) {
+      const uint64_t n = num_blocks - blocks_.size();
+      if (!usage_->Reserve(n * kBlockSize)) {
+        return Status::BufferFull("Mem env capacity exceeded");
+      }
+    }
+    while (left > 0) {
+      size_t offset = static_cast<size_t>(size_ % kBlockSize);
+      if (offset == 0) {
+        blocks_.push_back(new char[kBlockSize]);
+      }
+      size_t avail = kBlockSize - offset;
+      size_t bytes_to_copy = left < avail ? left : avail;
+      memcpy(blocks_.back() + offset, src, bytes_to_copy);
+      src += bytes_to_copy;
+      left -= bytes_to_copy;
+      size_ += bytes_to_copy;
+    }
+
+    return Status::OK();
+  }
+
+ private:
+  enum { kBlockSize = 64 << 10 };
+
+  // Private since only Unref() should be used to delete it
+  ~FileState() {
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      delete[] blocks_[i];
+    }
+    usage_->Release(uint64_t(blocks_.size()) * kBlockSize);
+  }
+
+  // No copying allowed
+  FileState(const FileState&);
+  void operator=(const FileState&);
+
+  MemUsage* const usage_;
+  port::Mutex mu_;
+  int refs_;  // Protected by mu_
+
+  // The following fields are protected by mu_
+  std::vector<char*> blocks_;
+  uint64_t size_;
+};
+
+class MemSequentialFile : public SequentialFile {
+ public:
+  explicit MemSequentialFile(FileState* file) : file_(file), pos_(0) {
+    file_->Ref();
+  }
+
+  virtual ~MemSequentialFile() { file_->Unref(); }
+
+  virtual Status Read(size_t n, Slice* result, char* scratch) {
+    Status s = file_->Read(pos_, n, result, scratch);
+    if (s.ok()) {
+      pos_ += result->size();
+    }
+    return s;
+  }
+
+  virtual Status Skip(uint64_t n) {
+    const uint64_t size = file_->Size();
+    if (pos_ > size) {
+      return Status::IOError("pos_ > file_->Size()");
+    }
+    const uint64_t available = size - pos_;
+    if (n > available) {
+      n = available;
+    }
+    pos_ += n;
+    return Status::OK();
+  }
+
+ private:
+  FileState* file_;
+  uint64_t pos_;
+};
+
+class MemRandomAccessFile : public RandomAccessFile {
+ public:
+  explicit MemRandomAccessFile(FileState* file) : file_(file) { file_->Ref(); }
+
+  virtual ~MemRandomAccessFile() { file_->Unref(); }
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const {
+    return file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  FileState* file_;
+};
+
+class MemWritableFile : public WritableFile {
+ public:
+  explicit MemWritableFile(FileState* file) : file_(file) { file_->Ref(); }
+
+  virtual ~MemWritableFile() { file_->Unref(); }
+
+  virtual Status Append(const Slice& data) { return file_->Append(data); }
+  virtual Status Close() { return Status::OK(); }
+  virtual Status Flush() { return Status::OK(); }
+  virtual Status Sync() { return Status::OK(); }
+
+ private:
+  FileState* file_;
+};
+
+// Log messages are discarded since there is nowhere to persist them.
+class NoOpLogger : public Logger {
+ public:
+  virtual void Logv(const char* file, int line, int severity, int verbose,
+                    const char* format, va_list ap) {}
+};
+
+class MemFileLock : public FileLock {
+ public:
+  std::string name_;
+};
+
+// Strip trailing slashes so that "a/" and "a" name the same directory.
+static std::string DirName(const char* dir) {
+  std::string result = dir;
+  while (result.size() > 1 && result[result.size() - 1] == '/') {
+    result.resize(result.size() - 1);
+  }
+  return result;
+}
+
+// Return the directory holding the given file, or an empty string if the
+// file is named without a directory.
+static std::string ParentDir(const char* f) {
+  const std::string name = DirName(f);
+  const size_t pos = name.rfind('/');
+  if (pos == std::string::npos) {
+    return std::string();
+  } else if (pos == 0) {
+    return "/";
+  } else {
+    return name.substr(0, pos);
+  }
+}
+
+// Return the prefix shared by all entries inside the given directory.
+static std::string ChildPrefix(const std::string& dir) {
+  if (dir == "/") {
+    return dir;
+  } else {
+    return dir + "/";
+  }
+}
+
+class MemEnv : public EnvWrapper {
+ public:
+  MemEnv(Env* base, uint64_t capacity) : EnvWrapper(base), usage_(capacity) {}
+
+  virtual ~MemEnv() {
+    for (FileMap::iterator it = files_.begin(); it != files_.end(); ++it) {
+      it->second->Unref();
+    }
+  }
+
+  uint64_t Usage() { return usage_.Used(); }
+
+  virtual Status NewSequentialFile(const char* f, SequentialFile** r) {
+    MutexLock ml(&mu_);
+    FileMap::iterator it = files_.find(f);
+    if (it == files_.end()) {
+      *r = NULL;
+      return Status::NotFound(f);
+    } else {
+      *r = new MemSequentialFile(it->second);
+      return Status::OK();
+    }
+  }
+
+  virtual Status NewRandomAccessFile(const char* f, RandomAccessFile** r) {
+    MutexLock ml(&mu_);
+    FileMap::iterator it = files_.find(f);
+    if (it == files_.end()) {
+      *r = NULL;
+      return Status::NotFound(f);
+    } else {
+      *r = new MemRandomAccessFile(it->second);
+      return Status::OK();
+    }
+  }
+
+  virtual Status NewWritableFile(const char* f, WritableFile** r) {
+    const std::string parent = ParentDir(f);
+    MutexLock ml(&mu_);
+    // The root and the current directory always exist
+    if (!parent.empty() && parent != "/" && dirs_.count(parent) == 0) {
+      *r = NULL;
+      return Status::NotFound(f, "Parent directory not found");
+    }
+    FileState* file = new FileState(&usage_);
+    file->Ref();
+    FileMap::iterator it = files_.find(f);
+    if (it != files_.end()) {
+      it->second->Unref();  // Truncate any existing file
+      it->second = file;
+    } else {
+      files_.insert(std::make_pair(std::string(f), file));
+    }
+
+    *r = new MemWritableFile(file);
+    return Status::OK();
+  }
+
+  virtual Status NewDirectWritableFile(const char* f, WritableFile** r) {
+    return NewWritableFile(f, r);
+  }
+
+  virtual bool FileExists(const char* f) {
+    MutexLock ml(&mu_);
+    return files_.count(f) != 0 || dirs_.count(DirName(f)) != 0;
+  }
+
+  virtual Status GetChildren(const char* dir, std::vector<std::string>* r) {
+    r->clear();
+    const std::string prefix = ChildPrefix(DirName(dir));
+    MutexLock ml(&mu_);
+    bool found = dirs_.count(DirName(dir)) != 0;
+    for (FileMap::iterator it = files_.lower_bound(prefix); it != files_.end();
+         ++it) {
+      if (!Slice(it->first).starts_with(prefix)) break;
+      found = true;
+      std::string child = it->first.substr(prefix.size());
+      if (child.find('/') == std::string::npos) {
+        r->push_back(child);
+      }
+    }
+    for (DirSet::iterator it = dirs_.lower_bound(prefix); it != dirs_.end();
+         ++it) {
+      if (!Slice(*it).starts_with(prefix)) break;
+      std::string child = it->substr(prefix.size());
+      if (!child.empty() && child.find('/') == std::string::npos) {
+        r->push_back(child);
+      }
+    }
+
+    if (!found) {
+      return Status::NotFound(dir);
+    } else {
+      return Status::OK();
+    }
+  }
+
+  virtual Status DeleteFile(const char* f) {
+    MutexLock ml(&mu_);
+    FileMap::iterator it = files_.find(f);
+    if (it == files_.end()) {
+      return Status::NotFound(f);
+    } else {
+      it->second->Unref();
+      files_.erase(it);
+      return Status::OK();
+    }
+  }
+
+  virtual Status CreateDir(const char* dir) {
+    MutexLock ml(&mu_);
+    if (!dirs_.insert(DirName(dir)).second) {
+      return Status::AlreadyExists(dir);
+    } else {
+      return Status::OK();
+    }
+  }
+
+  virtual Status AttachDir(const char* dir) {
+    MutexLock ml(&mu_);
+    if (dirs_.count(DirName(dir)) == 0) {
+      return Status::NotFound(dir);
+    } else {
+      return Status::OK();
+    }
+  }
+
+  virtual Status DeleteDir(const char* dir) {
+    const std::string name = DirName(dir);
+    const std::string prefix = ChildPrefix(name);
+    MutexLock ml(&mu_);
+    DirSet::iterator it = dirs_.find(name);
+    if (it == dirs_.end()) {
+      return Status::NotFound(dir);
+    }
+    FileMap::iterator f = files_.lower_bound(prefix);
+    DirSet::iterator d = dirs_.lower_bound(prefix);
+    if ((f != files_.end() && Slice(f->first).starts_with(prefix)) ||
+        (d != dirs_.end() && Slice(*d).starts_with(prefix))) {
+      return Status::IOError(dir, "Directory not empty");
+    } else {
+      dirs_.erase(it);
+      return Status::OK();
+    }
+  }
+
+  virtual Status DetachDir(const char* dir) {
+    return Status::NotSupported(Slice());
+  }
+
+  virtual Status GetFileSize(const char* f, uint64_t* file_size) {
+    MutexLock ml(&mu_);
+    FileMap::iterator it = files_.find(f);
+    if (it == files_.end()) {
+      *file_size = 0;
+      return Status::NotFound(f);
+    } else {
+      *file_size = it->second->Size();
+      return Status::OK();
+    }
+  }
+
+  virtual Status CopyFile(const char* src, const char* dst) {
+    SequentialFile* in;
+    Status s = NewSequentialFile(src, &in);
+    if (!s.ok()) {
+      return s;
+    }
+    WritableFile* out;
+    s = NewWritableFile(dst, &out);
+    if (s.ok()) {
+      char* space = new char[kCopyBufferSize];
+      Slice fragment;
+      while (s.ok()) {
+        s = in->Read(kCopyBufferSize, &fragment, space);
+        if (s.ok()) {
+          if (fragment.empty()) {
+            break;
+          } else {
+            s = out->Append(fragment);
+          }
+        }
+      }
+      delete[] space;
+      delete out;
+    }
+
+    delete in;
+    return s;
+  }
+
+  virtual Status RenameFile(const char* src, const char* dst) {
+    MutexLock ml(&mu_);
+    FileMap::iterator it = files_.find(src);
+    if (it == files_.end()) {
+      return Status::NotFound(src);
+    }
+    FileState* file = it->second;
+    files_.erase(it);
+    it = files_.find(dst);
+    if (it != files_.end()) {
+      it->second->Unref();
+      it->second = file;
+    } else {
+      files_.insert(std::make_pair(std::string(dst), file));
+    }
+    return Status::OK();
+  }
+
+  virtual Status LockFile(const char* fname, FileLock** lock) {
+    *lock = NULL;
+    MutexLock ml(&mu_);
+    if (!locks_.insert(fname).second) {
+      return Status::IOError(fname, "Lock already held by process");
+    }
+    if (files_.count(fname) == 0) {
+      FileState* file = new FileState(&usage_);
+      file->Ref();
+      files_.insert(std::make_pair(std::string(fname), file));
+    }
+    MemFileLock* my_lock = new MemFileLock;
+    my_lock->name_ = fname;
+    *lock = my_lock;
+    return Status::OK();
+  }
+
+  virtual Status UnlockFile(FileLock* lock) {
+    MemFileLock* my_lock = reinterpret_cast<MemFileLock*>(lock);
+    MutexLock ml(&mu_);
+    locks_.erase(my_lock->name_);
+    delete my_lock;
+    return Status::OK();
+  }
+
+  virtual Status GetTestDirectory(std::string* path) {
+    *path = "/test";
+    // Ignore error since directory may exist
+    CreateDir(path->c_str());
+    return Status::OK();
+  }
+
+  virtual Status NewLogger(const char* fname, Logger** result) {
+    *result = new NoOpLogger;
+    return Status::OK();
+  }
+
+ private:
+  enum { kCopyBufferSize = 64 << 10 };
+
+  typedef std::map<std::string, FileState*> FileMap;
+  typedef std::set<std::string> DirSet;
+
+  MemUsage usage_;
+  port::Mutex mu_;
+  // The following fields are protected by mu_
+  FileMap files_;
+  DirSet dirs_;
+  std::set<std::string> locks_;
+};
+
+}  // namespace
+
+Env* NewMemEnv(Env* base, uint64_t capacity) {
+  return new MemEnv(base, capacity);
+}
+
+Status MemEnvUsage(Env* env, uint64_t* usage) {
+  MemEnv* const mem_env = dynamic_cast<MemEnv*>(env);
+  if (mem_env == NULL) {
+    *usage = 0;
+    return Status::InvalidArgument("Not a mem env");
+  } else {
+    *usage = mem_env->Usage();
+    return Status::OK();
+  }
+}
+
+}  // namespace pdlfs
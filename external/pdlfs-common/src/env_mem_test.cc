@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2011 The LevelDB Authors.
+ * Copyright (c) 2015-2018 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include "pdlfs-common/env_mem.h"
+#include "pdlfs-common/leveldb/db/db.h"
+#include "pdlfs-common/leveldb/db/options.h"
+#include "pdlfs-common/testharness.h"
+#include "pdlfs-common/testutil.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace pdlfs {
+
+class MemEnvTest {
+ public:
+  MemEnvTest() : env_(NewMemEnv(Env::Default())) {}
+  ~MemEnvTest() { delete env_; }
+
+  Env* env_;
+};
+
+TEST(MemEnvTest, Basics) {
+  uint64_t file_size;
+  WritableFile* writable_file;
+  std::vector<std::string> children;
+
+  ASSERT_OK(env_->CreateDir("/dir"));
+  ASSERT_TRUE(env_->CreateDir("/dir").IsAlreadyExists());
+  ASSERT_OK(env_->AttachDir("/dir/"));
+
+  // Check that the directory is empty.
+  ASSERT_TRUE(!env_->FileExists("/dir/non_existent"));
+  ASSERT_TRUE(!env_->GetFileSize("/dir/non_existent", &file_size).ok());
+  ASSERT_OK(env_->GetChildren("/dir", &children));
+  ASSERT_EQ(0, children.size());
+
+  // Create a file.
+  ASSERT_OK(env_->NewWritableFile("/dir/f", &writable_file));
+  delete writable_file;
+
+  // Check that the file exists.
+  ASSERT_TRUE(env_->FileExists("/dir/f"));
+  ASSERT_OK(env_->GetFileSize("/dir/f", &file_size));
+  ASSERT_EQ(0, file_size);
+  ASSERT_OK(env_->GetChildren("/dir", &children));
+  ASSERT_EQ(1, children.size());
+  ASSERT_EQ("f", children[0]);
+
+  // Write to the file.
+  ASSERT_OK(env_->NewWritableFile("/dir/f", &writable_file));
+  ASSERT_OK(writable_file->Append("abc"));
+  delete writable_file;
+
+  // Check for expected size.
+  ASSERT_OK(env_->GetFileSize("/dir/f", &file_size));
+  ASSERT_EQ(3, file_size);
+  uint64_t usage;
+  ASSERT_OK(MemEnvUsage(env_, &usage));
+  ASSERT_EQ(64 << 10, usage);  // Charged by the block
+
+  // Check that renaming works.
+  ASSERT_TRUE(!env_->RenameFile("/dir/non_existent", "/dir/g").ok());
+  ASSERT_OK(env_->RenameFile("/dir/f", "/dir/g"));
+  ASSERT_TRUE(!env_->FileExists("/dir/f"));
+  ASSERT_TRUE(env_->FileExists("/dir/g"));
+  ASSERT_OK(env_->GetFileSize("/dir/g", &file_size));
+  ASSERT_EQ(3, file_size);
+
+  // Check that opening non-existent file fails.
+  SequentialFile* seq_file;
+  RandomAccessFile* rand_file;
+  ASSERT_TRUE(!env_->NewSequentialFile("/dir/non_existent", &seq_file).ok());
+  ASSERT_TRUE(!seq_file);
+  ASSERT_TRUE(!env_->NewRandomAccessFile("/dir/non_existent", &rand_file).ok());
+  ASSERT_TRUE(!rand_file);
+
+  // Check that a non-empty directory cannot be deleted.
+  ASSERT_TRUE(!env_->DeleteDir("/dir").ok());
+
+  // Check that deleting works.
+  ASSERT_TRUE(!env_->DeleteFile("/dir/non_existent").ok());
+  ASSERT_OK(env_->DeleteFile("/dir/g"));
+  ASSERT_TRUE(!env_->FileExists("/dir/g"));
+  ASSERT_OK(MemEnvUsage(env_, &usage));
+  ASSERT_EQ(0, usage);
+  ASSERT_OK(env_->GetChildren("/dir", &children));
+  ASSERT_EQ(0, children.size());
+  ASSERT_OK(env_->DeleteDir("/dir"));
+  ASSERT_TRUE(!env_->FileExists("/dir"));
+}
+
+TEST(MemEnvTest, ReadWrite) {
+  WritableFile* writable_file;
+  SequentialFile* seq_file;
+  RandomAccessFile* rand_file;
+  Slice result;
+  char scratch[100];
+
+  ASSERT_OK(env_->CreateDir("/dir"));
+  ASSERT_OK(env_->NewWritableFile("/dir/f", &writable_file));
+  ASSERT_OK(writable_file->Append("hello "));
+  ASSERT_OK(writable_file->Append("world"));
+  delete writable_file;
+
+  // Read sequentially.
+  ASSERT_OK(env_->NewSequentialFile("/dir/f", &seq_file));
+  ASSERT_OK(seq_file->Read(5, &result, scratch));  // Read "hello".
+  ASSERT_EQ(0, result.compare("hello"));
+  ASSERT_OK(seq_file->Skip(1));
+  ASSERT_OK(seq_file->Read(1000, &result, scratch));  // Read "world".
+  ASSERT_EQ(0, result.compare("world"));
+  ASSERT_OK(seq_file->Read(1000, &result, scratch));  // Try reading past EOF.
+  ASSERT_EQ(0, result.size());
+  ASSERT_OK(seq_file->Skip(100));  // Try to skip past end of file.
+  ASSERT_OK(seq_file->Read(1000, &result, scratch));
+  ASSERT_EQ(0, result.size());
+  delete seq_file;
+
+  // Random reads.
+  ASSERT_OK(env_->NewRandomAccessFile("/dir/f", &rand_file));
+  ASSERT_OK(rand_file->Read(6, 5, &result, scratch));  // Read "world".
+  ASSERT_EQ(0, result.compare("world"));
+  ASSERT_OK(rand_file->Read(0, 5, &result, scratch));  // Read "hello".
+  ASSERT_EQ(0, result.compare("hello"));
+  ASSERT_OK(rand_file->Read(10, 100, &result, scratch));  // Read "d".
+  ASSERT_EQ(0, result.compare("d"));
+  ASSERT_OK(rand_file->Read(1000, 5, &result, scratch));  // Read past EOF.
+  ASSERT_EQ(0, result.size());
+  delete rand_file;
+}
+
+TEST(MemEnvTest, LargeWrite) {
+  const size_t kWriteSize = 300 * 1024;
+  char* scratch = new char[kWriteSize * 2];
+
+  std::string write_data;
+  for (size_t i = 0; i < kWriteSize; ++i) {
+    write_data.append(1, static_cast<char>(i));
+  }
+
+  WritableFile* writable_file;
+  ASSERT_OK(env_->CreateDir("/dir"));
+  ASSERT_OK(env_->NewWritableFile("/dir/f", &writable_file));
+  ASSERT_OK(writable_file->Append("foo"));
+  ASSERT_OK(writable_file->Append(write_data));
+  delete writable_file;
+
+  SequentialFile* seq_file;
+  Slice result;
+  ASSERT_OK(env_->NewSequentialFile("/dir/f", &seq_file));
+  ASSERT_OK(seq_file->Read(3, &result, scratch));  // Read "foo".
+  ASSERT_EQ(0, result.compare("foo"));
+
+  size_t read = 0;
+  std::string read_data;
+  while (read < kWriteSize) {
+    ASSERT_OK(seq_file->Read(kWriteSize - read, &result, scratch));
+    read_data.append(result.data(), result.size());
+    read += result.size();
+  }
+  ASSERT_TRUE(write_data == read_data);
+  delete seq_file;
+
+  ASSERT_OK(env_->CopyFile("/dir/f", "/dir/g"));
+  std::string copy;
+  ASSERT_OK(ReadFileToString(env_, "/dir/g", &copy));
+  ASSERT_EQ(copy, "foo" + write_data);
+  delete[] scratch;
+}
+
+TEST(MemEnvTest, Capacity) {
+  const size_t kBlockSize = 64 << 10;
+  Env* env = NewMemEnv(Env::Default(), 2 * kBlockSize + 10);
+  WritableFile* writable_file;
+  ASSERT_OK(env->NewWritableFile("/f", &writable_file));
+  ASSERT_OK(writable_file->Append(std::string(kBlockSize + 1, 'a')));
+  ASSERT_OK(writable_file->Append(std::string(kBlockSize - 1, 'b')));
+  // A third block would go beyond the capacity.
+  ASSERT_TRUE(writable_file->Append("c").IsBufferFull());
+  delete writable_file;
+  uint64_t usage;
+  ASSERT_OK(MemEnvUsage(env, &usage));
+  ASSERT_EQ(2 * kBlockSize, usage);
+  // Truncating the file gives the space back.
+  ASSERT_OK(env->NewWritableFile("/f", &writable_file));
+  ASSERT_OK(writable_file->Append("abc"));
+  delete writable_file;
+  ASSERT_OK(MemEnvUsage(env, &usage));
+  ASSERT_EQ(kBlockSize, usage);
+  delete env;
+}
+
+TEST(MemEnvTest, MissingParentDir) {
+  WritableFile* writable_file;
+  ASSERT_TRUE(env_->NewWritableFile("/a/f", &writable_file).IsNotFound());
+  ASSERT_TRUE(writable_file == NULL);
+  ASSERT_OK(env_->CreateDir("/a"));
+  ASSERT_OK(env_->NewWritableFile("/a/f", &writable_file));
+  delete writable_file;
+}
+
+TEST(MemEnvTest, UsageOfOtherEnvs) {
+  uint64_t usage;
+  ASSERT_TRUE(MemEnvUsage(Env::Default(), &usage).IsInvalidArgument());
+}
+
+TEST(MemEnvTest, Locks) {
+  FileLock* lock;
+  FileLock* lock2;
+  ASSERT_OK(env_->LockFile("/LOCK", &lock));
+  ASSERT_TRUE(!env_->LockFile("/LOCK", &lock2).ok());
+  ASSERT_OK(env_->UnlockFile(lock));
+  ASSERT_OK(env_->LockFile("/LOCK", &lock));
+  ASSERT_OK(env_->UnlockFile(lock));
+}
+
+TEST(MemEnvTest, DBTest) {
+  DBOptions options;
+  options.create_if_missing = true;
+  options.env = env_;
+  DB* db;
+
+  const Slice keys[] = {Slice("aaa"), Slice("bbb"), Slice("ccc")};
+  const Slice vals[] = {Slice("foo"), Slice("bar"), Slice("baz")};
+
+  ASSERT_OK(DB::Open(options, "/dir/db", &db));
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_OK(db->Put(WriteOptions(), keys[i], vals[i]));
+  }
+
+  for (size_t i = 0; i < 3; ++i) {
+    std::string res;
+    ASSERT_OK(db->Get(ReadOptions(), keys[i], &res));
+    ASSERT_TRUE(res == vals[i]);
+  }
+
+  ASSERT_OK(db->FlushMemTable(FlushOptions()));
+  for (size_t i = 0; i < 3; ++i) {
+    std::string res;
+    ASSERT_OK(db->Get(ReadOptions(), keys[i], &res));
+    ASSERT_TRUE(res == vals[i]);
+  }
+
+  delete db;
+}
+
+}  // namespace pdlfs
+
+int main(int argc, char** argv) {
+  return ::pdlfs::test::RunAllTests(&argc, &argv);
+}
@@ -9,8 +9,13 @@
  */
 
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/env_files.h"
 #include "pdlfs-common/port.h"
+#include "pdlfs-common/random.h"
 #include "pdlfs-common/testharness.h"
+#include "pdlfs-common/testutil.h"
+
+#include <stdlib.h>
 
 namespace pdlfs {
 
@@ -102,6 +107,102 @@ TEST(EnvPosixTest, StartThread) {
   ASSERT_EQ(state.val, 3);
 }
 
+TEST(EnvPosixTest, DirectWritableFile) {
+  std::string fname = test::TmpDir() + "/direct_writable_file";
+  Random rnd(301);
+  std::string data;
+  WritableFile* file;
+  ASSERT_OK(env_->NewDirectWritableFile(fname.c_str(), &file));
+  for (int i = 0; i < 100; i++) {
+    std::string tmp;
+    test::RandomString(&rnd, rnd.Uniform(50000), &tmp);
+    ASSERT_OK(file->Append(tmp));
+    data += tmp;
+    if (i % 10 == 0) {
+      ASSERT_OK(file->Sync());
+      uint64_t size;
+      ASSERT_OK(env_->GetFileSize(fname.c_str(), &size));
+      ASSERT_EQ(size, data.size());
+    }
+  }
+  ASSERT_OK(file->Close());
+  delete file;
+  std::string result;
+  ASSERT_OK(ReadFileToString(env_, fname.c_str(), &result));
+  ASSERT_TRUE(result == data);
+  env_->DeleteFile(fname.c_str());
+}
+
+// The buffered tail is written out even if the file is never closed
+TEST(EnvPosixTest, DirectWritableFileWithoutClose) {
+  std::string fname = test::TmpDir() + "/direct_writable_file";
+  WritableFile* file;
+  ASSERT_OK(env_->NewDirectWritableFile(fname.c_str(), &file));
+  ASSERT_OK(file->Append("abc"));
+  delete file;
+  std::string result;
+  ASSERT_OK(ReadFileToString(env_, fname.c_str(), &result));
+  ASSERT_TRUE(result == "abc");
+  env_->DeleteFile(fname.c_str());
+}
+
+TEST(EnvPosixTest, ReadaheadRandomAccessFile) {
+  std::string fname = test::TmpDir() + "/readahead_file";
+  Random rnd(301);
+  std::string data;
+  test::RandomString(&rnd, 100000, &data);
+  ASSERT_OK(WriteStringToFile(env_, data, fname.c_str()));
+  RandomAccessFile* base;
+  ASSERT_OK(env_->NewRandomAccessFile(fname.c_str(), &base));
+  ReadaheadRandomAccessFile file(base, data.size(), 4096);
+  char scratch[5000];
+  for (int i = 0; i < 1000; i++) {
+    const uint64_t off = rnd.Uniform(data.size() + 100);
+    const size_t n = rnd.Uniform(sizeof(scratch));
+    Slice result;
+    ASSERT_OK(file.Read(off, n, &result, scratch));
+    const std::string expected =
+        off < data.size() ? data.substr(off, n) : std::string();
+    ASSERT_EQ(result.ToString(), expected);
+  }
+  env_->DeleteFile(fname.c_str());
+}
+
+TEST(EnvPosixTest, DirectRandomAccessFile) {
+  std::string fname = test::TmpDir() + "/direct_random_access_file";
+  Random rnd(301);
+  std::string data;
+  test::RandomString(&rnd, 100000, &data);
+  ASSERT_OK(WriteStringToFile(env_, data, fname.c_str()));
+  RandomAccessFile* file;
+  ASSERT_OK(env_->NewDirectRandomAccessFile(fname.c_str(), &file));
+  void* ptr = NULL;
+  const int r = posix_memalign(&ptr, 4096, 3 * 4096);
+  ASSERT_EQ(r, 0);
+  ASSERT_TRUE(ptr != NULL);
+  char* const scratch = static_cast<char*>(ptr);
+  Slice result;
+  // Aligned reads, including one that runs past the end of the file
+  for (uint64_t off = 0; off < data.size() + 4096; off += 3 * 4096) {
+    ASSERT_OK(file->Read(off, 3 * 4096, &result, scratch));
+    const std::string expected =
+        off < data.size() ? data.substr(off, 3 * 4096) : std::string();
+    ASSERT_EQ(result.ToString(), expected);
+  }
+  // Unaligned reads
+  for (int i = 0; i < 1000; i++) {
+    const uint64_t off = rnd.Uniform(data.size() + 100);
+    const size_t n = rnd.Uniform(3 * 4096);
+    ASSERT_OK(file->Read(off, n, &result, scratch + 1));
+    const std::string expected =
+        off < data.size() ? data.substr(off, n) : std::string();
+    ASSERT_EQ(result.ToString(), expected);
+  }
+  free(ptr);
+  delete file;
+  env_->DeleteFile(fname.c_str());
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char** argv) {
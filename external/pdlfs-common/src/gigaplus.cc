@@ -11,6 +11,7 @@
 #include <math.h>
 #include <string.h>
 #include <algorithm>
+#include <vector>
 
 #include "pdlfs-common/coding.h"
 #include "pdlfs-common/gigaplus.h"
@@ -24,6 +25,9 @@ DirIndexOptions::DirIndexOptions() : paranoid_checks(false) {}
 static const int kMaxRadix = 16;
 // Max number of partitions.
 static const size_t kMaxPartitions = 1 << kMaxRadix;
+// Largest radix for which we keep a precomputed routing table.
+// A table at this radix costs 8KB of memory.
+static const int kMaxRoutingRadix = 12;
 
 // -------------------------------------------------------------
 // Internal Helper Methods
@@ -321,6 +325,44 @@ struct DirIndex::Rep {
     assert(radix() == ToRadix(HighestBit()));
   }
 
+  // Recompute the routing table from the current bitmap. Must be
+  // called after each round of bitmap changes. The i-th entry of the table
+  // stores the partition responsible for hash prefixes whose first
+  // radix() bits map to i. Parents always precede their children so each
+  // entry can be derived from its parent in one step. No table is kept
+  // for large radices, in which case routing falls back to walking the
+  // bitmap.
+  void RebuildRoutes() {
+    const int r = radix();
+    if (r > kMaxRoutingRadix) {
+      std::vector<uint16_t> empty;
+      routes_.swap(empty);
+    } else {
+      const size_t n = static_cast<size_t>(1) << r;
+      routes_.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        if (bit(i)) {
+          routes_[i] = static_cast<uint16_t>(i);
+        } else {
+          routes_[i] = routes_[ToParentIndex(static_cast<int>(i))];
+        }
+      }
+    }
+  }
+
+  // Return the partition responsible for a given hash prefix.
+  int Route(int i) const {
+    if (!routes_.empty()) {
+      assert(static_cast<size_t>(i) < routes_.size());
+      return routes_[i];
+    } else {
+      while (!bit(i)) {
+        i = ToParentIndex(i);
+      }
+      return i;
+    }
+  }
+
   uint16_t zeroth_server() const { return DecodeFixed16(rep_); }
   uint16_t radix() const { return DecodeFixed16(rep_ + 2); }
 
@@ -330,6 +372,7 @@ struct DirIndex::Rep {
   char* rep_;
   char* bitmap_;
   size_t bitmap_capacity_;
+  std::vector<uint16_t> routes_;
 
   // Avoid allocating space for small indices.
   char static_buf_[kHeadSize + kInitBitmapCapacity];
@@ -385,6 +428,7 @@ DirIndex::Rep::Rep(uint16_t zeroth_server) {
   SetZerothServer(zeroth_server);
   SetRadix(0);
   TurnOnBit(0);
+  RebuildRoutes();
 }
 
 bool DirIndex::IsSet(int index) const {
@@ -429,6 +473,7 @@ bool DirIndex::Update(const Slice& other) {
       return false;
     } else {
       rep_->Merge(view);
+      rep_->RebuildRoutes();
       return true;
     }
   }
@@ -445,6 +490,7 @@ void DirIndex::Update(const DirIndex& other) {
   } else {
     rep_->Merge(other_rep);
   }
+  rep_->RebuildRoutes();
 }
 
 // Reset index states.
@@ -456,6 +502,7 @@ bool DirIndex::TEST_Reset(const Slice& other) {
   } else {
     Rep* new_rep = new Rep(view.zeroth_server());
     new_rep->Merge(view);
+    new_rep->RebuildRoutes();
     delete rep_;
     rep_ = new_rep;
     return true;
@@ -466,6 +513,7 @@ void DirIndex::Set(int index) {
   assert(rep_ != NULL);
   assert(index >= 0 && index < options_->num_virtual_servers);
   rep_->TurnOnBit(index);
+  rep_->RebuildRoutes();
 }
 
 void DirIndex::SetAll() {
@@ -474,12 +522,14 @@ void DirIndex::SetAll() {
   for (int i = 0; i < options_->num_virtual_servers; ++i) {
     rep_->TurnOnBit(i);
   }
+  rep_->RebuildRoutes();
 }
 
 void DirIndex::TEST_Unset(int index) {
   assert(rep_ != NULL);
   assert(index > 0 && index < options_->num_virtual_servers);
   rep_->TurnOffBit(index);
+  rep_->RebuildRoutes();
 }
 
 void DirIndex::TEST_RevertAll() {
@@ -487,6 +537,7 @@ void DirIndex::TEST_RevertAll() {
   for (int i = rep_->HighestBit(); i > 0; --i) {
     rep_->TurnOffBit(i);
   }
+  rep_->RebuildRoutes();
 }
 
 // Return true if the partition marked by the specified index
@@ -546,10 +597,37 @@ int DirIndex::HashToIndex(const Slice& hash) const {
   assert(rep_->bit(0));
   int i = ComputeIndexFromHash(hash.data(), rep_->radix());
   assert(i < options_->num_virtual_servers);
-  while (!rep_->bit(i)) {
-    i = ToParentIndex(i);
+  return rep_->Route(i);
+}
+
+// Determine the partitions responsible for a batch of names. All names are
+// hashed first so that the hashing loop stays tight and free of
+// bitmap accesses.
+void DirIndex::GetIndices(const Slice* names, size_t n, int* indices) const {
+  assert(rep_ != NULL);
+  char tmp[8 * 64];
+  const int r = rep_->radix();
+  while (n != 0) {
+    const size_t batch = std::min(n, sizeof(tmp) / 8);
+    HashBatch(names, batch, tmp);
+    for (size_t j = 0; j < batch; j++) {
+      int i = ComputeIndexFromHash(tmp + 8 * j, r);
+      assert(i < options_->num_virtual_servers);
+      indices[j] = rep_->Route(i);
+    }
+    names += batch;
+    indices += batch;
+    n -= batch;
+  }
+}
+
+// Pickup servers to take care of a batch of names.
+void DirIndex::SelectServers(const Slice* names, size_t n,
+                             int* servers) const {
+  GetIndices(names, n, servers);
+  for (size_t j = 0; j < n; j++) {
+    servers[j] = GetServerForIndex(servers[j]);
   }
-  return i;
 }
 
 // Pickup a server to take care of the given name.
@@ -583,6 +661,13 @@ Slice DirIndex::Hash(const Slice& name, char* scratch) {
   return Slice(scratch, 8);
 }
 
+// Calculate the hashes for a batch of strings.
+void DirIndex::HashBatch(const Slice* names, size_t n, char* scratch) {
+  for (size_t i = 0; i < n; i++) {
+    GIGAHash(names[i], scratch + 8 * i);
+  }
+}
+
 // Return the server responsible for a specific partition.
 int DirIndex::GetServerForIndex(int index) const {
   assert(rep_ != NULL);
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <iostream>
 #include <set>
+#include <vector>
 
 #include "pdlfs-common/gigaplus.h"
 #include "pdlfs-common/testharness.h"
@@ -390,6 +391,27 @@ TEST(DirIndexTest, SelectServer4) {
   Print(info, kNumServers);
 }
 
+TEST(DirIndexTest, BatchSelectServers) {
+  const int n = 1000;
+  std::vector<std::string> files;
+  for (int i = 0; i < n; i++) files.push_back(File(i));
+  std::vector<Slice> names(files.begin(), files.end());
+  std::vector<int> servers(n);
+  std::vector<int> indices(n);
+  // Cover both table-based and bitmap-based routing
+  for (int i = 0; i < kNumServers; i++) {
+    idx_->Set(i);
+    if (i % 1001 == 0 || i == kNumServers - 1) {
+      idx_->GetIndices(&names[0], n, &indices[0]);
+      idx_->SelectServers(&names[0], n, &servers[0]);
+      for (int j = 0; j < n; j++) {
+        ASSERT_EQ(indices[j], idx_->GetIndex(names[j]));
+        ASSERT_EQ(servers[j], idx_->SelectServer(names[j]));
+      }
+    }
+  }
+}
+
 TEST(DirIndexTest, Migration1) {
   int index = 0;
   int moved = 0;
@@ -99,4 +99,24 @@ void IndexCache::Erase(const DirId& id) {
   }
 }
 
+void IndexCache::EnableSimulation() {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.EnableSimulation();
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
+void IndexCache::GetStats(LRUCacheStats* stats) {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.GetStats(stats);
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
 }  // namespace pdlfs
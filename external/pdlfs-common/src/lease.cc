@@ -135,4 +135,24 @@ void LeaseTable::Erase(const DirId& pid, const Slice& nhash) {
   }
 }
 
+void LeaseTable::EnableSimulation() {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.EnableSimulation();
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
+void LeaseTable::GetStats(LRUCacheStats* stats) {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.GetStats(stats);
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
 }  // namespace pdlfs
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2015-2017 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "pdlfs-common/env.h"
+#include "pdlfs-common/lease.h"
+#include "pdlfs-common/mutexlock.h"
+#include "pdlfs-common/testharness.h"
+
+namespace pdlfs {
+
+class LeaseTest {
+ public:
+  LeaseTest() : parent_(&mu_, &giga_) {
+    parent_.num_leases = 0;
+    parent_.locked = false;
+    parent_.tx.NoBarrier_Store(NULL);
+    options_.max_lease_duration = 1000;
+  }
+
+  static std::string NameHash(int i) {
+    char tmp[20];
+    snprintf(tmp, sizeof(tmp), "h%d", i);
+    return tmp;
+  }
+
+  // Create a new lease under a given parent directory. The lease starts
+  // free so it may be evicted once released.
+  static Lease* NewLease(const Dir* parent) {
+    Lease* lease = new Lease;
+    lease->parent = parent;
+    lease->due = 0;
+    lease->state = kLeaseFree;
+    lease->seq = 0;
+    parent->num_leases++;
+    return lease;
+  }
+
+  port::Mutex mu_;
+  DirIndexOptions giga_;
+  Dir parent_;
+  LeaseOptions options_;
+};
+
+TEST(LeaseTest, InsertLookupErase) {
+  LeaseTable table(options_);
+  DirId pid(0, 0, 1);
+  for (int i = 0; i < 100; i++) {
+    Lease::Ref* r = table.Insert(pid, NameHash(i), NewLease(&parent_));
+    table.Release(r);
+  }
+  ASSERT_EQ(parent_.num_leases, 100);
+  for (int i = 0; i < 100; i++) {
+    Lease::Ref* r = table.Lookup(pid, NameHash(i));
+    ASSERT_TRUE(r != NULL);
+    ASSERT_TRUE(r->value->parent == &parent_);
+    table.Release(r);
+  }
+  for (int i = 0; i < 100; i++) {
+    table.Erase(pid, NameHash(i));
+    ASSERT_TRUE(table.Lookup(pid, NameHash(i)) == NULL);
+  }
+  ASSERT_EQ(parent_.num_leases, 0);
+  LRUCacheStats stats;
+  table.GetStats(&stats);
+  ASSERT_EQ(stats.hits, 100);
+  ASSERT_EQ(stats.misses, 100);
+}
+
+TEST(LeaseTest, DuplicateInsert) {
+  LeaseTable table(options_);
+  DirId pid(0, 0, 1);
+  Lease::Ref* r = table.Insert(pid, NameHash(1), NewLease(&parent_));
+  Lease* dup = NewLease(&parent_);
+  int err = 0;
+  try {
+    table.Insert(pid, NameHash(1), dup);
+  } catch (int e) {
+    err = e;
+  }
+  ASSERT_EQ(err, EEXIST);
+  parent_.num_leases--;
+  delete dup;
+  table.Release(r);
+  table.Erase(pid, NameHash(1));
+}
+
+TEST(LeaseTest, Eviction) {
+  options_.max_num_leases = 64;
+  LeaseTable table(options_);
+  DirId pid(0, 0, 1);
+  for (int i = 0; i < 1000; i++) {
+    Lease::Ref* r = table.Insert(pid, NameHash(i), NewLease(&parent_));
+    table.Release(r);
+  }
+  // The table holds at most 64 free leases
+  ASSERT_LE(parent_.num_leases, 64);
+  for (int i = 0; i < 1000; i++) {
+    table.Erase(pid, NameHash(i));
+  }
+  ASSERT_EQ(parent_.num_leases, 0);
+}
+
+namespace {
+struct ThreadState {
+  LeaseTable* table;
+  Dir* parent;
+  int id;
+  port::Mutex* mu;
+  port::CondVar* cv;
+  int* num_running;
+};
+}  // namespace
+
+static void Worker(void* arg) {
+  ThreadState* state = reinterpret_cast<ThreadState*>(arg);
+  DirId pid(0, 0, state->id);
+  for (int i = 0; i < 500; i++) {
+    const std::string h = LeaseTest::NameHash(i);
+    Lease::Ref* r =
+        state->table->Insert(pid, h, LeaseTest::NewLease(state->parent));
+    state->table->Release(r);
+    r = state->table->Lookup(pid, h);
+    ASSERT_TRUE(r != NULL);
+    ASSERT_TRUE(r->value->parent == state->parent);
+    state->table->Release(r);
+    state->table->Erase(pid, h);
+  }
+  MutexLock ml(state->mu);
+  (*state->num_running)--;
+  state->cv->SignalAll();
+}
+
+// Threads share a table that is protected by its own mutex.
+TEST(LeaseTest, ThreadSafe) {
+  port::Mutex table_mu;
+  LeaseTable table(options_, &table_mu);
+  const int kThreads = 4;
+  port::Mutex mu;
+  port::CondVar cv(&mu);
+  int num_running = kThreads;
+  std::vector<Dir*> parents;
+  ThreadState states[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    // Leases of different threads have different parents so that
+    // parent lease counts are never shared across threads
+    Dir* parent = new Dir(&mu_, &giga_);
+    parent->num_leases = 0;
+    parent->locked = false;
+    parent->tx.NoBarrier_Store(NULL);
+    parents.push_back(parent);
+    states[i].table = &table;
+    states[i].parent = parent;
+    states[i].id = i + 1;
+    states[i].mu = &mu;
+    states[i].cv = &cv;
+    states[i].num_running = &num_running;
+    Env::Default()->StartThread(Worker, &states[i]);
+  }
+  mu.Lock();
+  while (num_running != 0) {
+    cv.Wait();
+  }
+  mu.Unlock();
+  LRUCacheStats stats;
+  table.GetStats(&stats);
+  ASSERT_EQ(stats.hits, kThreads * 500);
+  for (int i = 0; i < kThreads; i++) {
+    ASSERT_EQ(parents[i]->num_leases, 0);
+    delete parents[i];
+  }
+}
+
+}  // namespace pdlfs
+
+int main(int argc, char** argv) {
+  return ::pdlfs::test::RunAllTests(&argc, &argv);
+}
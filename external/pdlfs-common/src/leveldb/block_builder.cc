@@ -109,6 +109,10 @@ Slice AbstractBlockBuilder::Finish(CompressionType compression, bool force) {
         compressed.clear();
       }
       break;
+    default:
+      // Other codecs are only supported by Tables
+      compression = kNoCompression;
+      break;
   }
 
   if (!compressed.empty()) {
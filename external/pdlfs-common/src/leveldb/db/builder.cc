@@ -23,7 +23,7 @@ namespace pdlfs {
 Status BuildTable(const std::string& dbname, Env* env, const DBOptions& options,
                   TableCache* table_cache, Iterator* iter,
                   SequenceNumber* min_seq, SequenceNumber* max_seq,
-                  FileMetaData* meta) {
+                  FileMetaData* meta, const Slice& compression_dict) {
   Status s;
   assert(meta->number != 0);
   meta->file_size = 0;
@@ -39,6 +39,9 @@ Status BuildTable(const std::string& dbname, Env* env, const DBOptions& options,
     }
 
     TableBuilder* builder = new TableBuilder(options, file);
+    if (!compression_dict.empty()) {
+      builder->SetCompressionDictionary(compression_dict);
+    }
     for (; iter->Valid(); iter->Next()) {
       builder->Add(iter->key(), iter->value());
     }
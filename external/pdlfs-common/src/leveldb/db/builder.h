@@ -35,7 +35,8 @@ extern Status BuildTable(
     Iterator* iter,
     SequenceNumber* min_seq,
     SequenceNumber* max_seq,
-    FileMetaData* meta
+    FileMetaData* meta,
+    const Slice& compression_dict = Slice()
 );
 
 }  // namespace pdlfs
@@ -107,11 +107,19 @@ Status ColumnarDBImpl::RecoverLogFile(uint64_t log_number, VersionEdit* edit,
 
 void ColumnarDBImpl::CompactMemTable() {
   mutex_.AssertHeld();
-  assert(imm_ != NULL);
+  assert(!imm_.empty());
   size_t num_columns = columns_.size();
   assert(num_columns != 0);
   VersionEdit edit;
-  MemTable* imm = imm_;
+  // Either the oldest memtable alone or all of them merged, same as DBImpl
+  const size_t n = options_.merge_imm_memtables ? imm_.size() : 1;
+  const uint64_t next_log_number = imm_[n - 1].next_log_number;
+  // Memtables stay referenced by imm_ until popped below so the iterators
+  // remain valid after we unlock
+  std::vector<Iterator*> iters;
+  for (size_t i = 0; i < num_columns; i++) {
+    iters.push_back(NewImmutableMemTableIterator(n));
+  }
   Status s;
 
   {
@@ -120,12 +128,15 @@ void ColumnarDBImpl::CompactMemTable() {
 
     if (s.ok()) {
       for (size_t i = 0; i < num_columns; i++) {
-        s = WriteToColumn(imm, i);
+        s = WriteToColumn(iters[i], i);
         if (!s.ok()) {
           break;
         }
       }
     }
+    for (size_t i = 0; i < num_columns; i++) {
+      delete iters[i];
+    }
     mutex_.Lock();
   }
 
@@ -135,8 +146,11 @@ void ColumnarDBImpl::CompactMemTable() {
 
   // Commit
   if (s.ok()) {
+    for (size_t i = 0; i < n; i++) {
+      SaveRangeTombstones(imm_[i].mem, &edit);
+    }
     edit.SetPrevLogNumber(0);
-    edit.SetLogNumber(logfile_number_);  // Earlier logs no longer needed
+    edit.SetLogNumber(next_log_number);  // Earlier logs no longer needed
     s = versions_->LogAndApply(&edit, &mutex_);
   }
 
@@ -148,9 +162,7 @@ void ColumnarDBImpl::CompactMemTable() {
 
   if (s.ok()) {
     // Commit to the new state
-    imm_->Unref();
-    imm_ = NULL;
-    has_imm_.Release_Store(NULL);
+    PopImmutableMemTables(n);
     DeleteObsoleteFiles();
   } else {
     RecordBackgroundError(s);
@@ -183,13 +195,9 @@ Status ColumnarDBImpl::FinishMemTableCompaction() {
   return s;
 }
 
-Status ColumnarDBImpl::WriteToColumn(MemTable* mem, size_t column_index) {
-  Status s;
-  Iterator* iter = mem->NewIterator();
+Status ColumnarDBImpl::WriteToColumn(Iterator* contents, size_t column_index) {
   assert(column_index < columns_.size());
-  s = columns_[column_index]->WriteTable(iter);
-  delete iter;
-  return s;
+  return columns_[column_index]->WriteTable(contents);
 }
 
 Column* ColumnarDBImpl::PickColumn(const Slice& key) {
@@ -206,16 +214,16 @@ struct IterState {
   port::Mutex* mu;
   Column* column;
   Version* version;
-  MemTable* mem;
-  MemTable* imm;
+  std::vector<MemTable*> mems;
 };
 }
 
 static void CleanupIteratorState(void* arg1, void* arg2) {
   IterState* state = reinterpret_cast<IterState*>(arg1);
   state->mu->Lock();
-  if (state->mem != NULL) state->mem->Unref();
-  if (state->imm != NULL) state->imm->Unref();
+  for (size_t i = 0; i < state->mems.size(); i++) {
+    state->mems[i]->Unref();
+  }
   state->version->Unref();
   if (state->column != NULL) {
     state->column->Unref();
@@ -233,13 +241,11 @@ Iterator* ColumnarDBImpl::NewColumnarInternalIterator(
 
   // Collect together all needed child iterators
   std::vector<Iterator*> list;
-  if (mem_ != NULL) {
-    list.push_back(mem_->NewIterator());
-    mem_->Ref();
-  }
-  if (imm_ != NULL) {
-    list.push_back(imm_->NewIterator());
-    imm_->Ref();
+  RangeTombstoneList tombstones;
+  RefMemTables(&cleanup->mems);
+  for (size_t i = 0; i < cleanup->mems.size(); i++) {
+    list.push_back(cleanup->mems[i]->NewIterator());
+    cleanup->mems[i]->GetRangeTombstones(&tombstones);
   }
   Version* current = versions_->current();
   current->AddIterators(options, &list);
@@ -248,17 +254,24 @@ Iterator* ColumnarDBImpl::NewColumnarInternalIterator(
     list.push_back(column->NewInternalIterator(options));
     column->Ref();
   }
-  Iterator* internal_iter =
-      NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  // The list may be empty when no table is within the iterate bounds
+  Iterator* internal_iter = NewMergingIterator(
+      &internal_comparator_, list.empty() ? NULL : &list[0], list.size());
   current->Ref();
 
   cleanup->mu = &mutex_;
-  cleanup->mem = mem_;
-  cleanup->imm = imm_;
   cleanup->version = current;
   cleanup->column = column;
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, NULL);
 
+  // Hide entries deleted by range tombstones
+  internal_iter = NewRangeDelIterator(
+      &internal_comparator_, internal_iter,
+      &current->range_tombstone_fragments(), tombstones,
+      (options.snapshot != NULL
+           ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
+           : *latest_snapshot));
+
   *seed = ++seed_;
   return internal_iter;
 }
@@ -274,12 +287,25 @@ Status ColumnarDBImpl::ColumnarGet(const ReadOptions& options, const Slice& key,
     snapshot = versions_->LastSequence();
   }
 
-  MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  // See DBImpl::Get() for how keys covered by range tombstones are handled
+  const SequenceNumber tombstone = MaxCoveringTombstone(key, snapshot);
+  if (tombstone != 0) {
+    mutex_.Unlock();
+    SequenceNumber ignored_snapshot;
+    uint32_t ignored_seed;
+    Iterator* iter = NewColumnarInternalIterator(
+        options, key, &ignored_snapshot, &ignored_seed);
+    s = GetNewerThanTombstone(user_comparator(), iter, key, snapshot,
+                              tombstone, value, options.limit);
+    delete iter;
+    mutex_.Lock();
+    return s;
+  }
+
+  std::vector<MemTable*> mems;
+  RefMemTables(&mems);
   Version* current = versions_->current();
   Column* column = PickColumn(key);
-  if (mem != NULL) mem->Ref();
-  if (imm != NULL) imm->Ref();
   current->Ref();
   if (column != NULL) {
     column->Ref();
@@ -291,11 +317,9 @@ Status ColumnarDBImpl::ColumnarGet(const ReadOptions& options, const Slice& key,
   // Unlock while reading from files and memtables
   {
     mutex_.Unlock();
-    // First look in the memtable, then in the immutable memtable (if any).
+    // First look in the memtable, then in the immutable memtables (if any).
     LookupKey lkey(key, snapshot);
-    if (mem != NULL && mem->Get(lkey, value, options.limit, &s)) {
-      // Done
-    } else if (imm != NULL && imm->Get(lkey, value, options.limit, &s)) {
+    if (GetFromMemTables(mems, lkey, value, options.limit, &s)) {
       // Done
     } else {
       have_stat_update = true;
@@ -314,8 +338,7 @@ Status ColumnarDBImpl::ColumnarGet(const ReadOptions& options, const Slice& key,
     }
   }
 
-  if (mem != NULL) mem->Unref();
-  if (imm != NULL) imm->Unref();
+  UnrefMemTables(mems);
   current->Unref();
   if (column != NULL) {
     column->Unref();
@@ -334,7 +357,7 @@ Iterator* ColumnarDBImpl::NewColumnarIterator(const ReadOptions& options,
       (options.snapshot != NULL
            ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
            : latest_snapshot),
-      seed);
+      seed, options.iterate_lower_bound, options.iterate_upper_bound);
 }
 
 Status ColumnarDBWrapper::FlushMemTable(const FlushOptions& options) {
@@ -351,6 +374,11 @@ Status ColumnarDBWrapper::Delete(const WriteOptions& options,
   return impl_->Delete(options, key);
 }
 
+Status ColumnarDBWrapper::DeleteRange(const WriteOptions& options,
+                                     const Slice& begin, const Slice& end) {
+  return impl_->DeleteRange(options, begin, end);
+}
+
 Status ColumnarDBWrapper::Write(const WriteOptions& options,
                                 WriteBatch* updates) {
   return impl_->Write(options, updates);
@@ -98,7 +98,7 @@ class ColumnarDBImpl : public DBImpl {
                                 SequenceNumber* max_sequence);
 
   Status BeginMemTableCompaction();
-  Status WriteToColumn(MemTable* mem, size_t column_index);
+  Status WriteToColumn(Iterator* contents, size_t column_index);
   Status FinishMemTableCompaction();
 
   Column* PickColumn(const Slice& key);
@@ -117,6 +117,8 @@ class ColumnarDBWrapper : public ColumnarDB {
   virtual Status FlushMemTable(const FlushOptions&);
   virtual Status Put(const WriteOptions&, const Slice& key, const Slice& value);
   virtual Status Delete(const WriteOptions&, const Slice& key);
+  virtual Status DeleteRange(const WriteOptions&, const Slice& begin,
+                             const Slice& end);
   virtual Status Write(const WriteOptions&, WriteBatch* updates);
   virtual Status Get(const ReadOptions&, const Slice& key, std::string* value);
   virtual Status Get(const ReadOptions&, const Slice& key, Slice* value,
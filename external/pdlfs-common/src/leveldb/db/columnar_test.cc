@@ -32,6 +32,13 @@ class ColumnarTest {
     DestroyDB(dbname_, Options());
     options_.create_if_missing = true;
     options_.skip_lock_file = true;
+    db_ = NULL;
+    Reopen();
+  }
+
+  void Reopen() {
+    delete db_;
+    db_ = NULL;
     ColumnStyle styles[1];
     styles[0] = kLSMStyle;
     Status s =
@@ -81,6 +88,41 @@ TEST(ColumnarTest, Put) {
   ASSERT_EQ(Get("bar"), "v2");
 }
 
+TEST(ColumnarTest, MergeImmMemTables) {
+  options_.write_buffer_size = 100000;  // Small write buffer
+  options_.max_imm_memtables = 4;
+  options_.merge_imm_memtables = true;
+  Reopen();
+  for (int i = 0; i < 4; i++) {
+    std::string key(1, 'a' + i);
+    ASSERT_OK(db_->Put(WriteOptions(), key, std::string(100000, 'a' + i)));
+  }
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "v2"));
+  CompactMemTable();
+  ASSERT_EQ(Get("a"), "v2");
+  for (int i = 1; i < 4; i++) {
+    std::string key(1, 'a' + i);
+    ASSERT_EQ(Get(key), std::string(100000, 'a' + i));
+  }
+}
+
+TEST(ColumnarTest, DeleteRange) {
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "va"));
+  ASSERT_OK(db_->Put(WriteOptions(), "b", "vb"));
+  ASSERT_OK(db_->Put(WriteOptions(), "c", "vc"));
+  CompactMemTable();
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "a", "c"));
+  ASSERT_OK(db_->Put(WriteOptions(), "b", "vb2"));
+  ASSERT_EQ(Get("a"), "NOT_FOUND");
+  ASSERT_EQ(Get("b"), "vb2");
+  ASSERT_EQ(Get("c"), "vc");
+  // The tombstone outlives the memtable holding it
+  CompactMemTable();
+  ASSERT_EQ(Get("a"), "NOT_FOUND");
+  ASSERT_EQ(Get("b"), "vb2");
+  ASSERT_EQ(Get("c"), "vc");
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char** argv) {
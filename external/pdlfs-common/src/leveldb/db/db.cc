@@ -38,6 +38,21 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key) {
   return Write(opt, &batch);
 }
 
+Status DB::DeleteRange(const WriteOptions& opt, const Slice& begin,
+                       const Slice& end) {
+  return Status::NotSupported(Slice());
+}
+
+Status DB::Exists(const ReadOptions& opt, const Slice& key) {
+  ReadOptions options = opt;
+  options.limit = 0;
+  Slice ignored;
+  char tmp[1];
+  Status s = Get(options, key, &ignored, tmp, sizeof(tmp));
+  assert(!s.IsBufferFull());
+  return s;
+}
+
 Status DestroyDB(const std::string& dbname, const DBOptions& options) {
   Env* const env = options.env;
   std::vector<std::string> filenames;
@@ -25,12 +25,14 @@
 #include "db_impl.h"
 #include "db_iter.h"
 #include "memtable.h"
+#include "range_del.h"
 #include "table_cache.h"
 #include "version_set.h"
 
 #include "pdlfs-common/coding.h"
 #include "pdlfs-common/dbfiles.h"
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/leveldb/compaction_filter.h"
 #include "pdlfs-common/leveldb/db/db.h"
 #include "pdlfs-common/leveldb/db/dbformat.h"
 #include "pdlfs-common/leveldb/table.h"
@@ -65,6 +67,9 @@ struct DBImpl::CompactionState {
   SequenceNumber smallest_snapshot;
 
   // Files produced by compaction
+  // Range tombstones that no longer cover any data
+  std::vector<SequenceNumber> obsolete_tombstones;
+
   struct Output {
     uint64_t number;
     uint64_t file_size;
@@ -72,16 +77,32 @@ struct DBImpl::CompactionState {
   };
   std::vector<Output> outputs;
 
+  // File number reserved for the first output, or 0 if there is none
+  uint64_t reserved_number;
+
   // State kept for output being generated
   WritableFile* outfile;
   TableBuilder* builder;
 
   uint64_t total_bytes;
 
+  // Sorted, disjoint user key ranges of the input data blocks that were
+  // in the block cache.  Output blocks holding keys in these ranges are
+  // inserted into the block cache, up to warmup_budget bytes.
+  std::vector<std::pair<std::string, std::string> > hot_ranges;
+  size_t hot_range_index;
+  size_t warmup_budget;
+
   Output* current_output() { return &outputs[outputs.size() - 1]; }
 
   explicit CompactionState(Compaction* c)
-      : compaction(c), outfile(NULL), builder(NULL), total_bytes(0) {}
+      : compaction(c),
+        reserved_number(0),
+        outfile(NULL),
+        builder(NULL),
+        total_bytes(0),
+        hot_range_index(0),
+        warmup_budget(0) {}
 };
 
 struct DBImpl::InsertionState {
@@ -106,6 +127,105 @@ struct DBImpl::InsertionState {
       : options(&options), source_dir(dir) {}
 };
 
+namespace {
+// Applies a compaction filter to the contents of a memtable being flushed.
+// Removed keys are turned into deletion markers since older values of
+// them may still exist in the tables.  Only forward iteration is supported.
+// The caller retains the ownership of the underlying iterator.
+class FlushFilterIterator : public Iterator {
+ public:
+  FlushFilterIterator(const Comparator* ucmp, const CompactionFilter* filter,
+                      Iterator* iter, SequenceNumber newest_snapshot)
+      : ucmp_(ucmp),
+        filter_(filter),
+        iter_(iter),
+        newest_snapshot_(newest_snapshot),
+        has_prev_user_key_(false),
+        key_changed_(false),
+        value_changed_(false) {}
+
+  virtual ~FlushFilterIterator() {}
+
+  virtual bool Valid() const { return status_.ok() && iter_->Valid(); }
+  virtual Slice key() const { return key_changed_ ? key_ : iter_->key(); }
+  virtual Slice value() const {
+    return value_changed_ ? value_ : iter_->value();
+  }
+  virtual Status status() const {
+    return status_.ok() ? iter_->status() : status_;
+  }
+
+  virtual void SeekToFirst() {
+    iter_->SeekToFirst();
+    has_prev_user_key_ = false;
+    Filter();
+  }
+
+  virtual void Seek(const Slice& target) {
+    iter_->Seek(target);
+    has_prev_user_key_ = false;
+    Filter();
+  }
+
+  virtual void Next() {
+    iter_->Next();
+    Filter();
+  }
+
+  virtual void SeekToLast() { status_ = Status::NotSupported(Slice()); }
+  virtual void Prev() { status_ = Status::NotSupported(Slice()); }
+
+ private:
+  void Filter() {
+    key_changed_ = value_changed_ = false;
+    ParsedInternalKey ikey;
+    if (!iter_->Valid() || !ParseInternalKey(iter_->key(), &ikey)) {
+      return;  // Pass corrupted keys through
+    }
+    // Only the newest entry of each key is filtered
+    const bool newest = !has_prev_user_key_ ||
+                        ucmp_->Compare(ikey.user_key, prev_user_key_) != 0;
+    prev_user_key_.assign(ikey.user_key.data(), ikey.user_key.size());
+    has_prev_user_key_ = true;
+    if (newest && ikey.type == kTypeValue &&
+        ikey.sequence > newest_snapshot_) {
+      value_.clear();
+      switch (filter_->Filter(0, ikey.user_key, iter_->value(), &value_)) {
+        case CompactionFilter::kRemove:
+          key_.clear();
+          AppendInternalKey(&key_, ParsedInternalKey(ikey.user_key,
+                                                     ikey.sequence,
+                                                     kTypeDeletion));
+          value_.clear();
+          key_changed_ = value_changed_ = true;
+          break;
+        case CompactionFilter::kChangeValue:
+          value_changed_ = true;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  const Comparator* const ucmp_;
+  const CompactionFilter* const filter_;
+  Iterator* const iter_;
+  const SequenceNumber newest_snapshot_;
+  std::string prev_user_key_;
+  bool has_prev_user_key_;
+  std::string key_;
+  std::string value_;
+  bool key_changed_;
+  bool value_changed_;
+  Status status_;
+
+  // No copying allowed
+  FlushFilterIterator(const FlushFilterIterator&);
+  void operator=(const FlushFilterIterator&);
+};
+}  // namespace
+
 DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
     : env_(raw_options.env),
       internal_comparator_(raw_options.comparator),
@@ -120,7 +240,7 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       shutting_down_(NULL),
       bg_cv_(&mutex_),
       mem_(NULL),
-      imm_(NULL),
+      imm_usage_(0),
       logfile_(NULL),
       logfile_number_(0),
       log_(NULL),
@@ -128,6 +248,9 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       bg_compaction_paused_(0),
       bg_compaction_scheduled_(false),
       bulk_insert_in_progress_(false),
+      exists_blocks_avoided_(0),
+      exists_blocks_read_(0),
+      compression_dict_sampled_(false),
       manual_compaction_(NULL) {
   if (!options_.no_memtable) {
     mem_ = new MemTable(internal_comparator_);
@@ -156,7 +279,9 @@ DBImpl::~DBImpl() {
 
   delete versions_;
   if (mem_ != NULL) mem_->Unref();
-  if (imm_ != NULL) imm_->Unref();
+  for (size_t i = 0; i < imm_.size(); i++) {
+    imm_[i].mem->Unref();
+  }
   delete log_;
   delete logfile_;
   delete table_cache_;
@@ -222,7 +347,7 @@ Status DBImpl::FlushMemTable(const FlushOptions& options) {
     MutexLock l(&mutex_);
     // Either mine is being compacted, or someone else's table
     // is being compacted.
-    while (imm_ != NULL && bg_error_.ok()) {
+    while (!imm_.empty() && bg_error_.ok()) {
       bg_cv_.Wait();
     }
     if (options.force_flush_l0 && bg_error_.ok()) {
@@ -503,6 +628,28 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, VersionEdit* edit,
   return status;
 }
 
+// Zstd suggests about 100 times as much sample data as the dictionary
+// size.  Each user key and its value is a separate sample.  The
+// sequence numbers and types of internal keys carry little that a
+// dictionary could learn, so they are left out.
+static void TrainCompressionDict(Iterator* iter, size_t dict_size,
+                                 std::string* dict) {
+  const size_t max_sample_bytes = 100 * dict_size;
+  std::string samples;
+  std::vector<size_t> sample_sizes;
+  for (iter->SeekToFirst(); iter->Valid() && samples.size() < max_sample_bytes;
+       iter->Next()) {
+    const Slice key = ExtractUserKey(iter->key());
+    const Slice value = iter->value();
+    samples.append(key.data(), key.size());
+    samples.append(value.data(), value.size());
+    sample_sizes.push_back(key.size() + value.size());
+  }
+  if (!port::Zstd_TrainDictionary(samples, sample_sizes, dict_size, dict)) {
+    dict->clear();  // Go without a dictionary
+  }
+}
+
 // REQUIRES: mutex_ has been locked.
 Status DBImpl::WriteMemTable(MemTable* mem, VersionEdit* edit, Version* base) {
   mutex_.AssertHeld();
@@ -512,9 +659,21 @@ Status DBImpl::WriteMemTable(MemTable* mem, VersionEdit* edit, Version* base) {
   Status s = WriteLevel0Table(iter, edit, base, &ignored_min_seq,
                               &ignored_max_seq, false);
   delete iter;
+  if (s.ok()) {
+    SaveRangeTombstones(mem, edit);
+  }
   return s;
 }
 
+void DBImpl::SaveRangeTombstones(MemTable* mem, VersionEdit* edit) {
+  RangeTombstoneList tombstones;
+  mem->GetRangeTombstones(&tombstones);
+  for (size_t i = 0; i < tombstones.size(); i++) {
+    const RangeTombstone& t = tombstones[i];
+    edit->AddRangeTombstone(t.begin, t.end, t.seq);
+  }
+}
+
 // REQUIRES: mutex_ has been locked.
 Status DBImpl::WriteLevel0Table(Iterator* iter, VersionEdit* edit,
                                 Version* base, SequenceNumber* min_seq,
@@ -527,13 +686,39 @@ Status DBImpl::WriteLevel0Table(Iterator* iter, VersionEdit* edit,
   Log(options_.info_log, "Level-0 table #%llu: started",
       (unsigned long long)meta.number);
 
+  FlushFilterIterator* filter_iter = NULL;
+  if (options_.compaction_filter != NULL) {
+    // Keys visible to a live snapshot are not filtered
+    const SequenceNumber newest_snapshot =
+        snapshots_.empty() ? 0 : snapshots_.newest()->number_;
+    filter_iter =
+        new FlushFilterIterator(user_comparator(), options_.compaction_filter,
+                                iter, newest_snapshot);
+    iter = filter_iter;
+  }
+
+  // Train the compression dictionary from the first memtable we flush
+  const bool train_dict = options_.compression == kZstdCompression &&
+                          options_.compression_dict_size != 0 &&
+                          !compression_dict_sampled_;
+  compression_dict_sampled_ = compression_dict_sampled_ || train_dict;
+  std::string compression_dict = compression_dict_;
+
   Status s;
   {
     mutex_.Unlock();
+    if (train_dict) {
+      TrainCompressionDict(iter, options_.compression_dict_size,
+                           &compression_dict);
+    }
     s = BuildTable(dbname_, env_, options_, table_cache_, iter, min_seq,
-                   max_seq, &meta);
+                   max_seq, &meta, compression_dict);
     mutex_.Lock();
   }
+  if (train_dict) {
+    compression_dict_ = compression_dict;
+  }
+  delete filter_iter;
 
   Log(options_.info_log, "Level-0 table #%llu: %lld bytes %s",
       (unsigned long long)meta.number, (unsigned long long)meta.file_size,
@@ -548,11 +733,12 @@ Status DBImpl::WriteLevel0Table(Iterator* iter, VersionEdit* edit,
     const Slice max_user_key = meta.largest.user_key();
 
     if (base != NULL) {
-      if (!force_level0 && !options_.disable_compaction) {
+      if (!force_level0 && !options_.disable_compaction &&
+          options_.compaction_style == kCompactionStyleLeveled) {
         level = base->PickLevelForMemTableOutput(min_user_key, max_user_key);
       } else {
-        // If compaction has been disabled, or force_level0 has been set,
-        // all MemTable dumps will only go to level-0.
+        // If compaction has been disabled, force_level0 has been set, or
+        // compactions are tiered, all MemTable dumps will only go to level-0.
       }
     }
     edit->AddFile(level, meta.number, meta.file_size, meta.seq_off,
@@ -566,33 +752,117 @@ Status DBImpl::WriteLevel0Table(Iterator* iter, VersionEdit* edit,
   return s;
 }
 
+// REQUIRES: mutex_ has been locked.
+void DBImpl::RefMemTables(std::vector<MemTable*>* mems) {
+  mutex_.AssertHeld();
+  if (mem_ != NULL) {
+    mems->push_back(mem_);
+    mem_->Ref();
+  }
+  for (size_t i = imm_.size(); i != 0; i--) {
+    MemTable* const imm = imm_[i - 1].mem;
+    mems->push_back(imm);
+    imm->Ref();
+  }
+}
+
+bool DBImpl::GetFromMemTables(const std::vector<MemTable*>& mems,
+                              const LookupKey& lkey, Buffer* value,
+                              size_t limit, Status* s,
+                              SequenceNumber tombstone) {
+  for (size_t i = 0; i < mems.size(); i++) {
+    if (mems[i]->Get(lkey, value, limit, s, tombstone)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// REQUIRES: mutex_ has been locked.
+void DBImpl::UnrefMemTables(const std::vector<MemTable*>& mems) {
+  for (size_t i = 0; i < mems.size(); i++) {
+    mems[i]->Unref();
+  }
+}
+
+// REQUIRES: mutex_ has been locked.
+void DBImpl::PushImmutableMemTable() {
+  mutex_.AssertHeld();
+  ImmutableMemTable imm;
+  imm.mem = mem_;
+  imm.next_log_number = logfile_number_;
+  imm_usage_ += mem_->ApproximateMemoryUsage();
+  imm_.push_back(imm);
+  has_imm_.Release_Store(imm.mem);
+}
+
+// REQUIRES: mutex_ has been locked.
+void DBImpl::PopImmutableMemTables(size_t n) {
+  mutex_.AssertHeld();
+  assert(n <= imm_.size());
+  for (; n != 0; n--) {
+    MemTable* const imm = imm_.front().mem;
+    imm_usage_ -= imm->ApproximateMemoryUsage();
+    imm_.pop_front();
+    imm->Unref();
+  }
+  if (imm_.empty()) {
+    has_imm_.Release_Store(NULL);
+  }
+}
+
+// REQUIRES: mutex_ has been locked.
+Iterator* DBImpl::NewImmutableMemTableIterator(size_t n) {
+  mutex_.AssertHeld();
+  assert(n != 0 && n <= imm_.size());
+  if (n == 1) {
+    return imm_.front().mem->NewIterator();
+  } else {
+    std::vector<Iterator*> list;
+    for (size_t i = 0; i < n; i++) {
+      list.push_back(imm_[i].mem->NewIterator());
+    }
+    return NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  }
+}
+
 void DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
-  assert(imm_ != NULL);
+  assert(!imm_.empty());
+  // Memtables are compacted in order; either the oldest one alone
+  // or all of them merged into a single Table
+  const size_t n = options_.merge_imm_memtables ? imm_.size() : 1;
+  const uint64_t next_log_number = imm_[n - 1].next_log_number;
 
-  // Save the contents of the memtable as a new Table
+  // Save the contents of the memtables as a new Table
   VersionEdit edit;
   Version* base = versions_->current();
   base->Ref();
-  Status s = WriteMemTable(imm_, &edit, base);
+  SequenceNumber ignored_min_seq;
+  SequenceNumber ignored_max_seq;
+  Iterator* iter = NewImmutableMemTableIterator(n);
+  Status s = WriteLevel0Table(iter, &edit, base, &ignored_min_seq,
+                              &ignored_max_seq, false);
+  delete iter;
   base->Unref();
 
   if (s.ok() && shutting_down_.Acquire_Load()) {
     s = Status::IOError("Deleting db during memtable compaction");
   }
 
-  // Replace immutable memtable with the generated Table
+  // Replace immutable memtables with the generated Table
   if (s.ok()) {
+    for (size_t i = 0; i < n; i++) {
+      SaveRangeTombstones(imm_[i].mem, &edit);
+    }
     edit.SetPrevLogNumber(0);
-    edit.SetLogNumber(logfile_number_);  // Earlier logs no longer needed
+    edit.SetLogNumber(next_log_number);  // Earlier logs no longer needed
     s = versions_->LogAndApply(&edit, &mutex_);
   }
 
   if (s.ok()) {
     // Commit to the new state
-    imm_->Unref();
-    imm_ = NULL;
-    has_imm_.Release_Store(NULL);
+    PopImmutableMemTables(n);
     DeleteObsoleteFiles();
   } else {
     RecordBackgroundError(s);
@@ -660,10 +930,10 @@ Status DBImpl::TEST_CompactMemTable() {
   if (s.ok()) {
     // Wait until the compaction completes
     MutexLock l(&mutex_);
-    while (imm_ != NULL && bg_error_.ok()) {
+    while (!imm_.empty() && bg_error_.ok()) {
       bg_cv_.Wait();
     }
-    if (imm_ != NULL) {
+    if (!imm_.empty()) {
       s = bg_error_;
     }
   }
@@ -679,7 +949,7 @@ void DBImpl::RecordBackgroundError(const Status& s) {
 }
 
 bool DBImpl::HasCompaction() {
-  if (imm_ != NULL) {
+  if (!imm_.empty()) {
     return true;
   } else if (manual_compaction_ != NULL) {
     return true;
@@ -739,7 +1009,7 @@ void DBImpl::BackgroundCall() {
 void DBImpl::BackgroundCompaction() {
   mutex_.AssertHeld();
 
-  if (imm_ != NULL) {
+  if (!imm_.empty()) {
     CompactMemTable();
     return;
   }
@@ -833,6 +1103,9 @@ void DBImpl::CleanupCompaction(CompactionState* compact) {
     const CompactionState::Output& out = compact->outputs[i];
     pending_outputs_.erase(out.number);
   }
+  if (compact->reserved_number != 0) {
+    pending_outputs_.erase(compact->reserved_number);
+  }
   delete compact;
 }
 
@@ -840,10 +1113,17 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
   assert(compact != NULL);
   assert(compact->builder == NULL);
   uint64_t file_number;
+  std::string compression_dict;
   {
     mutex_.Lock();
-    file_number = versions_->NewFileNumber();
-    pending_outputs_.insert(file_number);
+    if (compact->reserved_number != 0) {
+      file_number = compact->reserved_number;
+      compact->reserved_number = 0;
+    } else {
+      file_number = versions_->NewFileNumber();
+      pending_outputs_.insert(file_number);
+    }
+    compression_dict = compression_dict_;
     CompactionState::Output out;
     out.number = file_number;
     out.smallest.Clear();
@@ -854,9 +1134,20 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
 
   // Make the output file
   std::string fname = TableFileName(dbname_, file_number);
-  Status s = env_->NewWritableFile(fname.c_str(), &compact->outfile);
+  Status s;
+  if (options_.compaction_direct_writes) {
+    s = env_->NewDirectWritableFile(fname.c_str(), &compact->outfile);
+  } else {
+    s = env_->NewWritableFile(fname.c_str(), &compact->outfile);
+  }
   if (s.ok()) {
     compact->builder = new TableBuilder(options_, compact->outfile);
+    if (!compression_dict.empty()) {
+      compact->builder->SetCompressionDictionary(compression_dict);
+    }
+    if (compact->warmup_budget != 0) {
+      compact->builder->RetainHotBlocks(compact->warmup_budget);
+    }
   }
   return s;
 }
@@ -886,6 +1177,8 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
   const uint64_t current_bytes = compact->builder->FileSize();
   compact->current_output()->file_size = current_bytes;
   compact->total_bytes += current_bytes;
+  std::vector<std::pair<uint64_t, std::string> > hot_blocks;
+  compact->builder->TakeRetainedBlocks(&hot_blocks);
   delete compact->builder;
   compact->builder = NULL;
 
@@ -902,9 +1195,17 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
   if (s.ok() && current_entries > 0) {
     const SequenceOff off = 0;
     // Verify that the table is usable
+    Table* table;
     Iterator* iter = table_cache_->NewIterator(ReadOptions(), output_number,
-                                               current_bytes, off);
+                                               current_bytes, off, &table);
     s = iter->status();
+    if (s.ok()) {
+      // Warm the block cache with blocks whose inputs were hot
+      for (size_t i = 0; i < hot_blocks.size(); i++) {
+        table->InsertCachedBlock(hot_blocks[i].first, hot_blocks[i].second);
+        compact->warmup_budget -= hot_blocks[i].second.size();
+      }
+    }
     delete iter;
     if (s.ok()) {
       Log(options_.info_log, "Generated table #%llu: %lld keys, %lld bytes",
@@ -920,21 +1221,160 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
   mutex_.AssertHeld();
   Log(options_.info_log, "Compacted %d@%d + %d@%d files => %lld bytes",
       compact->compaction->num_input_files(0), compact->compaction->level(),
-      compact->compaction->num_input_files(1), compact->compaction->level() + 1,
+      compact->compaction->num_input_files(1),
+      compact->compaction->output_level(),
       static_cast<long long>(compact->total_bytes));
 
   // Add compaction outputs
   compact->compaction->AddInputDeletions(compact->compaction->edit());
-  const int level = compact->compaction->level();
+  const int level = compact->compaction->output_level();
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     const SequenceOff off = 0;
     const CompactionState::Output& out = compact->outputs[i];
-    compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size,
+    compact->compaction->edit()->AddFile(level, out.number, out.file_size,
                                          off, out.smallest, out.largest);
   }
+  for (size_t i = 0; i < compact->obsolete_tombstones.size(); i++) {
+    compact->compaction->edit()->DeleteRangeTombstone(
+        compact->obsolete_tombstones[i]);
+  }
   return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
 }
 
+namespace {
+struct TombstoneBeginLess {
+  const Comparator* ucmp;
+  bool operator()(const RangeTombstone* a, const RangeTombstone* b) const {
+    return ucmp->Compare(a->begin, b->begin) < 0;
+  }
+};
+}  // namespace
+
+// Tables and memtables are searched without holding the lock.
+void DBImpl::FindEmptyTombstones(const std::vector<MemTable*>& mems,
+                                 Version* base,
+                                 std::vector<const RangeTombstone*>* candidates,
+                                 std::vector<SequenceNumber>* obsolete) {
+  const Comparator* ucmp = user_comparator();
+  TombstoneBeginLess less;
+  less.ucmp = ucmp;
+  std::sort(candidates->begin(), candidates->end(), less);
+  ReadOptions options;
+  options.fill_cache = false;
+  std::vector<Iterator*> list;
+  for (size_t i = 0; i < mems.size(); i++) {
+    list.push_back(mems[i]->NewIterator());
+  }
+  base->AddIterators(options, &list);
+  Iterator* iter = NewMergingIterator(
+      &internal_comparator_, list.empty() ? NULL : &list[0], list.size());
+  bool seeked = false;
+  for (size_t i = 0; i < candidates->size(); i++) {
+    const RangeTombstone* t = (*candidates)[i];
+    // Once positioned at the first key no less than an earlier begin key,
+    // the iterator is also at the first key no less than this begin key
+    // unless it is still behind it.
+    if (!seeked || (iter->Valid() && ucmp->Compare(ExtractUserKey(iter->key()),
+                                                   t->begin) < 0)) {
+      InternalKey target(t->begin, kMaxSequenceNumber, kValueTypeForSeek);
+      iter->Seek(target.Encode());
+      seeked = true;
+    }
+    if (iter->Valid()) {
+      if (ucmp->Compare(ExtractUserKey(iter->key()), t->end) >= 0) {
+        obsolete->push_back(t->seq);
+      }
+    } else if (iter->status().ok()) {
+      obsolete->push_back(t->seq);
+    } else {
+      break;
+    }
+  }
+  delete iter;
+}
+
+namespace {
+struct HotRangeLess {
+  const Comparator* ucmp;
+
+  // An empty begin key leaves a range unbounded on the left
+  bool operator()(const std::pair<std::string, std::string>& a,
+                  const std::pair<std::string, std::string>& b) const {
+    if (a.first.empty() || b.first.empty()) {
+      return a.first.empty() && !b.first.empty();
+    }
+    return ucmp->Compare(a.first, b.first) < 0;
+  }
+};
+}  // namespace
+
+// Find the key ranges of the input data blocks currently in the block
+// cache.  Tables and the block cache are accessed without holding the lock.
+void DBImpl::CollectHotRanges(CompactionState* compact) {
+  const Comparator* ucmp = user_comparator();
+  std::vector<std::pair<std::string, std::string> > ranges;
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
+      const FileMetaData* f = compact->compaction->input(which, i);
+      Table* table;
+      Iterator* iter = table_cache_->NewIterator(
+          ReadOptions(), f->number, f->file_size, f->seq_off, &table);
+      if (iter->status().ok()) {
+        table->GetCachedBlockRanges(&ranges);
+      }
+      delete iter;
+    }
+  }
+  // Convert index keys to user keys
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].first.size() >= 8) {
+      ranges[i].first = ExtractUserKey(ranges[i].first).ToString();
+    } else {
+      ranges[i].first.clear();
+    }
+    if (ranges[i].second.size() >= 8) {
+      ranges[i].second = ExtractUserKey(ranges[i].second).ToString();
+    }
+  }
+  HotRangeLess cmp;
+  cmp.ucmp = ucmp;
+  std::sort(ranges.begin(), ranges.end(), cmp);
+  // Merge overlapping ranges
+  std::vector<std::pair<std::string, std::string> >* result =
+      &compact->hot_ranges;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (!result->empty() &&
+        ucmp->Compare(ranges[i].first, result->back().second) <= 0) {
+      if (ucmp->Compare(ranges[i].second, result->back().second) > 0) {
+        result->back().second = ranges[i].second;
+      }
+    } else {
+      result->push_back(ranges[i]);
+    }
+  }
+  if (!result->empty()) {
+    compact->warmup_budget = options_.compaction_cache_warmup_size;
+  }
+}
+
+// Keys are checked in increasing order so ranges that end before
+// "user_key" are never needed again.
+bool DBImpl::IsHotKey(CompactionState* compact, const Slice& user_key) {
+  const Comparator* ucmp = user_comparator();
+  std::vector<std::pair<std::string, std::string> >& ranges =
+      compact->hot_ranges;
+  while (compact->hot_range_index < ranges.size() &&
+         ucmp->Compare(ranges[compact->hot_range_index].second, user_key) <
+             0) {
+    compact->hot_range_index++;
+  }
+  if (compact->hot_range_index < ranges.size()) {
+    const std::string& begin = ranges[compact->hot_range_index].first;
+    return begin.empty() || ucmp->Compare(begin, user_key) <= 0;
+  }
+  return false;
+}
+
 Status DBImpl::DoCompactionWork(CompactionState* compact) {
   const uint64_t start_micros = env_->NowMicros();
   int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
@@ -942,7 +1382,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   Log(options_.info_log, "Compacting %d@%d + %d@%d files",
       compact->compaction->num_input_files(0), compact->compaction->level(),
       compact->compaction->num_input_files(1),
-      compact->compaction->level() + 1);
+      compact->compaction->output_level());
 
   assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
   assert(compact->builder == NULL);
@@ -952,10 +1392,57 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   } else {
     compact->smallest_snapshot = snapshots_.oldest()->number_;
   }
+  // Keys visible to a live snapshot are not filtered
+  const SequenceNumber newest_snapshot =
+      snapshots_.empty() ? 0 : snapshots_.newest()->number_;
+  // Level-0 runs are ordered by file number, so the output of a tiered
+  // compaction must be numbered before any memtable flushed while we
+  // compact.
+  if (compact->compaction->output_level() == 0) {
+    compact->reserved_number = versions_->NewFileNumber();
+    pending_outputs_.insert(compact->reserved_number);
+  }
+  // Tombstones flushed from memtables while we compact are newer than
+  // those below and are simply left for future compactions
+  const RangeTombstoneList tombstones =
+      versions_->current()->range_tombstones();
+  const FragmentedRangeTombstoneList fragments =
+      versions_->current()->range_tombstone_fragments();
+  // A tombstone that no snapshot predates is obsolete once its range holds
+  // no data. Keys written to the range later are newer than the tombstone,
+  // so checking the current tables and memtables before compacting is safe.
+  // Data covered by a tombstone is removed by one compaction and the
+  // tombstone itself is removed by the next one.
+  std::vector<MemTable*> gc_mems;
+  Version* gc_base = NULL;
+  for (size_t i = 0; i < tombstones.size(); i++) {
+    if (tombstones[i].seq <= compact->smallest_snapshot) {
+      RefMemTables(&gc_mems);
+      gc_base = versions_->current();
+      gc_base->Ref();
+      break;
+    }
+  }
 
   // Release mutex while we're actually doing the compaction work
   mutex_.Unlock();
 
+  if (gc_base != NULL) {
+    std::vector<const RangeTombstone*> candidates;
+    for (size_t i = 0; i < tombstones.size(); i++) {
+      if (tombstones[i].seq <= compact->smallest_snapshot) {
+        candidates.push_back(&tombstones[i]);
+      }
+    }
+    FindEmptyTombstones(gc_mems, gc_base, &candidates,
+                        &compact->obsolete_tombstones);
+  }
+
+  if (options_.compaction_cache_warmup_size != 0 &&
+      options_.block_cache != NULL) {
+    CollectHotRanges(compact);
+  }
+
   Iterator* input = versions_->MakeInputIterator(compact->compaction);
   input->SeekToFirst();
   Status status;
@@ -963,12 +1450,14 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   std::string current_user_key;
   bool has_current_user_key = false;
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  std::string filtered_key;
+  std::string filtered_value;
   for (; input->Valid() && !shutting_down_.Acquire_Load();) {
     // Prioritize immutable compaction work
     if (has_imm_.NoBarrier_Load() != NULL) {
       const uint64_t imm_start = env_->NowMicros();
       mutex_.Lock();
-      if (imm_ != NULL) {
+      if (!imm_.empty()) {
         CompactMemTable();
         bg_cv_.SignalAll();  // Wakeup MakeRoomForWrite() if necessary
       }
@@ -977,6 +1466,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     }
 
     Slice key = input->key();
+    Slice value = input->value();
     if (compact->compaction->ShouldStopBefore(key) &&
         compact->builder != NULL) {
       status = FinishCompactionOutputFile(compact, input);
@@ -1016,6 +1506,41 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         //     few iterations of this loop (by rule (A) above).
         // Therefore this deletion marker is obsolete and can be dropped.
         drop = true;
+      } else if (ikey.sequence <
+                 fragments.MaxCoveringTombstone(ikey.user_key,
+                                                compact->smallest_snapshot)) {
+        // Deleted by a range tombstone that no snapshot can see through
+        drop = true;
+      } else if (options_.compaction_filter != NULL &&
+                 last_sequence_for_key == kMaxSequenceNumber &&
+                 ikey.type == kTypeValue && ikey.sequence > newest_snapshot) {
+        // Newest value of this user key that no snapshot can see
+        filtered_value.clear();
+        switch (options_.compaction_filter->Filter(
+            compact->compaction->output_level(), ikey.user_key, value,
+            &filtered_value)) {
+          case CompactionFilter::kRemove:
+            // Older values of this key will be dropped by rule (A) above
+            if (ikey.sequence <= compact->smallest_snapshot &&
+                compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+              drop = true;
+            } else {
+              // Older values may exist in deeper levels or be needed
+              // by snapshots
+              filtered_key.clear();
+              AppendInternalKey(&filtered_key,
+                                ParsedInternalKey(ikey.user_key, ikey.sequence,
+                                                  kTypeDeletion));
+              key = filtered_key;
+              value = Slice();
+            }
+            break;
+          case CompactionFilter::kChangeValue:
+            value = filtered_value;
+            break;
+          default:
+            break;
+        }
       }
 
       last_sequence_for_key = ikey.sequence;
@@ -1039,7 +1564,11 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         }
       }
 
-      compact->builder->Add(key, input->value());
+      if (!compact->hot_ranges.empty() && key.size() >= 8 &&
+          IsHotKey(compact, ExtractUserKey(key))) {
+        compact->builder->MarkNextKeyHot();
+      }
+      compact->builder->Add(key, value);
 
       // Close output file if it is big enough
       if (compact->builder->FileSize() >=
@@ -1078,7 +1607,11 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   }
 
   mutex_.Lock();
-  stats_[compact->compaction->level() + 1].Add(stats);
+  stats_[compact->compaction->output_level()].Add(stats);
+  if (gc_base != NULL) {
+    UnrefMemTables(gc_mems);
+    gc_base->Unref();
+  }
 
   if (status.ok()) {
     status = InstallCompactionResults(compact);
@@ -1095,15 +1628,15 @@ namespace {
 struct IterState {
   port::Mutex* mu;
   Version* version;
-  MemTable* mem;
-  MemTable* imm;
+  std::vector<MemTable*> mems;
 };
 
 static void CleanupIteratorState(void* arg1, void* arg2) {
   IterState* state = reinterpret_cast<IterState*>(arg1);
   state->mu->Lock();
-  if (state->mem != NULL) state->mem->Unref();
-  if (state->imm != NULL) state->imm->Unref();
+  for (size_t i = 0; i < state->mems.size(); i++) {
+    state->mems[i]->Unref();
+  }
   state->version->Unref();
   state->mu->Unlock();
   delete state;
@@ -1113,36 +1646,70 @@ static void CleanupIteratorState(void* arg1, void* arg2) {
 Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
                                       SequenceNumber* latest_snapshot,
                                       uint32_t* seed) {
-  IterState* cleanup = new IterState;
   mutex_.Lock();
   *latest_snapshot = versions_->LastSequence();
+  RangeTombstoneList tombstones;
+  Iterator* internal_iter = NewRawInternalIterator(options, &tombstones);
+
+  // Hide entries deleted by range tombstones. The iterator keeps the
+  // current version alive, and with it the version's fragmented tombstones.
+  internal_iter = NewRangeDelIterator(
+      &internal_comparator_, internal_iter,
+      &versions_->current()->range_tombstone_fragments(), tombstones,
+      (options.snapshot != NULL
+           ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
+           : *latest_snapshot));
+
+  *seed = ++seed_;
+  mutex_.Unlock();
+  return internal_iter;
+}
+
+// REQUIRES: mutex_ has been locked.
+Iterator* DBImpl::NewRawInternalIterator(const ReadOptions& options,
+                                         RangeTombstoneList* tombstones) {
+  mutex_.AssertHeld();
+  IterState* cleanup = new IterState;
 
   // Collect together all needed child iterators
   std::vector<Iterator*> list;
-  if (mem_ != NULL) {
-    list.push_back(mem_->NewIterator());
-    mem_->Ref();
-  }
-  if (imm_ != NULL) {
-    list.push_back(imm_->NewIterator());
-    imm_->Ref();
+  RefMemTables(&cleanup->mems);
+  for (size_t i = 0; i < cleanup->mems.size(); i++) {
+    list.push_back(cleanup->mems[i]->NewIterator());
+    if (tombstones != NULL) {
+      cleanup->mems[i]->GetRangeTombstones(tombstones);
+    }
   }
-  versions_->current()->AddIterators(options, &list);
-  Iterator* internal_iter =
-      NewMergingIterator(&internal_comparator_, &list[0], list.size());
-  versions_->current()->Ref();
+  Version* current = versions_->current();
+  current->AddIterators(options, &list);
+  // The list may be empty when no table is within the iterate bounds
+  Iterator* internal_iter = NewMergingIterator(
+      &internal_comparator_, list.empty() ? NULL : &list[0], list.size());
+  current->Ref();
 
   cleanup->mu = &mutex_;
-  cleanup->mem = mem_;
-  cleanup->imm = imm_;
-  cleanup->version = versions_->current();
+  cleanup->version = current;
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, NULL);
-
-  *seed = ++seed_;
-  mutex_.Unlock();
   return internal_iter;
 }
 
+// REQUIRES: mutex_ has been locked.
+SequenceNumber DBImpl::MaxCoveringTombstone(const Slice& key,
+                                            SequenceNumber snapshot) {
+  mutex_.AssertHeld();
+  SequenceNumber result = versions_->current()
+                              ->range_tombstone_fragments()
+                              .MaxCoveringTombstone(key, snapshot);
+  if (mem_ != NULL) {
+    result = std::max(result, mem_->MaxCoveringTombstone(key, snapshot));
+  }
+  for (size_t i = 0; i < imm_.size(); i++) {
+    result =
+        std::max(result, imm_[i].mem->MaxCoveringTombstone(key, snapshot));
+  }
+  return result;
+}
+
 Iterator* DBImpl::TEST_NewInternalIterator() {
   SequenceNumber ignored;
   uint32_t ignored_seed;
@@ -1154,15 +1721,39 @@ int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
   return versions_->MaxNextLevelOverlappingBytes();
 }
 
+size_t DBImpl::TEST_NumRangeTombstones() {
+  MutexLock l(&mutex_);
+  RangeTombstoneList tombstones = versions_->current()->range_tombstones();
+  if (mem_ != NULL) {
+    mem_->GetRangeTombstones(&tombstones);
+  }
+  for (size_t i = 0; i < imm_.size(); i++) {
+    imm_[i].mem->GetRangeTombstones(&tombstones);
+  }
+  return tombstones.size();
+}
+
+Status DBImpl::TEST_Get(const ReadOptions& options, const LookupKey& lkey,
+                        Buffer* value) {
+  return Get(options, lkey, value);
+}
+
 Status DBImpl::Get(const ReadOptions& options, const LookupKey& lkey,
                    Buffer* value) {
   Status s;
   MutexLock l(&mutex_);
-  MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(lkey.internal_key(), &ikey)) {
+    return Status::InvalidArgument("bad lookup key");
+  }
+
+  // See Get() below for keys covered by range tombstones
+  const SequenceNumber tombstone =
+      MaxCoveringTombstone(ikey.user_key, ikey.sequence);
+
+  std::vector<MemTable*> mems;
+  RefMemTables(&mems);
   Version* current = versions_->current();
-  if (mem != NULL) mem->Ref();
-  if (imm != NULL) imm->Ref();
   current->Ref();
 
   bool have_stat_update = false;
@@ -1171,13 +1762,11 @@ Status DBImpl::Get(const ReadOptions& options, const LookupKey& lkey,
   // Unlock while reading from files and memtables
   {
     mutex_.Unlock();
-    // First look in the memtable, then in the immutable memtable (if any).
-    if (mem != NULL && mem->Get(lkey, value, options.limit, &s)) {
-      // Done
-    } else if (imm != NULL && imm->Get(lkey, value, options.limit, &s)) {
+    // First look in the memtable, then in the immutable memtables (if any).
+    if (GetFromMemTables(mems, lkey, value, options.limit, &s, tombstone)) {
       // Done
     } else {
-      current->Get(options, lkey, value, &s, &stats);
+      current->Get(options, lkey, value, &s, &stats, tombstone);
       have_stat_update = true;
     }
     mutex_.Lock();
@@ -1188,8 +1777,7 @@ Status DBImpl::Get(const ReadOptions& options, const LookupKey& lkey,
       MaybeScheduleCompaction();
     }
   }
-  if (mem != NULL) mem->Unref();
-  if (imm != NULL) imm->Unref();
+  UnrefMemTables(mems);
   current->Unref();
   return s;
 }
@@ -1205,11 +1793,15 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
     snapshot = versions_->LastSequence();
   }
 
-  MemTable* mem = mem_;
-  MemTable* imm = imm_;
+  // Keys covered by a range tombstone may still have entries that are
+  // newer than the tombstone. Since lookups visit entries from newest to
+  // oldest, the key is deleted as soon as the newest visible entry turns
+  // out to be older than the tombstone.
+  const SequenceNumber tombstone = MaxCoveringTombstone(key, snapshot);
+
+  std::vector<MemTable*> mems;
+  RefMemTables(&mems);
   Version* current = versions_->current();
-  if (mem != NULL) mem->Ref();
-  if (imm != NULL) imm->Ref();
   current->Ref();
 
   bool have_stat_update = false;
@@ -1218,14 +1810,12 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
   // Unlock while reading from files and memtables
   {
     mutex_.Unlock();
-    // First look in the memtable, then in the immutable memtable (if any).
+    // First look in the memtable, then in the immutable memtables (if any).
     LookupKey lkey(key, snapshot);
-    if (mem != NULL && mem->Get(lkey, value, options.limit, &s)) {
-      // Done
-    } else if (imm != NULL && imm->Get(lkey, value, options.limit, &s)) {
+    if (GetFromMemTables(mems, lkey, value, options.limit, &s, tombstone)) {
       // Done
     } else {
-      current->Get(options, lkey, value, &s, &stats);
+      current->Get(options, lkey, value, &s, &stats, tombstone);
       have_stat_update = true;
     }
     mutex_.Lock();
@@ -1236,8 +1826,7 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
       MaybeScheduleCompaction();
     }
   }
-  if (mem != NULL) mem->Unref();
-  if (imm != NULL) imm->Unref();
+  UnrefMemTables(mems);
   current->Unref();
   return s;
 }
@@ -1262,6 +1851,49 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key, Slice* value,
   return s;
 }
 
+Status DBImpl::Exists(const ReadOptions& opt, const Slice& key) {
+  ReadOptions options = opt;
+  options.limit = 0;
+  char tmp[1];
+  buffer::DirectBuf buf(tmp, sizeof(tmp));
+  Status s;
+  MutexLock l(&mutex_);
+  SequenceNumber snapshot;
+  if (options.snapshot != NULL) {
+    snapshot = reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_;
+  } else {
+    snapshot = versions_->LastSequence();
+  }
+
+  // See Get() for keys covered by range tombstones
+  const SequenceNumber tombstone = MaxCoveringTombstone(key, snapshot);
+
+  std::vector<MemTable*> mems;
+  RefMemTables(&mems);
+  Version* current = versions_->current();
+  current->Ref();
+
+  Table::ReadStats stats;
+
+  // Unlock while reading from files and memtables
+  {
+    mutex_.Unlock();
+    LookupKey lkey(key, snapshot);
+    if (GetFromMemTables(mems, lkey, &buf, 0, &s, tombstone)) {
+      // Done
+    } else {
+      current->Exists(options, lkey, &s, &stats, tombstone);
+    }
+    mutex_.Lock();
+  }
+
+  exists_blocks_avoided_ += stats.filter_rejects;
+  exists_blocks_read_ += stats.blocks_read;
+  UnrefMemTables(mems);
+  current->Unref();
+  return s;
+}
+
 Iterator* DBImpl::NewIterator(const ReadOptions& options) {
   SequenceNumber latest_snapshot;
   uint32_t seed;
@@ -1271,7 +1903,7 @@ Iterator* DBImpl::NewIterator(const ReadOptions& options) {
       (options.snapshot != NULL
            ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
            : latest_snapshot),
-      seed);
+      seed, options.iterate_lower_bound, options.iterate_upper_bound);
 }
 
 void DBImpl::RecordReadSample(Slice key) {
@@ -1302,6 +1934,19 @@ Status DBImpl::Delete(const WriteOptions& o, const Slice& key) {
   return DB::Delete(o, key);
 }
 
+Status DBImpl::DeleteRange(const WriteOptions& o, const Slice& begin,
+                           const Slice& end) {
+  const int r = user_comparator()->Compare(begin, end);
+  if (r > 0) {
+    return Status::InvalidArgument("begin key is after end key");
+  } else if (r == 0) {
+    return Status::OK();  // Empty range
+  }
+  WriteBatch batch;
+  batch.DeleteRange(begin, end);
+  return Write(o, &batch);
+}
+
 Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   if (my_batch == NULL) {
     // NULL batch is for memtable compaction
@@ -1382,6 +2027,7 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
         base->Unref();
 
         if (status.ok()) {
+          SaveRangeTombstones(mem, &edit);
           versions_->SetLastSequence(last_sequence);
           status = versions_->LogAndApply(&edit, &mutex_);
         }
@@ -1526,9 +2172,11 @@ Status DBImpl::MakeRoomForWrite(bool force) {
                mem_->ApproximateMemoryUsage() <= options_.write_buffer_size) {
       // There is room in current memtable
       break;
-    } else if (imm_ != NULL) {
+    } else if (imm_.size() >= size_t(options_.max_imm_memtables) ||
+               (options_.max_imm_memory != 0 &&
+                imm_usage_ >= options_.max_imm_memory)) {
       // We have filled up the current memtable, but the previous
-      // one is still being compacted, so we wait.
+      // ones are still being compacted, so we wait.
       Log(options_.info_log, "Current memtable full; waiting...\n");
       bg_cv_.Wait();
     } else if (!options_.disable_compaction &&
@@ -1558,8 +2206,7 @@ Status DBImpl::MakeRoomForWrite(bool force) {
 
       // Attempt to switch to a new memtable and
       // trigger compaction of old
-      imm_ = mem_;
-      has_imm_.Release_Store(imm_);
+      PushImmutableMemTable();
       mem_ = new MemTable(internal_comparator_);
       mem_->Ref();
       force = false;  // Do not force another compaction if have room
@@ -1653,6 +2300,18 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
+  } else if (in == "exists-blocks-avoided") {
+    char buf[50];
+    snprintf(buf, sizeof(buf), "%llu",
+             static_cast<unsigned long long>(exists_blocks_avoided_));
+    *value = buf;
+    return true;
+  } else if (in == "exists-blocks-read") {
+    char buf[50];
+    snprintf(buf, sizeof(buf), "%llu",
+             static_cast<unsigned long long>(exists_blocks_read_));
+    *value = buf;
+    return true;
   }
 
   return false;
@@ -17,10 +17,12 @@
 #include "pdlfs-common/port.h"
 
 #include "options_internal.h"
+#include "range_del.h"
 #include "write_batch_internal.h"
 
 #include <deque>
 #include <set>
+#include <vector>
 
 namespace pdlfs {
 
@@ -41,10 +43,13 @@ class DBImpl : public DB {
   virtual Status FlushMemTable(const FlushOptions&);
   virtual Status Put(const WriteOptions&, const Slice& key, const Slice& value);
   virtual Status Delete(const WriteOptions&, const Slice& key);
+  virtual Status DeleteRange(const WriteOptions&, const Slice& begin,
+                             const Slice& end);
   virtual Status Write(const WriteOptions&, WriteBatch* updates);
   virtual Status Get(const ReadOptions&, const Slice& key, std::string* value);
   virtual Status Get(const ReadOptions&, const Slice& key, Slice* value,
                      char* scratch, size_t scratch_size);
+  virtual Status Exists(const ReadOptions&, const Slice& key);
   virtual Iterator* NewIterator(const ReadOptions&);
   virtual const Snapshot* GetSnapshot();
   virtual void ReleaseSnapshot(const Snapshot* snapshot);
@@ -74,6 +79,14 @@ class DBImpl : public DB {
   // file at a level >= 1.
   int64_t TEST_MaxNextLevelOverlappingBytes();
 
+  // Return the number of live range tombstones, including those
+  // still held by memtables.
+  size_t TEST_NumRangeTombstones();
+
+  // Look up "lkey" the same way columns do.
+  Status TEST_Get(const ReadOptions& options, const LookupKey& lkey,
+                  Buffer* value);
+
   // Record a sample of bytes read at the specified internal key.
   // Samples are taken approximately once every config::kReadBytesPeriod
   // bytes.
@@ -92,6 +105,24 @@ class DBImpl : public DB {
   Iterator* NewInternalIterator(const ReadOptions&,
                                 SequenceNumber* latest_snapshot,
                                 uint32_t* seed);
+  // Return an iterator over the memtables and the current version that
+  // still yields entries deleted by range tombstones.  If "tombstones" is
+  // not NULL, append the range tombstones of the memtables to *tombstones.
+  // Those of the version are kept fragmented by the version itself.
+  // The result must be deleted without holding mutex_.
+  // REQUIRES: mutex_ has been locked.
+  Iterator* NewRawInternalIterator(const ReadOptions&,
+                                   RangeTombstoneList* tombstones);
+
+  // Return the sequence number of the newest range tombstone in the
+  // memtables or the current version that covers "key" and is visible at
+  // "snapshot", or 0 if there is none.
+  // REQUIRES: mutex_ has been locked.
+  SequenceNumber MaxCoveringTombstone(const Slice& key,
+                                      SequenceNumber snapshot);
+  // Record the range tombstones of "mem" in *edit so that they outlive
+  // the memtable once its contents have been written to a table.
+  static void SaveRangeTombstones(MemTable* mem, VersionEdit* edit);
 
   // Bulk insert a list of pre-ordered and pre-sequenced updates.
   Status BulkInsert(Iterator* updates);
@@ -117,6 +148,35 @@ class DBImpl : public DB {
   virtual Status RecoverLogFile(uint64_t log_number, VersionEdit* edit,
                                 SequenceNumber* max_sequence);
 
+  // Ref the active memtable and all immutable memtables, newest first.
+  // REQUIRES: mutex_ has been locked.
+  void RefMemTables(std::vector<MemTable*>* mems);
+  // Search memtables returned by RefMemTables() in order.
+  // Return true if a value or a deletion marker is found. Entries older
+  // than "tombstone" are treated as deleted.
+  static bool GetFromMemTables(const std::vector<MemTable*>& mems,
+                               const LookupKey& lkey, Buffer* value,
+                               size_t limit, Status* s,
+                               SequenceNumber tombstone = 0);
+  // REQUIRES: mutex_ has been locked.
+  static void UnrefMemTables(const std::vector<MemTable*>& mems);
+  // Seal the active memtable and append it to imm_.
+  // REQUIRES: mutex_ has been locked.
+  void PushImmutableMemTable();
+  // Drop the oldest "n" immutable memtables after they have been compacted.
+  // REQUIRES: mutex_ has been locked.
+  void PopImmutableMemTables(size_t n);
+  // Return an iterator over the oldest "n" immutable memtables.
+  Iterator* NewImmutableMemTableIterator(size_t n);
+
+  // Append to *obsolete the sequence number of each tombstone in
+  // "candidates" whose user key range holds no key in "mems" or "base".
+  // Candidates are sorted by begin key and checked through a single
+  // merged iterator, so nearby tombstones share seeks.
+  void FindEmptyTombstones(const std::vector<MemTable*>& mems, Version* base,
+                           std::vector<const RangeTombstone*>* candidates,
+                           std::vector<SequenceNumber>* obsolete);
+
   Status WriteMemTable(MemTable* mem, VersionEdit* edit, Version* base);
   Status WriteLevel0Table(Iterator* iter, VersionEdit* edit, Version* base,
                           SequenceNumber* min_seq, SequenceNumber* max_seq,
@@ -137,6 +197,8 @@ class DBImpl : public DB {
 
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
+  void CollectHotRanges(CompactionState* compact);
+  bool IsHotKey(CompactionState* compact, const Slice& user_key);
   Status InstallCompactionResults(CompactionState* compact);
 
   Status LoadLevel0Table(InsertionState* insert);
@@ -164,8 +226,16 @@ class DBImpl : public DB {
   port::AtomicPointer shutting_down_;
   port::CondVar bg_cv_;  // Signalled when background work finishes
   MemTable* mem_;
-  MemTable* imm_;                // Memtable being compacted
-  port::AtomicPointer has_imm_;  // So bg thread can detect non-NULL imm_
+  // Immutable memtables waiting to be compacted, oldest first. Each is
+  // paired with the number of the log file opened when it was sealed;
+  // all earlier logs become obsolete once it has been compacted.
+  struct ImmutableMemTable {
+    MemTable* mem;
+    uint64_t next_log_number;
+  };
+  std::deque<ImmutableMemTable> imm_;
+  size_t imm_usage_;             // Total memory used by memtables in imm_
+  port::AtomicPointer has_imm_;  // So bg thread can detect non-empty imm_
   WritableFile* logfile_;
   uint64_t logfile_number_;
   log::Writer* log_;
@@ -190,6 +260,15 @@ class DBImpl : public DB {
   // Has an outstanding bulk insertion request?
   bool bulk_insert_in_progress_;
 
+  // Data block reads avoided by filters and performed by Exists()
+  uint64_t exists_blocks_avoided_;
+  uint64_t exists_blocks_read_;
+
+  // Zstd dictionary for new Tables.  Trained once at the first memtable
+  // flush of this DB instance.
+  std::string compression_dict_;
+  bool compression_dict_sampled_;
+
   // Information for a manual compaction
   struct ManualCompaction {
     int level;
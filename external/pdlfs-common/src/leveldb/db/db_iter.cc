@@ -52,15 +52,20 @@ class DBIter : public Iterator {
   enum Direction { kForward, kReverse };
 
   DBIter(DBImpl* db, const Comparator* cmp, Iterator* iter, SequenceNumber s,
-         uint32_t seed)
+         uint32_t seed, const Slice* lower_bound, const Slice* upper_bound)
       : db_(db),
         user_comparator_(cmp),
         iter_(iter),
         sequence_(s),
+        has_lower_bound_(lower_bound != NULL),
+        has_upper_bound_(upper_bound != NULL),
         direction_(kForward),
         valid_(false),
         rnd_(seed),
-        bytes_counter_(RandomPeriod()) {}
+        bytes_counter_(RandomPeriod()) {
+    if (has_lower_bound_) lower_bound_ = lower_bound->ToString();
+    if (has_upper_bound_) upper_bound_ = upper_bound->ToString();
+  }
   virtual ~DBIter() { delete iter_; }
   virtual bool Valid() const { return valid_; }
   virtual Slice key() const {
@@ -90,6 +95,16 @@ class DBIter : public Iterator {
   void FindPrevUserEntry();
   bool ParseKey(ParsedInternalKey* key);
 
+  bool BeforeLowerBound(const Slice& user_key) const {
+    return has_lower_bound_ &&
+           user_comparator_->Compare(user_key, lower_bound_) < 0;
+  }
+
+  bool PastUpperBound(const Slice& user_key) const {
+    return has_upper_bound_ &&
+           user_comparator_->Compare(user_key, upper_bound_) >= 0;
+  }
+
   inline void SaveKey(const Slice& k, std::string* dst) {
     dst->assign(k.data(), k.size());
   }
@@ -110,6 +125,10 @@ class DBIter : public Iterator {
   const Comparator* const user_comparator_;
   Iterator* const iter_;
   SequenceNumber const sequence_;
+  std::string lower_bound_;
+  std::string upper_bound_;
+  const bool has_lower_bound_;
+  const bool has_upper_bound_;
 
   Status status_;
   std::string saved_key_;    // == current key when direction_==kReverse
@@ -176,7 +195,11 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
   assert(direction_ == kForward);
   do {
     ParsedInternalKey ikey;
-    if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+    if (!ParseKey(&ikey)) {
+      // Skip corrupted keys
+    } else if (PastUpperBound(ikey.user_key)) {
+      break;
+    } else if (ikey.sequence <= sequence_) {
       switch (ikey.type) {
         case kTypeDeletion:
           // Arrange to skip all upcoming entries for this key since
@@ -236,7 +259,11 @@ void DBIter::FindPrevUserEntry() {
   if (iter_->Valid()) {
     do {
       ParsedInternalKey ikey;
-      if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+      if (!ParseKey(&ikey)) {
+        // Skip corrupted keys
+      } else if (BeforeLowerBound(ikey.user_key)) {
+        break;  // Treated as the beginning of the DB
+      } else if (ikey.sequence <= sequence_) {
         if ((value_type != kTypeDeletion) &&
             user_comparator_->Compare(ikey.user_key, saved_key_) < 0) {
           // We encountered a non-deleted value in entries for previous keys,
@@ -276,7 +303,10 @@ void DBIter::Seek(const Slice& target) {
   ClearSavedValue();
   saved_key_.clear();
   AppendInternalKey(&saved_key_,
-                    ParsedInternalKey(target, sequence_, kValueTypeForSeek));
+                    ParsedInternalKey(BeforeLowerBound(target)
+                                          ? Slice(lower_bound_)
+                                          : target,
+                                      sequence_, kValueTypeForSeek));
   iter_->Seek(saved_key_);
   if (iter_->Valid()) {
     FindNextUserEntry(false, &saved_key_ /* temporary storage */);
@@ -286,6 +316,10 @@ void DBIter::Seek(const Slice& target) {
 }
 
 void DBIter::SeekToFirst() {
+  if (has_lower_bound_) {
+    Seek(lower_bound_);
+    return;
+  }
   direction_ = kForward;
   ClearSavedValue();
   iter_->SeekToFirst();
@@ -299,7 +333,20 @@ void DBIter::SeekToFirst() {
 void DBIter::SeekToLast() {
   direction_ = kReverse;
   ClearSavedValue();
-  iter_->SeekToLast();
+  if (has_upper_bound_) {
+    std::string target;
+    AppendInternalKey(&target, ParsedInternalKey(upper_bound_,
+                                                 kMaxSequenceNumber,
+                                                 kValueTypeForSeek));
+    iter_->Seek(target);
+    if (iter_->Valid()) {
+      iter_->Prev();
+    } else {
+      iter_->SeekToLast();
+    }
+  } else {
+    iter_->SeekToLast();
+  }
   FindPrevUserEntry();
 }
 
@@ -312,8 +359,11 @@ Iterator* NewDBIterator(
     const Comparator* user_key_comparator,
     Iterator* internal_iter,
     SequenceNumber sequence,
-    uint32_t seed) {
-  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed);
+    uint32_t seed,
+    const Slice* lower_bound,
+    const Slice* upper_bound) {
+  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed,
+                    lower_bound, upper_bound);
 }
 
 /* clang-format on */
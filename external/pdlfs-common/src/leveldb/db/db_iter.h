@@ -28,7 +28,9 @@ extern Iterator* NewDBIterator(
     const Comparator* user_key_comparator,
     Iterator* internal_iter,
     SequenceNumber sequence,
-    uint32_t seed
+    uint32_t seed,
+    const Slice* lower_bound = NULL,  // Inclusive
+    const Slice* upper_bound = NULL  // Exclusive
 );
 
 }  // namespace pdlfs
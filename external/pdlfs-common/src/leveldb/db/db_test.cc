@@ -9,6 +9,8 @@
  */
 
 #include "db_test.h"
+#include "../block.h"
+#include "../format.h"
 #include "db_impl.h"
 #include "version_set.h"
 #include "write_batch_internal.h"
@@ -17,6 +19,7 @@
 #include "pdlfs-common/dbfiles.h"
 #include "pdlfs-common/env.h"
 #include "pdlfs-common/hash.h"
+#include "pdlfs-common/leveldb/compaction_filter.h"
 #include "pdlfs-common/leveldb/db/db.h"
 #include "pdlfs-common/leveldb/filter_policy.h"
 #include "pdlfs-common/leveldb/table.h"
@@ -87,12 +90,17 @@ class SpecialEnv : public EnvWrapper {
   bool count_random_reads_;
   AtomicCounter random_read_counter_;
 
+  // Copy counted reads into the caller's buffer so blocks read from
+  // mmap'ed files can be cached
+  bool copy_random_reads_;
+
   explicit SpecialEnv(Env* base) : EnvWrapper(base) {
     delay_data_sync_.Release_Store(NULL);
     data_sync_error_.Release_Store(NULL);
     no_space_.Release_Store(NULL);
     non_writable_.Release_Store(NULL);
     count_random_reads_ = false;
+    copy_random_reads_ = false;
     manifest_sync_error_.Release_Store(NULL);
     manifest_write_error_.Release_Store(NULL);
   }
@@ -172,21 +180,27 @@ class SpecialEnv : public EnvWrapper {
      private:
       RandomAccessFile* target_;
       AtomicCounter* counter_;
+      bool copy_;
 
      public:
-      CountingFile(RandomAccessFile* target, AtomicCounter* counter)
-          : target_(target), counter_(counter) {}
+      CountingFile(RandomAccessFile* target, AtomicCounter* counter, bool copy)
+          : target_(target), counter_(counter), copy_(copy) {}
       virtual ~CountingFile() { delete target_; }
       virtual Status Read(uint64_t offset, size_t n, Slice* result,
                           char* scratch) const {
         counter_->Increment();
-        return target_->Read(offset, n, result, scratch);
+        Status s = target_->Read(offset, n, result, scratch);
+        if (s.ok() && copy_ && result->data() != scratch) {
+          memmove(scratch, result->data(), result->size());
+          *result = Slice(scratch, result->size());
+        }
+        return s;
       }
     };
 
     Status s = target()->NewRandomAccessFile(f, r);
     if (s.ok() && count_random_reads_) {
-      *r = new CountingFile(*r, &random_read_counter_);
+      *r = new CountingFile(*r, &random_read_counter_, copy_random_reads_);
     }
     return s;
   }
@@ -435,6 +449,56 @@ class DBTest {
     return static_cast<int>(files.size());
   }
 
+  // Return the total size of all table files. Set *num_tables to the
+  // number of table files and *num_with_dict to the number of those that
+  // carry a compression dictionary.
+  uint64_t TableFileBytes(int* num_tables, int* num_with_dict) {
+    uint64_t result = 0;
+    *num_tables = 0;
+    *num_with_dict = 0;
+    std::vector<std::string> files;
+    env_->GetChildren(dbname_.c_str(), &files);
+    uint64_t number;
+    FileType type;
+    for (size_t i = 0; i < files.size(); i++) {
+      if (ParseFileName(files[i], &number, &type) && type == kTableFile) {
+        const std::string fname = dbname_ + "/" + files[i];
+        uint64_t size;
+        ASSERT_OK(env_->GetFileSize(fname.c_str(), &size));
+        result += size;
+        ++*num_tables;
+        if (HasCompressionDict(fname, size)) {
+          ++*num_with_dict;
+        }
+      }
+    }
+    return result;
+  }
+
+  // Return true iff the metaindex block of the table has an entry
+  // for the compression dictionary.
+  bool HasCompressionDict(const std::string& fname, uint64_t size) {
+    RandomAccessFile* file;
+    ASSERT_OK(env_->NewRandomAccessFile(fname.c_str(), &file));
+    char scratch[Footer::kEncodedLength];
+    Slice input;
+    Footer footer;
+    ASSERT_OK(file->Read(size - Footer::kEncodedLength,
+                         Footer::kEncodedLength, &input, scratch));
+    ASSERT_OK(footer.DecodeFrom(&input));
+    BlockContents contents;
+    ASSERT_OK(
+        ReadBlock(file, ReadOptions(), footer.metaindex_handle(), &contents));
+    Block* meta = new Block(contents);
+    Iterator* iter = meta->NewIterator(BytewiseComparator());
+    iter->Seek("compression.dict");
+    const bool result = iter->Valid() && iter->key() == "compression.dict";
+    delete iter;
+    delete meta;
+    delete file;
+    return result;
+  }
+
   uint64_t Size(const Slice& start, const Slice& limit) {
     Range r(start, limit);
     uint64_t size;
@@ -582,6 +646,45 @@ TEST(DBTest, GetFromImmutableLayer) {
   } while (ChangeOptions());
 }
 
+static std::string Key(int i) {
+  char buf[100];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+  return std::string(buf);
+}
+
+TEST(DBTest, GetFromMultipleImmutableLayers) {
+  for (int merge = 0; merge < 2; merge++) {
+    Options options = CurrentOptions();
+    options.env = env_;
+    options.write_buffer_size = 100000;  // Small write buffer
+    options.max_imm_memtables = 4;
+    options.merge_imm_memtables = (merge != 0);
+    options.create_if_missing = true;
+    DestroyAndReopen(&options);
+
+    env_->delay_data_sync_.Release_Store(env_);  // Block sync calls
+    // Each put fills a memtable and seals the previous one; the queue
+    // absorbs them without waiting for the blocked compaction
+    for (int i = 0; i < 4; i++) {
+      ASSERT_OK(Put(Key(i), std::string(100000, 'a' + i)));
+    }
+    for (int i = 0; i < 4; i++) {
+      ASSERT_EQ(std::string(100000, 'a' + i), Get(Key(i)));
+    }
+    ASSERT_OK(Put(Key(0), "v2"));  // Newer than the queued version
+    ASSERT_EQ("v2", Get(Key(0)));
+    env_->delay_data_sync_.Release_Store(NULL);  // Release sync calls
+
+    ASSERT_OK(dbfull()->TEST_CompactMemTable());
+    ASSERT_EQ("v2", Get(Key(0)));
+    Reopen(&options);
+    ASSERT_EQ("v2", Get(Key(0)));
+    for (int i = 1; i < 4; i++) {
+      ASSERT_EQ(std::string(100000, 'a' + i), Get(Key(i)));
+    }
+  }
+}
+
 TEST(DBTest, GetFromVersions) {
   do {
     ASSERT_OK(Put("foo", "v1"));
@@ -879,6 +982,93 @@ TEST(DBTest, IterMultiWithDelete) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, IterBounds) {
+  do {
+    ASSERT_OK(Put("a", "va"));
+    ASSERT_OK(Put("c", "vc"));
+    dbfull()->TEST_CompactMemTable();
+    ASSERT_OK(Put("d", "vd"));
+    ASSERT_OK(Put("e", "ve"));
+    dbfull()->TEST_CompactRange(0, NULL, NULL);
+    ASSERT_OK(Put("f", "vf"));
+    ASSERT_OK(Put("g", "vg"));
+    ASSERT_OK(Delete("e"));
+
+    ReadOptions options;
+    Slice lower("b");
+    Slice upper("f");
+    options.iterate_lower_bound = &lower;
+    options.iterate_upper_bound = &upper;
+    Iterator* iter = db_->NewIterator(options);
+    iter->SeekToFirst();
+    ASSERT_EQ(IterStatus(iter), "c->vc");
+    iter->Next();
+    ASSERT_EQ(IterStatus(iter), "d->vd");
+    iter->Next();
+    ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+    iter->SeekToLast();
+    ASSERT_EQ(IterStatus(iter), "d->vd");
+    iter->Prev();
+    ASSERT_EQ(IterStatus(iter), "c->vc");
+    iter->Prev();
+    ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+    iter->Seek("a");
+    ASSERT_EQ(IterStatus(iter), "c->vc");
+    iter->Seek("f");
+    ASSERT_EQ(IterStatus(iter), "(invalid)");
+    delete iter;
+  } while (ChangeOptions());
+}
+
+TEST(DBTest, IterBoundsSkipTables) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(0);  // Prevent cache hits
+  Reopen(&options);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 100; j++) {
+      ASSERT_OK(Put(Key(1000 * i + j), "v"));
+    }
+    dbfull()->TEST_CompactMemTable();
+  }
+  ASSERT_EQ(TotalTableFiles(), 3);
+
+  // Count the reads needed to list the keys of the middle table
+  int reads[2];
+  for (int bounded = 0; bounded < 2; bounded++) {
+    Reopen(&options);
+    env_->count_random_reads_ = true;
+    env_->random_read_counter_.Reset();
+    std::string begin = Key(1000);
+    std::string end = Key(2000);
+    Slice lower = begin;
+    Slice upper = end;
+    ReadOptions read_options;
+    if (bounded) {
+      read_options.iterate_lower_bound = &lower;
+      read_options.iterate_upper_bound = &upper;
+    }
+    Iterator* iter = db_->NewIterator(read_options);
+    int n = 0;
+    for (iter->Seek(lower); iter->Valid() && iter->key().compare(upper) < 0;
+         iter->Next()) {
+      n++;
+    }
+    ASSERT_EQ(n, 100);
+    delete iter;
+    reads[bounded] = env_->random_read_counter_.Read();
+    env_->count_random_reads_ = false;
+  }
+  fprintf(stderr, "unbounded => %d reads, bounded => %d reads\n", reads[0],
+          reads[1]);
+  ASSERT_LT(reads[1], reads[0]);
+
+  Close();
+  delete options.block_cache;
+}
+
 TEST(DBTest, Recover) {
   do {
     ASSERT_OK(Put("foo", "v1"));
@@ -936,12 +1126,6 @@ TEST(DBTest, RecoverDuringMemtableCompaction) {
   } while (ChangeOptions());
 }
 
-static std::string Key(int i) {
-  char buf[100];
-  snprintf(buf, sizeof(buf), "key%06d", i);
-  return std::string(buf);
-}
-
 TEST(DBTest, MinorCompactionsHappen) {
   Options options = CurrentOptions();
   options.write_buffer_size = 10000;
@@ -1015,6 +1199,27 @@ TEST(DBTest, NoMemTable) {
   ASSERT_EQ("v5", Get("baz"));
 }
 
+TEST(DBTest, NoMemTableIterBoundsSkipAllTables) {
+  Options options = CurrentOptions();
+  options.no_memtable = true;
+  Reopen(&options);
+
+  ASSERT_OK(Put("a", "va"));
+  ASSERT_OK(Put("b", "vb"));
+
+  // Neither a memtable nor any table is left to iterate
+  ReadOptions read_options;
+  Slice lower("x");
+  Slice upper("z");
+  read_options.iterate_lower_bound = &lower;
+  read_options.iterate_upper_bound = &upper;
+  Iterator* iter = db_->NewIterator(read_options);
+  iter->SeekToFirst();
+  ASSERT_EQ(IterStatus(iter), "(invalid)");
+  ASSERT_OK(iter->status());
+  delete iter;
+}
+
 TEST(DBTest, NoLog) {
   Options options = CurrentOptions();
   options.disable_write_ahead_log = true;
@@ -1335,6 +1540,311 @@ TEST(DBTest, Snapshot) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, DeleteRange) {
+  do {
+    Put("a", "va");
+    Put("b", "vb");
+    Put("c", "vc");
+    Put("d", "vd");
+    dbfull()->TEST_CompactMemTable();
+    Put("c", "vc2");
+    const Snapshot* snapshot = db_->GetSnapshot();
+    ASSERT_OK(db_->DeleteRange(WriteOptions(), "b", "d"));
+    ASSERT_EQ("va", Get("a"));
+    ASSERT_EQ("NOT_FOUND", Get("b"));
+    ASSERT_EQ("NOT_FOUND", Get("c"));
+    ASSERT_EQ("vd", Get("d"));
+    ASSERT_EQ("(a->va)(d->vd)", Contents());
+    ASSERT_EQ("vb", Get("b", snapshot));
+    ASSERT_EQ("vc2", Get("c", snapshot));
+
+    Put("c", "vc3");  // Newer than the tombstone
+    ASSERT_EQ("vc3", Get("c"));
+    ASSERT_EQ("(a->va)(c->vc3)(d->vd)", Contents());
+    db_->ReleaseSnapshot(snapshot);
+
+    Reopen();
+    ASSERT_EQ("NOT_FOUND", Get("b"));
+    ASSERT_EQ("vc3", Get("c"));
+    ASSERT_EQ("(a->va)(c->vc3)(d->vd)", Contents());
+    Compact("a", "z");
+    ASSERT_EQ("(a->va)(c->vc3)(d->vd)", Contents());
+    ASSERT_EQ(AllEntriesFor("c"), "[ vc3 ]");
+  } while (ChangeOptions());
+}
+
+TEST(DBTest, DeleteRangeLookupKey) {
+  Put("a", "va");
+  Put("b", "vb");
+  dbfull()->TEST_CompactMemTable();
+  const Snapshot* snapshot = db_->GetSnapshot();
+  const SequenceNumber seq =
+      reinterpret_cast<const SnapshotImpl*>(snapshot)->number_;
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "a", "c"));
+  Put("b", "vb2");
+  std::string value;
+  buffer::StringBuf buf(&value);
+  ASSERT_TRUE(
+      dbfull()->TEST_Get(ReadOptions(), LookupKey("a", kMaxSequenceNumber),
+                         &buf).IsNotFound());
+  ASSERT_OK(dbfull()->TEST_Get(ReadOptions(),
+                               LookupKey("b", kMaxSequenceNumber), &buf));
+  ASSERT_EQ("vb2", value);
+  value.clear();
+  ASSERT_OK(dbfull()->TEST_Get(ReadOptions(), LookupKey("a", seq), &buf));
+  ASSERT_EQ("va", value);
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST(DBTest, DeleteRangeOverlapping) {
+  for (int i = 0; i < 10; i++) {
+    Put(std::string(1, 'a' + i), "v");
+  }
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "b", "f"));
+  const Snapshot* snapshot = db_->GetSnapshot();
+  Put("c", "v2");
+  Put("g", "v2");
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "d", "h"));
+  ASSERT_EQ(size_t(2), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(a->v)(c->v2)(h->v)(i->v)(j->v)", Contents());
+  ASSERT_EQ("NOT_FOUND", Get("e"));
+  ASSERT_EQ("v", Get("g", snapshot));
+  ASSERT_EQ("NOT_FOUND", Get("g"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(size_t(2), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(a->v)(c->v2)(h->v)(i->v)(j->v)", Contents());
+  ASSERT_EQ("v", Get("g", snapshot));
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST(DBTest, DeleteRangeTombstonesAreRemoved) {
+  Put("a", "va");
+  Put("x1", "v1");
+  Put("x2", "v2");
+  Put("z", "vz");
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "x", "y"));
+  ASSERT_EQ(size_t(1), dbfull()->TEST_NumRangeTombstones());
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("(a->va)(z->vz)", Contents());
+  int level = 0;
+  while (NumTableFilesAtLevel(level) == 0) level++;
+  ASSERT_EQ(1, NumTableFilesAtLevel(level));
+  // The first compaction drops the deleted keys and
+  // the next one drops the tombstone
+  dbfull()->TEST_CompactRange(level, NULL, NULL);
+  ASSERT_EQ(size_t(1), dbfull()->TEST_NumRangeTombstones());
+  dbfull()->TEST_CompactRange(level + 1, NULL, NULL);
+  ASSERT_EQ(size_t(0), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(a->va)(z->vz)", Contents());
+  Reopen();
+  ASSERT_EQ(size_t(0), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(a->va)(z->vz)", Contents());
+}
+
+// Tombstones are checked together. Only those whose ranges are empty go.
+TEST(DBTest, DeleteRangeSomeTombstonesAreRemoved) {
+  const char* keys[] = {"b1", "d1", "d2", "f1", "h1"};
+  for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+    Put(keys[i], "v");
+  }
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "h", "i"));
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "d", "e"));
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "b", "c"));
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), "f", "g"));
+  Put("f2", "v2");  // Newer than the tombstone of its range
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ(size_t(4), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(f2->v2)", Contents());
+  int level = 0;
+  while (NumTableFilesAtLevel(level) == 0) level++;
+  dbfull()->TEST_CompactRange(level, NULL, NULL);
+  dbfull()->TEST_CompactRange(level + 1, NULL, NULL);
+  ASSERT_EQ(size_t(1), dbfull()->TEST_NumRangeTombstones());
+  ASSERT_EQ("(f2->v2)", Contents());
+  ASSERT_EQ("NOT_FOUND", Get("f1"));
+  ASSERT_EQ("v2", Get("f2"));
+}
+
+namespace {
+class PrefixCompactionFilter : public CompactionFilter {
+ public:
+  virtual Decision Filter(int level, const Slice& key, const Slice& value,
+                          std::string* new_value) const {
+    if (key.starts_with("dead")) {
+      return kRemove;
+    } else if (key.starts_with("old")) {
+      *new_value = "new";
+      return kChangeValue;
+    } else {
+      return kKeep;
+    }
+  }
+
+  virtual const char* Name() const { return "test.PrefixCompactionFilter"; }
+};
+}  // namespace
+
+TEST(DBTest, CompactionFilter) {
+  PrefixCompactionFilter filter;
+  Options options = CurrentOptions();
+  options.compaction_filter = &filter;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  Put("dead1", "v1");
+  Put("keep", "v1");
+  Put("old1", "v1");
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("NOT_FOUND", Get("dead1"));
+  ASSERT_EQ("v1", Get("keep"));
+  ASSERT_EQ("new", Get("old1"));
+  ASSERT_EQ(AllEntriesFor("dead1"), "[ DEL ]");
+
+  // Keys visible to a snapshot are not filtered
+  Put("dead2", "v2");
+  const Snapshot* snapshot = db_->GetSnapshot();
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v2", Get("dead2"));
+  db_->ReleaseSnapshot(snapshot);
+
+  Compact("a", "z");
+  ASSERT_EQ("NOT_FOUND", Get("dead2"));
+  ASSERT_EQ(AllEntriesFor("dead1"), "[ ]");
+  ASSERT_EQ(AllEntriesFor("dead2"), "[ ]");
+  ASSERT_EQ("(keep->v1)(old1->new)", Contents());
+}
+
+TEST(DBTest, TieredCompaction) {
+  Options options = CurrentOptions();
+  options.compaction_style = kCompactionStyleTiered;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  for (int i = 0; i < 20; i++) {
+    char key[20];
+    snprintf(key, sizeof(key), "key%02d", i);
+    ASSERT_OK(Put(key, "v1"));
+    ASSERT_OK(Put("foo", key));
+    if (i > 0) {
+      snprintf(key, sizeof(key), "key%02d", i - 1);
+      ASSERT_OK(Delete(key));
+    }
+    dbfull()->TEST_CompactMemTable();
+    // All runs stay in level-0
+    ASSERT_EQ(NumTableFilesAtLevel(0), TotalTableFiles());
+    ASSERT_LE(NumTableFilesAtLevel(0), options.l0_hard_limit);
+  }
+
+  ASSERT_EQ("key19", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("key00"));
+  ASSERT_EQ("v1", Get("key19"));
+  Reopen(&options);
+  ASSERT_EQ("key19", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("key18"));
+  ASSERT_EQ("(foo->key19)(key19->v1)", Contents());
+
+  // A full compaction merges all runs into one
+  Compact("a", "z");
+  ASSERT_EQ(NumTableFilesAtLevel(0), 1);
+  ASSERT_EQ(TotalTableFiles(), 1);
+  ASSERT_EQ(AllEntriesFor("foo"), "[ key19 ]");
+  ASSERT_EQ(AllEntriesFor("key00"), "[ ]");
+  ASSERT_EQ("(foo->key19)(key19->v1)", Contents());
+}
+
+TEST(DBTest, CompactionReadaheadAndDirectWrites) {
+  Options options = CurrentOptions();
+  options.compaction_readahead_size = 64 << 10;
+  options.compaction_direct_writes = true;
+  options.write_buffer_size = 100000;
+  options.create_if_missing = true;
+  DestroyAndReopen(&options);
+
+  Random rnd(301);
+  std::map<std::string, std::string> model;
+  for (int i = 0; i < 2000; i++) {
+    char key[20];
+    snprintf(key, sizeof(key), "key%06d", static_cast<int>(rnd.Uniform(500)));
+    std::string value = RandomString(&rnd, 1000);
+    ASSERT_OK(Put(key, value));
+    model[key] = value;
+  }
+  Compact("a", "z");
+  ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+
+  Reopen(&options);
+  for (std::map<std::string, std::string>::iterator it = model.begin();
+       it != model.end(); ++it) {
+    ASSERT_EQ(it->second, Get(it->first));
+  }
+}
+
+static bool ZstdCompressionSupported() {
+  port::ZstdCompressor* compressor = port::Zstd_NewCompressor(NULL, 0);
+  if (compressor == NULL) {
+    return false;
+  }
+  port::Zstd_DeleteCompressor(compressor);
+  return true;
+}
+
+TEST(DBTest, ZstdDictionaryCompression) {
+  if (!ZstdCompressionSupported()) {
+    fprintf(stderr, "skipping zstd tests\n");
+    return;
+  }
+
+  Options options = CurrentOptions();
+  options.compression = kZstdCompression;
+  options.write_buffer_size = 100000;
+  options.create_if_missing = true;
+
+  // Write the same records without and with a dictionary
+  std::map<std::string, std::string> model;
+  uint64_t bytes[2];
+  for (int use_dict = 0; use_dict < 2; use_dict++) {
+    options.compression_dict_size = use_dict ? (4 << 10) : 0;
+    DestroyAndReopen(&options);
+    // Records with a common structure so the dictionary has something to
+    // learn
+    for (int i = 0; i < 3000; i++) {
+      char key[20];
+      snprintf(key, sizeof(key), "key%06d", i);
+      char value[100];
+      snprintf(value, sizeof(value),
+               "{\"uid\":%d,\"gid\":%d,\"mode\":\"0644\",\"size\":%d}",
+               i % 7, i % 5, i * 13);
+      ASSERT_OK(Put(key, value));
+      model[key] = value;
+    }
+    Compact("a", "z");
+    ASSERT_EQ(NumTableFilesAtLevel(0), 0);
+    int num_tables;
+    int num_with_dict;
+    bytes[use_dict] = TableFileBytes(&num_tables, &num_with_dict);
+    ASSERT_GT(num_tables, 0);
+    ASSERT_EQ(num_with_dict, use_dict ? num_tables : 0);
+  }
+  fprintf(stderr, "%llu bytes without dict, %llu bytes with dict\n",
+          static_cast<unsigned long long>(bytes[0]),
+          static_cast<unsigned long long>(bytes[1]));
+  ASSERT_LT(bytes[1], bytes[0]);
+
+  Reopen(&options);
+  for (std::map<std::string, std::string>::iterator it = model.begin();
+       it != model.end(); ++it) {
+    ASSERT_EQ(it->second, Get(it->first));
+  }
+
+  // Tables written with a dictionary remain readable after it is disabled
+  options.compression_dict_size = 0;
+  Reopen(&options);
+  ASSERT_OK(Put("key000000", "new"));
+  Compact("a", "z");
+  ASSERT_EQ("new", Get("key000000"));
+  ASSERT_EQ(model["key002999"], Get("key002999"));
+}
+
 TEST(DBTest, HiddenValuesAreRemoved) {
   do {
     Random rnd(301);
@@ -1869,6 +2379,138 @@ TEST(DBTest, BloomFilter) {
   delete options.filter_policy;
 }
 
+TEST(DBTest, ExistsUsesFilters) {
+  env_->count_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(0);  // Prevent cache hits
+  options.filter_policy = NewBloomFilterPolicy(10);
+  Reopen(&options);
+
+  const int N = 10000;
+  for (int i = 0; i < N; i++) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Compact("a", "z");
+  for (int i = 0; i < N; i += 100) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_OK(Put(Key(N), "mem"));
+  env_->delay_data_sync_.Release_Store(env_);
+
+  // Missing keys should almost never touch a data block
+  env_->random_read_counter_.Reset();
+  for (int i = 0; i < N; i++) {
+    ASSERT_TRUE(db_->Exists(ReadOptions(), Key(i) + ".missing").IsNotFound());
+  }
+  int reads = env_->random_read_counter_.Read();
+  fprintf(stderr, "%d missing => %d reads\n", N, reads);
+  ASSERT_LE(reads, 3 * N / 100);
+
+  // Present keys need one data block read each
+  env_->random_read_counter_.Reset();
+  for (int i = 0; i < N; i++) {
+    Status s = db_->Exists(ReadOptions(), Key(i));
+    if (i % 100 == 0) {
+      ASSERT_TRUE(s.IsNotFound());  // Deleted in the memtable
+    } else {
+      ASSERT_OK(s);
+    }
+  }
+  reads = env_->random_read_counter_.Read();
+  ASSERT_LE(reads, N);
+  ASSERT_OK(db_->Exists(ReadOptions(), Key(N)));
+
+  std::string avoided;
+  std::string read;
+  ASSERT_TRUE(db_->GetProperty("leveldb.exists-blocks-avoided", &avoided));
+  ASSERT_TRUE(db_->GetProperty("leveldb.exists-blocks-read", &read));
+  ASSERT_GE(atoi(avoided.c_str()), N - 3 * N / 100);
+  ASSERT_GE(atoi(read.c_str()), N - N / 100);
+
+  env_->delay_data_sync_.Release_Store(NULL);
+  Close();
+  delete options.block_cache;
+  delete options.filter_policy;
+}
+
+TEST(DBTest, ExistsSkipsCachedBlocks) {
+  env_->count_random_reads_ = true;
+  env_->copy_random_reads_ = true;
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.block_cache = NewLRUCache(8 << 20);
+  options.filter_policy = NewBloomFilterPolicy(10);
+  Reopen(&options);
+
+  const int N = 1000;
+  for (int i = 0; i < N; i++) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Compact("a", "z");
+  std::string read[2];
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < N; i++) {
+      ASSERT_OK(db_->Exists(ReadOptions(), Key(i)));
+    }
+    ASSERT_TRUE(db_->GetProperty("leveldb.exists-blocks-read", &read[pass]));
+  }
+  // The second pass is served entirely from the block cache
+  ASSERT_GT(atoi(read[0].c_str()), 0);
+  ASSERT_EQ(read[1], read[0]);
+
+  env_->count_random_reads_ = false;
+  env_->copy_random_reads_ = false;
+  Close();
+  delete options.block_cache;
+  delete options.filter_policy;
+}
+
+TEST(DBTest, CompactionCacheWarmup) {
+  int reads[2];
+  for (int warmup = 0; warmup < 2; warmup++) {
+    Options options = CurrentOptions();
+    options.env = env_;
+    options.block_cache = NewLRUCache(8 << 20);
+    options.compaction_cache_warmup_size = warmup ? (1 << 20) : 0;
+    options.create_if_missing = true;
+    env_->count_random_reads_ = true;
+    env_->copy_random_reads_ = true;
+    DestroyAndReopen(&options);
+
+    const int N = 2000;
+    Random rnd(301);
+    for (int round = 0; round < 2; round++) {
+      for (int i = round; i < N; i += 2) {
+        ASSERT_OK(Put(Key(i), RandomString(&rnd, 100)));
+      }
+      dbfull()->TEST_CompactMemTable();
+    }
+
+    // Make the first 100 keys hot
+    for (int i = 0; i < 100; i++) {
+      ASSERT_NE("NOT_FOUND", Get(Key(i)));
+    }
+
+    Compact("a", "z");
+    ASSERT_EQ(TotalTableFiles(), 1);
+    env_->random_read_counter_.Reset();
+    for (int i = 0; i < 100; i++) {
+      ASSERT_NE("NOT_FOUND", Get(Key(i)));
+    }
+    reads[warmup] = env_->random_read_counter_.Read();
+    env_->count_random_reads_ = false;
+    env_->copy_random_reads_ = false;
+
+    Close();
+    delete options.block_cache;
+  }
+  fprintf(stderr, "hot reads after compaction: %d cold, %d warm\n", reads[0],
+          reads[1]);
+  ASSERT_GT(reads[0], 0);
+  ASSERT_EQ(reads[1], 0);
+}
+
 // Multi-threaded test:
 namespace {
 
@@ -2008,6 +2650,12 @@ class ModelDB : public EmptyDB {
         (*map_)[key.ToString()] = value.ToString();
       }
       virtual void Delete(const Slice& key) { map_->erase(key.ToString()); }
+      virtual void DeleteRange(const Slice& begin, const Slice& end) {
+        if (begin.compare(end) < 0) {
+          map_->erase(map_->lower_bound(begin.ToString()),
+                      map_->lower_bound(end.ToString()));
+        }
+      }
     };
     Handler handler;
     handler.map_ = &map_;
@@ -14,6 +14,7 @@
 
 #include "pdlfs-common/coding.h"
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/mutexlock.h"
 
 namespace pdlfs {
 
@@ -25,9 +26,16 @@ static Slice GetLengthPrefixedSlice(const char* data) {
 }
 
 MemTable::MemTable(const InternalKeyComparator& cmp)
-    : comparator_(cmp), refs_(0), table_(comparator_, &arena_) {}
-
-MemTable::~MemTable() { assert(refs_ == 0); }
+    : comparator_(cmp),
+      refs_(0),
+      table_(comparator_, &arena_),
+      fragments_(NULL),
+      has_tombstones_(NULL) {}
+
+MemTable::~MemTable() {
+  assert(refs_ == 0);
+  delete fragments_;
+}
 
 size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
 
@@ -103,7 +111,46 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
   table_.Insert(buf);
 }
 
-bool MemTable::Get(const LookupKey& key, Buffer* buf, size_t limit, Status* s) {
+void MemTable::AddRangeTombstone(SequenceNumber s, const Slice& begin,
+                                 const Slice& end) {
+  const Comparator* ucmp = comparator_.comparator.user_comparator();
+  if (ucmp->Compare(begin, end) >= 0) {
+    return;  // Empty ranges delete nothing
+  }
+  RangeTombstone t;
+  t.begin = begin.ToString();
+  t.end = end.ToString();
+  t.seq = s;
+  MutexLock l(&tombstones_mu_);
+  tombstones_.push_back(t);
+  delete fragments_;
+  fragments_ = NULL;
+  has_tombstones_.Release_Store(this);
+}
+
+SequenceNumber MemTable::MaxCoveringTombstone(const Slice& user_key,
+                                              SequenceNumber snapshot) {
+  if (has_tombstones_.Acquire_Load() == NULL) {
+    return 0;
+  }
+  MutexLock l(&tombstones_mu_);
+  if (fragments_ == NULL) {
+    fragments_ = new FragmentedRangeTombstoneList(
+        comparator_.comparator.user_comparator(), tombstones_);
+  }
+  return fragments_->MaxCoveringTombstone(user_key, snapshot);
+}
+
+void MemTable::GetRangeTombstones(RangeTombstoneList* result) {
+  if (has_tombstones_.Acquire_Load() == NULL) {
+    return;
+  }
+  MutexLock l(&tombstones_mu_);
+  result->insert(result->end(), tombstones_.begin(), tombstones_.end());
+}
+
+bool MemTable::Get(const LookupKey& key, Buffer* buf, size_t limit, Status* s,
+                   SequenceNumber tombstone) {
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
   iter.Seek(memkey.data());
@@ -125,6 +172,10 @@ bool MemTable::Get(const LookupKey& key, Buffer* buf, size_t limit, Status* s) {
     if (ucmp->Compare(Slice(key_ptr, key_length - 8), key.user_key()) == 0) {
       // Correct user key
       const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+      if ((tag >> 8) < tombstone) {
+        *s = Status::NotFound(Slice());
+        return true;
+      }
       switch (static_cast<ValueType>(tag & 0xff)) {
         case kTypeValue: {
           Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
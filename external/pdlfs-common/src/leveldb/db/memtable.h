@@ -13,10 +13,12 @@
 #include <string>
 
 #include "../skiplist.h"
+#include "range_del.h"
 
 #include "pdlfs-common/arena.h"
 #include "pdlfs-common/leveldb/db/dbformat.h"
 #include "pdlfs-common/leveldb/iterator.h"
+#include "pdlfs-common/port.h"
 
 namespace pdlfs {
 
@@ -63,10 +65,25 @@ class MemTable {
            const Slice& value);
 
   // If memtable contains a value for key, store a prefix of it in *value
-  // and return true. If memtable contains a deletion for key,
-  // store a NotFound() error in *status and return true.
+  // and return true. If memtable contains a deletion for key, or the
+  // newest entry for key is older than "tombstone" and thus deleted by a
+  // range tombstone, store a NotFound() error in *status and return true.
   // Else, return false.
-  bool Get(const LookupKey& key, Buffer* value, size_t limit, Status* s);
+  bool Get(const LookupKey& key, Buffer* value, size_t limit, Status* s,
+           SequenceNumber tombstone = 0);
+
+  // Add a range tombstone that deletes all keys in [begin, end) written
+  // before the specified sequence number.
+  void AddRangeTombstone(SequenceNumber seq, const Slice& begin,
+                         const Slice& end);
+
+  // Return the sequence number of the newest range tombstone that covers
+  // "user_key" and is visible at "snapshot", or 0 if there is none.
+  SequenceNumber MaxCoveringTombstone(const Slice& user_key,
+                                      SequenceNumber snapshot);
+
+  // Append all range tombstones added so far to *result.
+  void GetRangeTombstones(RangeTombstoneList* result);
 
  private:
   ~MemTable();  // Private since only Unref() should be used to delete it
@@ -85,6 +102,17 @@ class MemTable {
   Arena arena_;
   Table table_;
 
+  // Range tombstones are kept aside from the skiplist. They are added by
+  // the writer while readers may be looking them up, so they are
+  // protected by their own lock.
+  port::Mutex tombstones_mu_;
+  RangeTombstoneList tombstones_;
+  // Rebuilt on demand after new tombstones are added
+  FragmentedRangeTombstoneList* fragments_;
+  // Non-NULL iff tombstones_ is not empty. Lets lookups skip the lock
+  // in the common case where there is no range tombstone.
+  port::AtomicPointer has_tombstones_;
+
   // No copying allowed
   MemTable(const MemTable&);
   void operator=(const MemTable&);
@@ -11,6 +11,7 @@
 #include "pdlfs-common/cache.h"
 #include "pdlfs-common/dbfiles.h"
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/leveldb/compaction_filter.h"
 #include "pdlfs-common/leveldb/comparator.h"
 #include "pdlfs-common/leveldb/filter_policy.h"
 
@@ -18,6 +19,8 @@
 
 namespace pdlfs {
 
+CompactionFilter::~CompactionFilter() {}
+
 DBOptions::DBOptions()
     : comparator(BytewiseComparator()),
       create_if_missing(false),
@@ -27,6 +30,9 @@ DBOptions::DBOptions()
       info_log(NULL),
       compaction_pool(NULL),
       write_buffer_size(4 << 20),
+      max_imm_memtables(1),
+      max_imm_memory(0),
+      merge_imm_memtables(false),
       table_cache(NULL),
       block_cache(NULL),
       block_size(4096),
@@ -34,12 +40,15 @@ DBOptions::DBOptions()
       block_restart_interval(16),
       index_block_restart_interval(1),
       compression(kSnappyCompression),
+      compression_dict_size(0),
       filter_policy(NULL),
+      compaction_filter(NULL),
       no_memtable(false),
       gc_skip_deletion(false),
       skip_lock_file(false),
       rotating_manifest(false),
       disable_write_ahead_log(false),
+      tail_write_ahead_log(false),
       disable_compaction(false),
       disable_seek_compaction(false),
       table_file_size(2 * 1048576),
@@ -47,13 +56,20 @@ DBOptions::DBOptions()
       l1_compaction_trigger(5),
       l0_compaction_trigger(4),
       l0_soft_limit(8),
-      l0_hard_limit(12) {}
+      l0_hard_limit(12),
+      compaction_style(kCompactionStyleLeveled),
+      tiered_size_ratio(1),
+      compaction_readahead_size(0),
+      compaction_direct_writes(false),
+      compaction_cache_warmup_size(0) {}
 
 ReadOptions::ReadOptions()
     : verify_checksums(false),
       fill_cache(true),
       limit(1 << 30),
-      snapshot(NULL) {}
+      snapshot(NULL),
+      iterate_lower_bound(NULL),
+      iterate_upper_bound(NULL) {}
 
 WriteOptions::WriteOptions() : sync(false) {}
 
@@ -84,7 +100,13 @@ DBOptions SanitizeOptions(const std::string& dbname,
   ClipToRange(&result.block_restart_interval, 1, 1024);
   ClipToRange(&result.index_block_restart_interval, 1, 1024);
   ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
+  ClipToRange(&result.max_imm_memtables, 1, 64);
   ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.tiered_size_ratio, 0, 1000);
+  if (result.compaction_style == kCompactionStyleTiered) {
+    // Runs are only merged by size
+    result.disable_seek_compaction = true;
+  }
   if (create_infolog && result.info_log == NULL) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname.c_str());  // In case it does not exist
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2015-2018 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include "range_del.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "pdlfs-common/leveldb/comparator.h"
+#include "pdlfs-common/leveldb/iterator.h"
+
+namespace pdlfs {
+
+namespace {
+struct TombstoneBeginLess {
+  const Comparator* ucmp;
+  bool operator()(const RangeTombstone* a, const RangeTombstone* b) const {
+    return ucmp->Compare(a->begin, b->begin) < 0;
+  }
+};
+
+struct KeyLess {
+  const Comparator* ucmp;
+  bool operator()(const std::string& a, const std::string& b) const {
+    return ucmp->Compare(a, b) < 0;
+  }
+};
+
+struct KeyEqual {
+  const Comparator* ucmp;
+  bool operator()(const std::string& a, const std::string& b) const {
+    return ucmp->Compare(a, b) == 0;
+  }
+};
+}  // namespace
+
+FragmentedRangeTombstoneList::FragmentedRangeTombstoneList(
+    const Comparator* ucmp, const RangeTombstoneList& list)
+    : ucmp_(ucmp) {
+  // Every begin and end key is a fragment boundary
+  std::vector<const RangeTombstone*> sorted;
+  std::vector<std::string> points;
+  for (size_t i = 0; i < list.size(); i++) {
+    const RangeTombstone& t = list[i];
+    if (ucmp_->Compare(t.begin, t.end) < 0) {  // Skip empty ranges
+      sorted.push_back(&t);
+      points.push_back(t.begin);
+      points.push_back(t.end);
+    }
+  }
+  TombstoneBeginLess tombstone_less;
+  tombstone_less.ucmp = ucmp_;
+  std::sort(sorted.begin(), sorted.end(), tombstone_less);
+  KeyLess key_less;
+  key_less.ucmp = ucmp_;
+  std::sort(points.begin(), points.end(), key_less);
+  KeyEqual key_equal;
+  key_equal.ucmp = ucmp_;
+  points.erase(std::unique(points.begin(), points.end(), key_equal),
+               points.end());
+
+  // Sweep the boundaries from left to right while keeping track of the
+  // tombstones that cover the current fragment
+  std::vector<const RangeTombstone*> active;
+  size_t next = 0;
+  for (size_t i = 0; i + 1 < points.size(); i++) {
+    const std::string& point = points[i];
+    size_t n = 0;
+    for (size_t j = 0; j < active.size(); j++) {
+      if (ucmp_->Compare(point, active[j]->end) < 0) {
+        active[n++] = active[j];
+      }
+    }
+    active.resize(n);
+    while (next < sorted.size() &&
+           ucmp_->Compare(sorted[next]->begin, point) <= 0) {
+      active.push_back(sorted[next++]);
+    }
+    if (!active.empty()) {
+      Fragment f;
+      f.begin = point;
+      f.end = points[i + 1];
+      f.seq_start = seqs_.size();
+      for (size_t j = 0; j < active.size(); j++) {
+        seqs_.push_back(active[j]->seq);
+      }
+      f.seq_limit = seqs_.size();
+      std::sort(seqs_.begin() + f.seq_start, seqs_.end(),
+                std::greater<SequenceNumber>());
+      fragments_.push_back(f);
+    }
+  }
+}
+
+SequenceNumber FragmentedRangeTombstoneList::MaxCoveringTombstone(
+    const Slice& user_key, SequenceNumber snapshot) const {
+  // Find the last fragment that begins at or before "user_key"
+  size_t left = 0;
+  size_t right = fragments_.size();
+  while (left < right) {
+    const size_t mid = (left + right) / 2;
+    if (ucmp_->Compare(fragments_[mid].begin, user_key) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  if (left == 0) {
+    return 0;
+  }
+  const Fragment& f = fragments_[left - 1];
+  if (ucmp_->Compare(user_key, f.end) >= 0) {
+    return 0;
+  }
+  // Find the newest tombstone that is visible at "snapshot"
+  std::vector<SequenceNumber>::const_iterator limit =
+      seqs_.begin() + f.seq_limit;
+  std::vector<SequenceNumber>::const_iterator it =
+      std::lower_bound(seqs_.begin() + f.seq_start, limit, snapshot,
+                       std::greater<SequenceNumber>());
+  return it != limit ? *it : 0;
+}
+
+Status GetNewerThanTombstone(const Comparator* ucmp, Iterator* internal_iter,
+                             const Slice& user_key, SequenceNumber snapshot,
+                             SequenceNumber tombstone, Buffer* value,
+                             size_t limit) {
+  Status s;
+  LookupKey lkey(user_key, snapshot);
+  internal_iter->Seek(lkey.internal_key());
+  if (internal_iter->Valid()) {
+    ParsedInternalKey ikey;
+    if (!ParseInternalKey(internal_iter->key(), &ikey)) {
+      s = Status::Corruption("corrupted internal key");
+    } else if (ucmp->Compare(ikey.user_key, user_key) != 0 ||
+               ikey.sequence < tombstone || ikey.type != kTypeValue) {
+      s = Status::NotFound(Slice());
+    } else {
+      Slice v = internal_iter->value();
+      value->Fill(v.data(), std::min(v.size(), limit));
+    }
+  } else {
+    s = internal_iter->status();
+    if (s.ok()) {
+      s = Status::NotFound(Slice());
+    }
+  }
+  return s;
+}
+
+namespace {
+
+// Skips entries deleted by range tombstones. Entries that are not
+// covered by any tombstone are passed through unchanged, so the result
+// is still an internal iterator.
+class RangeDelIterator : public Iterator {
+ public:
+  RangeDelIterator(const InternalKeyComparator* icmp, Iterator* iter,
+                   const FragmentedRangeTombstoneList* fragments,
+                   const RangeTombstoneList& list, SequenceNumber snapshot)
+      : iter_(iter),
+        fragments_(fragments),
+        tombstones_(icmp->user_comparator(), list),
+        snapshot_(snapshot) {}
+
+  virtual ~RangeDelIterator() { delete iter_; }
+
+  virtual bool Valid() const { return iter_->Valid(); }
+  virtual Slice key() const { return iter_->key(); }
+  virtual Slice value() const { return iter_->value(); }
+  virtual Status status() const { return iter_->status(); }
+
+  virtual void SeekToFirst() {
+    iter_->SeekToFirst();
+    SkipForward();
+  }
+
+  virtual void SeekToLast() {
+    iter_->SeekToLast();
+    SkipBackward();
+  }
+
+  virtual void Seek(const Slice& target) {
+    iter_->Seek(target);
+    SkipForward();
+  }
+
+  virtual void Next() {
+    iter_->Next();
+    SkipForward();
+  }
+
+  virtual void Prev() {
+    iter_->Prev();
+    SkipBackward();
+  }
+
+ private:
+  bool IsDeleted() const {
+    ParsedInternalKey ikey;
+    if (!ParseInternalKey(iter_->key(), &ikey)) {
+      return false;  // Let the caller deal with the corruption
+    }
+    return ikey.sequence <
+               fragments_->MaxCoveringTombstone(ikey.user_key, snapshot_) ||
+           ikey.sequence <
+               tombstones_.MaxCoveringTombstone(ikey.user_key, snapshot_);
+  }
+
+  void SkipForward() {
+    while (iter_->Valid() && IsDeleted()) {
+      iter_->Next();
+    }
+  }
+
+  void SkipBackward() {
+    while (iter_->Valid() && IsDeleted()) {
+      iter_->Prev();
+    }
+  }
+
+  Iterator* const iter_;
+  const FragmentedRangeTombstoneList* const fragments_;
+  const FragmentedRangeTombstoneList tombstones_;
+  const SequenceNumber snapshot_;
+
+  // No copying allowed
+  RangeDelIterator(const RangeDelIterator&);
+  void operator=(const RangeDelIterator&);
+};
+
+}  // namespace
+
+Iterator* NewRangeDelIterator(const InternalKeyComparator* icmp,
+                              Iterator* internal_iter,
+                              const FragmentedRangeTombstoneList* fragments,
+                              const RangeTombstoneList& list,
+                              SequenceNumber snapshot) {
+  if (fragments->empty() && list.empty()) {
+    return internal_iter;
+  } else {
+    return new RangeDelIterator(icmp, internal_iter, fragments, list,
+                                snapshot);
+  }
+}
+
+}  // namespace pdlfs
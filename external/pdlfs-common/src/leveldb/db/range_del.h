@@ -0,0 +1,92 @@
+#pragma once
+
+/*
+ * Copyright (c) 2015-2018 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include <string>
+#include <vector>
+
+#include "pdlfs-common/leveldb/db/dbformat.h"
+#include "pdlfs-common/status.h"
+
+namespace pdlfs {
+
+class Comparator;
+class Iterator;
+
+// A range tombstone hides all keys in [begin, end) that were written
+// before it. Tombstones are written through WriteBatch like any other
+// update, so they are logged and replayed with the WAL and held by the
+// memtable. When a memtable is flushed its tombstones move to the
+// MANIFEST instead of the tables, so a whole key range can be deleted
+// with a single record.
+struct RangeTombstone {
+  std::string begin;
+  std::string end;  // Exclusive
+  SequenceNumber seq;
+};
+
+typedef std::vector<RangeTombstone> RangeTombstoneList;
+
+// An immutable view of a list of range tombstones. Overlapping tombstones
+// are split into non-overlapping fragments sorted by begin key, so the
+// tombstones covering a key can be found with a binary search.
+class FragmentedRangeTombstoneList {
+ public:
+  FragmentedRangeTombstoneList() : ucmp_(NULL) {}
+  FragmentedRangeTombstoneList(const Comparator* ucmp,
+                               const RangeTombstoneList& list);
+
+  bool empty() const { return fragments_.empty(); }
+
+  // Return the sequence number of the newest tombstone that covers
+  // "user_key" and is visible at "snapshot", or 0 if there is none.
+  // Entries of "user_key" older than the result are deleted.
+  SequenceNumber MaxCoveringTombstone(const Slice& user_key,
+                                      SequenceNumber snapshot) const;
+
+ private:
+  struct Fragment {
+    std::string begin;
+    std::string end;  // Exclusive
+    // Sequence numbers of the tombstones covering this fragment are
+    // stored in seqs_[seq_start, seq_limit) in decreasing order
+    size_t seq_start;
+    size_t seq_limit;
+  };
+
+  const Comparator* ucmp_;
+  std::vector<Fragment> fragments_;
+  std::vector<SequenceNumber> seqs_;
+};
+
+// Look up the newest entry of "user_key" in "*internal_iter" that is
+// visible at "snapshot" and newer than "tombstone". Store up to "limit"
+// bytes of its value in *value and return OK on success. Return NotFound
+// if there is no such entry or the entry is a deletion marker.
+// The caller retains the ownership of "*internal_iter".
+extern Status GetNewerThanTombstone(const Comparator* ucmp,
+                                    Iterator* internal_iter,
+                                    const Slice& user_key,
+                                    SequenceNumber snapshot,
+                                    SequenceNumber tombstone, Buffer* value,
+                                    size_t limit);
+
+// Return a new iterator that yields the entries of "*internal_iter" that
+// are not deleted by any tombstone in "*fragments" or "list" visible at
+// "snapshot". "*fragments" is used as is and must remain live while the
+// result is in use. "list" is fragmented again by the result, so it
+// should be short, e.g. the tombstones of the memtables.
+// The result takes the ownership of "*internal_iter".
+extern Iterator* NewRangeDelIterator(
+    const InternalKeyComparator* icmp, Iterator* internal_iter,
+    const FragmentedRangeTombstoneList* fragments,
+    const RangeTombstoneList& list, SequenceNumber snapshot);
+
+}  // namespace pdlfs
@@ -29,6 +29,11 @@ Status ReadonlyDB::Delete(const WriteOptions&, const Slice& k) {
   return Status::ReadOnly(Slice());
 }
 
+Status ReadonlyDB::DeleteRange(const WriteOptions&, const Slice& b,
+                               const Slice& e) {
+  return Status::ReadOnly(Slice());
+}
+
 Status ReadonlyDB::Write(const WriteOptions&, WriteBatch* updates) {
   return Status::ReadOnly(Slice());
 }
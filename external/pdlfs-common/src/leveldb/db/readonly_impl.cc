@@ -10,8 +10,11 @@
 #include "readonly_impl.h"
 #include "../merger.h"
 #include "db_iter.h"
+#include "memtable.h"
+#include "range_del.h"
 #include "table_cache.h"
 #include "version_set.h"
+#include "write_batch_internal.h"
 
 #include "pdlfs-common/dbfiles.h"
 #include "pdlfs-common/env.h"
@@ -20,6 +23,8 @@
 #include "pdlfs-common/port.h"
 #include "pdlfs-common/status.h"
 
+#include <algorithm>
+
 namespace pdlfs {
 
 ReadonlyDBImpl::ReadonlyDBImpl(const Options& raw_options,
@@ -33,7 +38,12 @@ ReadonlyDBImpl::ReadonlyDBImpl(const Options& raw_options,
       owns_table_cache_(options_.table_cache != raw_options.table_cache),
       dbname_(dbname),
       logfile_(NULL),
-      log_(NULL) {
+      log_(NULL),
+      mem_(NULL),
+      mem_log_number_(0),
+      mem_seq_(0),
+      log_number_(0),
+      log_offset_(0) {
   table_cache_ = new TableCache(dbname_, &options_, options_.table_cache);
 
   versions_ =
@@ -41,6 +51,7 @@ ReadonlyDBImpl::ReadonlyDBImpl(const Options& raw_options,
 }
 
 ReadonlyDBImpl::~ReadonlyDBImpl() {
+  if (mem_ != NULL) mem_->Unref();
   delete versions_;
   delete log_;
   delete logfile_;
@@ -53,9 +64,15 @@ ReadonlyDBImpl::~ReadonlyDBImpl() {
 }
 
 Status ReadonlyDBImpl::Load() {
+  MutexLock rl(&reload_mutex_);
+  MutexLock ml(&mutex_);
+  return DoLoad();
+}
+
+Status ReadonlyDBImpl::DoLoad() {
   mutex_.AssertHeld();
   if (log_ != NULL) {
-    return Reload();
+    return DoReload();
   }
 
   env_->AttachDir(dbname_.c_str());
@@ -97,14 +114,23 @@ Status ReadonlyDBImpl::Load() {
         }
       }
     }
+    if (s.ok() && options_.tail_write_ahead_log) {
+      s = TailLogs();
+    }
     return s;
   }
 }
 
 Status ReadonlyDBImpl::Reload() {
+  MutexLock rl(&reload_mutex_);
+  MutexLock ml(&mutex_);
+  return DoReload();
+}
+
+Status ReadonlyDBImpl::DoReload() {
   mutex_.AssertHeld();
   if (log_ == NULL) {
-    return Load();
+    return DoLoad();
   }
 
   env_->DetachDir(dbname_.c_str());
@@ -121,10 +147,135 @@ Status ReadonlyDBImpl::Reload() {
     }
     ignore_EOF = false;
   }
+  if (s.ok() && options_.tail_write_ahead_log) {
+    s = TailLogs();
+  }
+
+  return s;
+}
+
+Status ReadonlyDBImpl::TailLogs() {
+  mutex_.AssertHeld();
+  // Logs older than this have been flushed to tables
+  const uint64_t min_log = versions_->LogNumber();
+  if (mem_ != NULL && mem_log_number_ < min_log) {
+    // Part of the replayed data is now in tables; start over
+    // from the oldest live log
+    mem_->Unref();
+    mem_ = NULL;
+    mem_seq_ = 0;
+    log_number_ = 0;
+    log_offset_ = 0;
+  }
 
+  std::vector<std::string> filenames;
+  Status s = env_->GetChildren(dbname_.c_str(), &filenames);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<uint64_t> logs;
+  uint64_t number;
+  FileType type;
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (ParseFileName(filenames[i], &number, &type)) {
+      if (type == kLogFile && number >= min_log && number >= log_number_) {
+        logs.push_back(number);
+      }
+    }
+  }
+
+  std::sort(logs.begin(), logs.end());
+  for (size_t i = 0; i < logs.size() && s.ok(); i++) {
+    s = TailLogFile(logs[i]);
+    if (s.IsNotFound()) {
+      // The log may have just been deleted after a flush. Its records are
+      // then in a table that the next manifest reload will pick up. Newer
+      // logs must wait until then or mem_ would miss the deleted records.
+      s = Status::OK();
+      break;
+    }
+  }
   return s;
 }
 
+Status ReadonlyDBImpl::TailLogFile(uint64_t log_number) {
+  mutex_.AssertHeld();
+  // Resume from the last record replayed if this is the log we were
+  // following. That record is read again and skipped when applied, since
+  // the reader only starts at record boundaries.
+  const uint64_t initial_offset =
+      (log_number == log_number_) ? log_offset_ : 0;
+  // Records are read without holding mutex_ so reads are not blocked behind
+  // log I/O. reload_mutex_ keeps other reloads from tailing meanwhile.
+  mutex_.Unlock();
+  const std::string fname = LogFileName(dbname_, log_number);
+  SequentialFile* file;
+  Status s = env_->NewSequentialFile(fname.c_str(), &file);
+  if (!s.ok()) {
+    mutex_.Lock();
+    return s;
+  }
+
+  log::Reader reader(file, NULL, true /*checksum*/, initial_offset);
+  std::string scratch;
+  Slice record;
+  std::vector<std::pair<uint64_t, std::string> > records;
+  size_t bytes = 0;
+  bool eof = false;
+  while (!eof && s.ok()) {
+    eof = !reader.ReadRecord(&record, &scratch);
+    if (!eof && record.size() >= 12) {  // Skip invalid write batches
+      records.push_back(
+          std::make_pair(reader.LastRecordOffset(), record.ToString()));
+      bytes += record.size();
+    }
+    // Apply records in batches to bound memory usage
+    if (eof || bytes >= kMaxTailBytes) {
+      mutex_.Lock();
+      s = ApplyLogRecords(log_number, records);
+      mutex_.Unlock();
+      records.clear();
+      bytes = 0;
+    }
+  }
+
+  delete file;
+  mutex_.Lock();
+  return s;
+}
+
+Status ReadonlyDBImpl::ApplyLogRecords(
+    uint64_t log_number,
+    const std::vector<std::pair<uint64_t, std::string> >& records) {
+  mutex_.AssertHeld();
+  Status s;
+  WriteBatch batch;
+  for (size_t i = 0; i < records.size() && s.ok(); i++) {
+    WriteBatchInternal::SetContents(&batch, records[i].second);
+    const SequenceNumber last_seq = WriteBatchInternal::Sequence(&batch) +
+                                    WriteBatchInternal::Count(&batch) - 1;
+    log_number_ = log_number;
+    log_offset_ = records[i].first;
+    if (mem_ != NULL && last_seq <= mem_seq_) {
+      continue;  // Already replayed
+    }
+    if (mem_ == NULL) {
+      mem_ = new MemTable(internal_comparator_);
+      mem_->Ref();
+      mem_log_number_ = log_number;
+    }
+    s = WriteBatchInternal::InsertInto(&batch, mem_);
+    if (s.ok()) {
+      mem_seq_ = last_seq;
+    }
+  }
+  return s;
+}
+
+SequenceNumber ReadonlyDBImpl::LastSequence() const {
+  return std::max(versions_->LastSequence(), mem_seq_);
+}
+
 Status ReadonlyDBImpl::InternalGet(const ReadOptions& options, const Slice& key,
                                    Buffer* value) {
   Status s;
@@ -133,21 +284,36 @@ Status ReadonlyDBImpl::InternalGet(const ReadOptions& options, const Slice& key,
   if (options.snapshot != NULL) {
     snapshot = reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_;
   } else {
-    snapshot = versions_->LastSequence();
+    snapshot = LastSequence();
+  }
+
+  // See DBImpl::Get() for how keys covered by range tombstones are handled
+  SequenceNumber tombstone = versions_->current()
+                                ->range_tombstone_fragments()
+                                .MaxCoveringTombstone(key, snapshot);
+  if (mem_ != NULL) {
+    tombstone = std::max(tombstone, mem_->MaxCoveringTombstone(key, snapshot));
   }
 
+  MemTable* mem = mem_;
   Version* current = versions_->current();
+  if (mem != NULL) mem->Ref();
   current->Ref();
 
-  // Unlock while reading from files
+  // Unlock while reading from files and the memtable
   {
     mutex_.Unlock();
     LookupKey lkey(key, snapshot);
-    Version::GetStats ignored;
-    current->Get(options, lkey, value, &s, &ignored);
+    if (mem != NULL && mem->Get(lkey, value, options.limit, &s, tombstone)) {
+      // Done
+    } else {
+      Version::GetStats ignored;
+      current->Get(options, lkey, value, &s, &ignored, tombstone);
+    }
     mutex_.Lock();
   }
 
+  if (mem != NULL) mem->Unref();
   current->Unref();
   return s;
 }
@@ -176,12 +342,14 @@ namespace {
 struct IterState {
   port::Mutex* mu;
   Version* version;
+  MemTable* mem;
 };
 }
 
 static void CleanupIteratorState(void* arg1, void* arg2) {
   IterState* state = reinterpret_cast<IterState*>(arg1);
   state->mu->Lock();
+  if (state->mem != NULL) state->mem->Unref();
   state->version->Unref();
   state->mu->Unlock();
   delete state;
@@ -191,19 +359,37 @@ Iterator* ReadonlyDBImpl::NewInternalIterator(
     const ReadOptions& options, SequenceNumber* lastest_snapshot) {
   IterState* cleanup = new IterState;
   mutex_.Lock();
-  *lastest_snapshot = versions_->LastSequence();
+  *lastest_snapshot = LastSequence();
 
   // Collect together all needed child iterators
   std::vector<Iterator*> list;
+  if (mem_ != NULL) {
+    list.push_back(mem_->NewIterator());
+    mem_->Ref();
+  }
   versions_->current()->AddIterators(options, &list);
-  Iterator* internal_iter =
-      NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  // The list may be empty when no table is within the iterate bounds
+  Iterator* internal_iter = NewMergingIterator(
+      &internal_comparator_, list.empty() ? NULL : &list[0], list.size());
   versions_->current()->Ref();
 
   cleanup->mu = &mutex_;
+  cleanup->mem = mem_;
   cleanup->version = versions_->current();
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, NULL);
 
+  // Hide entries deleted by range tombstones
+  RangeTombstoneList tombstones;
+  if (mem_ != NULL) {
+    mem_->GetRangeTombstones(&tombstones);
+  }
+  internal_iter = NewRangeDelIterator(
+      &internal_comparator_, internal_iter,
+      &versions_->current()->range_tombstone_fragments(), tombstones,
+      (options.snapshot != NULL
+           ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
+           : *lastest_snapshot));
+
   mutex_.Unlock();
   return internal_iter;
 }
@@ -216,7 +402,7 @@ Iterator* ReadonlyDBImpl::NewIterator(const ReadOptions& options) {
       (options.snapshot != NULL
            ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
            : latest_snapshot),
-      0);
+      0, options.iterate_lower_bound, options.iterate_upper_bound);
 }
 
 const Snapshot* ReadonlyDBImpl::GetSnapshot() {
@@ -267,9 +453,7 @@ Status ReadonlyDB::Open(const Options& options, const std::string& dbname,
   *dbptr = NULL;
 
   ReadonlyDBImpl* impl = new ReadonlyDBImpl(options, dbname);
-  impl->mutex_.Lock();
   Status s = impl->Load();
-  impl->mutex_.Unlock();
   if (s.ok()) {
     *dbptr = impl;
   } else {
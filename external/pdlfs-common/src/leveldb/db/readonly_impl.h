@@ -15,8 +15,13 @@
 #include "pdlfs-common/log_reader.h"
 #include "pdlfs-common/port.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace pdlfs {
 
+class MemTable;
 class TableCache;
 class Version;
 class VersionSet;
@@ -27,6 +32,9 @@ class VersionSet;
 // a replay of memtable logs.
 // Multiple readonly db instances can share a same db image and
 // can follow a read-write instance to access new updates.
+// If options.tail_write_ahead_log is set, the write-ahead logs of the
+// read-write instance are also replayed into a private memtable so that
+// updates not yet flushed to tables become visible.
 class ReadonlyDBImpl : public ReadonlyDB {
  public:
   ReadonlyDBImpl(const Options& options, const std::string& dbname);
@@ -49,6 +57,27 @@ class ReadonlyDBImpl : public ReadonlyDB {
  private:
   friend class ReadonlyDB;
 
+  // REQUIRES: mutex_ has been locked.
+  Status DoLoad();
+  Status DoReload();
+  // Replay new records from the write-ahead logs of the read-write
+  // instance into mem_, dropping mem_ first if it contains data that has
+  // since been flushed to tables. Tailing stops at the first log that is
+  // missing. mutex_ is released while log records are read.
+  // REQUIRES: both reload_mutex_ and mutex_ have been locked.
+  Status TailLogs();
+  // Return NotFound if the log does not exist.
+  Status TailLogFile(uint64_t log_number);
+  // Apply write batches read from a log. Each record is paired with its
+  // offset in the log.
+  // REQUIRES: mutex_ has been locked.
+  Status ApplyLogRecords(
+      uint64_t log_number,
+      const std::vector<std::pair<uint64_t, std::string> >& records);
+  // Max bytes of log records read before they are applied
+  static const size_t kMaxTailBytes = 1 << 20;
+  SequenceNumber LastSequence() const;
+
   Status InternalGet(const ReadOptions&, const Slice& key, Buffer* buf);
   Iterator* NewInternalIterator(const ReadOptions&,
                                 SequenceNumber* latest_snapshot);
@@ -65,11 +94,20 @@ class ReadonlyDBImpl : public ReadonlyDB {
   // table_cache_ provides its own synchronization
   TableCache* table_cache_;
 
+  // Serializes Load() and Reload(). Acquired before mutex_.
+  port::Mutex reload_mutex_;
+
   // State below is protected by mutex_
   port::Mutex mutex_;
   VersionSet* versions_;
   SequentialFile* logfile_;
   log::Reader* log_;
+  // State for tailing write-ahead logs
+  MemTable* mem_;            // NULL if nothing has been replayed
+  uint64_t mem_log_number_;  // The oldest log replayed into mem_
+  SequenceNumber mem_seq_;   // The last sequence replayed into mem_
+  uint64_t log_number_;      // The log currently being tailed
+  uint64_t log_offset_;      // Offset of the last record replayed from it
 
   // No copying allowed
   void operator=(const ReadonlyDBImpl&);
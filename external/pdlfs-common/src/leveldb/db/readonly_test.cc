@@ -119,6 +119,29 @@ TEST(ReadonlyTest, Readonly) {
   delete db;
 }
 
+TEST(ReadonlyTest, TailWAL) {
+  Status s;
+  DB* db;
+  s = DB::Open(options_, dbname_, &db);
+  ASSERT_OK(s);
+  BuildImage(db, 0, 1000);  // Stays in the writer's memtable
+  DBOptions options = options_;
+  options.tail_write_ahead_log = true;
+  DB* rdb;
+  s = ReadonlyDB::Open(options, dbname_, &rdb);
+  ASSERT_OK(s);
+  Check(rdb, 1000, 1000);
+  BuildImage(db, 1000, 2000);
+  ASSERT_OK(static_cast<ReadonlyDB*>(rdb)->Reload());
+  Check(rdb, 2000, 2000);
+  dbfull(db)->TEST_CompactMemTable();
+  BuildImage(db, 2000, 3000);
+  ASSERT_OK(static_cast<ReadonlyDB*>(rdb)->Reload());
+  Check(rdb, 3000, 3000);
+  delete rdb;
+  delete db;
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char** argv) {
@@ -13,6 +13,7 @@
 #include "pdlfs-common/coding.h"
 #include "pdlfs-common/dbfiles.h"
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/env_files.h"
 #include "pdlfs-common/leveldb/db/options.h"
 #include "pdlfs-common/leveldb/table.h"
 
@@ -43,6 +44,11 @@ static void UnrefEntry(void* arg1, void* arg2) {
   cache->Release(h);
 }
 
+static void DeleteTableAndFile(void* arg1, void* arg2) {
+  delete reinterpret_cast<Table*>(arg1);
+  delete reinterpret_cast<RandomAccessFile*>(arg2);
+}
+
 TableCache::TableCache(const std::string& dbname, const Options* options,
                        Cache* cache)
     : env_(options->env), dbname_(dbname), options_(options), cache_(cache) {
@@ -52,7 +58,7 @@ TableCache::TableCache(const std::string& dbname, const Options* options,
 TableCache::~TableCache() {}
 
 Status TableCache::LoadTable(uint64_t fnum, uint64_t fsize, Table** table,
-                             RandomAccessFile** file) {
+                             RandomAccessFile** file, size_t readahead_size) {
   Status s;
   std::string fname = TableFileName(dbname_, fnum);
   s = env_->NewRandomAccessFile(fname.c_str(), file);
@@ -66,6 +72,9 @@ Status TableCache::LoadTable(uint64_t fnum, uint64_t fsize, Table** table,
   }
 
   if (s.ok()) {
+    if (readahead_size != 0) {
+      *file = new ReadaheadRandomAccessFile(*file, fsize, readahead_size);
+    }
     s = Table::Open(*options_, *file, fsize, table);
     if (!s.ok()) {
       // We do not cache error results so that if the error is transient,
@@ -237,6 +246,31 @@ Iterator* TableCache::NewIterator(const ReadOptions& options, uint64_t fnum,
   return result;
 }
 
+Iterator* TableCache::NewCompactionIterator(const ReadOptions& options,
+                                            uint64_t fnum, uint64_t fsize,
+                                            SequenceOff off) {
+  const size_t readahead_size = options_->compaction_readahead_size;
+  if (readahead_size == 0) {
+    return NewIterator(options, fnum, fsize, off);
+  }
+
+  // Bypass the cache so that the readahead buffer is private to the
+  // compaction and foreground reads keep using the shared file
+  RandomAccessFile* file = NULL;
+  Table* table = NULL;
+  Status s = LoadTable(fnum, fsize, &table, &file, readahead_size);
+  if (!s.ok()) {
+    return NewErrorIterator(s);
+  }
+
+  Iterator* result = table->NewIterator(options);
+  result->RegisterCleanup(&DeleteTableAndFile, table, file);
+  if (off != 0) {
+    result = new SequenceOffsetter(off, result);
+  }
+  return result;
+}
+
 namespace {
 
 typedef void (*Saver)(void*, const Slice& K, const Slice& V);
@@ -277,7 +311,7 @@ static void ApplyOffset(void* arg, const Slice& key, const Slice& value) {
 
 Status TableCache::Get(const ReadOptions& options, uint64_t fnum,
                        uint64_t fsize, SequenceOff off, const Slice& key,
-                       void* arg, Saver saver) {
+                       void* arg, Saver saver, Table::ReadStats* stats) {
   Cache::Handle* handle;
   Status s = FindTable(fnum, fsize, off, &handle);
   if (!s.ok()) {
@@ -286,7 +320,7 @@ Status TableCache::Get(const ReadOptions& options, uint64_t fnum,
 
   Table* t = FetchTableAndFile(cache_, handle)->table;
   if (off == 0) {
-    s = t->InternalGet(options, key, arg, saver);
+    s = t->InternalGet(options, key, arg, saver, stats);
     cache_->Release(handle);
     return s;
   }
@@ -329,7 +363,7 @@ Status TableCache::Get(const ReadOptions& options, uint64_t fnum,
   }
 
   if (s.ok()) {
-    s = t->InternalGet(options, _key, _arg, _saver);
+    s = t->InternalGet(options, _key, _arg, _saver, stats);
   }
   cache_->Release(handle);
   return s;
@@ -42,18 +42,27 @@ class TableCache {
                         uint64_t file_size, SequenceOff seq_off,
                         Table** tableptr = NULL);
 
+  // Return an iterator for reading the specified file during a compaction.
+  // If "compaction_readahead_size" is set, the file is opened through a
+  // private readahead buffer and is not added to the cache.
+  Iterator* NewCompactionIterator(const ReadOptions& options,
+                                  uint64_t file_number, uint64_t file_size,
+                                  SequenceOff seq_off);
+
   // If a seek to internal key "k" in specified file finds an entry,
-  // call (*handle_result)(arg, found_key, found_value).
+  // call (*handle_result)(arg, found_key, found_value).  Filter
+  // rejections and data block reads are added to *stats if it is not NULL.
   Status Get(const ReadOptions& options, uint64_t file_number,
              uint64_t file_size, SequenceOff seq_off, const Slice& k, void* arg,
-             void (*handle_result)(void*, const Slice&, const Slice&));
+             void (*handle_result)(void*, const Slice&, const Slice&),
+             Table::ReadStats* stats = NULL);
 
   // Evict any entry for the specified file number
   void Evict(uint64_t file_number);
 
  private:
   Status LoadTable(uint64_t file_number, uint64_t file_size, Table**,
-                   RandomAccessFile**);
+                   RandomAccessFile**, size_t readahead_size = 0);
 
   // Load the table for the specified file number.  Bind the
   // given sequence offset to the table.
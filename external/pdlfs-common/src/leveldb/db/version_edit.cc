@@ -12,6 +12,7 @@
 #include "version_set.h"
 
 #include "pdlfs-common/coding.h"
+#include "pdlfs-common/strutil.h"
 
 namespace pdlfs {
 
@@ -26,7 +27,9 @@ enum Tag {
   kDeletedFile = 6,
   kNewFile = 7,
   // 8 was used for large value refs
-  kPrevLogNumber = 9
+  kPrevLogNumber = 9,
+  kRangeTombstone = 10,
+  kDeletedRangeTombstone = 11
 };
 
 void VersionEdit::Clear() {
@@ -42,6 +45,8 @@ void VersionEdit::Clear() {
   has_last_sequence_ = false;
   deleted_files_.clear();
   new_files_.clear();
+  deleted_tombstones_.clear();
+  new_tombstones_.clear();
 }
 
 void VersionEdit::EncodeTo(std::string* dst) const {
@@ -89,6 +94,21 @@ void VersionEdit::EncodeTo(std::string* dst) const {
     PutLengthPrefixedSlice(dst, f.smallest.Encode());
     PutLengthPrefixedSlice(dst, f.largest.Encode());
   }
+
+  for (std::set<SequenceNumber>::const_iterator iter =
+           deleted_tombstones_.begin();
+       iter != deleted_tombstones_.end(); ++iter) {
+    PutVarint32(dst, kDeletedRangeTombstone);
+    PutVarint64(dst, *iter);
+  }
+
+  for (size_t i = 0; i < new_tombstones_.size(); i++) {
+    const RangeTombstone& t = new_tombstones_[i];
+    PutVarint32(dst, kRangeTombstone);
+    PutLengthPrefixedSlice(dst, t.begin);
+    PutLengthPrefixedSlice(dst, t.end);
+    PutVarint64(dst, t.seq);
+  }
 }
 
 static bool GetInternalKey(Slice* input, InternalKey* dst) {
@@ -123,7 +143,9 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
   uint64_t off;
   FileMetaData f;
   Slice str;
+  Slice str2;
   InternalKey key;
+  RangeTombstone t;
 
   while (msg == NULL && GetVarint32(&input, &tag)) {
     switch (tag) {
@@ -196,6 +218,26 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         }
         break;
 
+      case kRangeTombstone:
+        if (GetLengthPrefixedSlice(&input, &str) &&
+            GetLengthPrefixedSlice(&input, &str2) &&
+            GetVarint64(&input, &t.seq)) {
+          t.begin = str.ToString();
+          t.end = str2.ToString();
+          new_tombstones_.push_back(t);
+        } else {
+          msg = "range tombstone";
+        }
+        break;
+
+      case kDeletedRangeTombstone:
+        if (GetVarint64(&input, &number)) {
+          deleted_tombstones_.insert(number);
+        } else {
+          msg = "deleted range tombstone";
+        }
+        break;
+
       default:
         msg = "unknown tag";
         break;
@@ -264,6 +306,22 @@ std::string VersionEdit::DebugString() const {
     r.append(" .. ");
     r.append(f.largest.DebugString());
   }
+  for (std::set<SequenceNumber>::const_iterator iter =
+           deleted_tombstones_.begin();
+       iter != deleted_tombstones_.end(); ++iter) {
+    r.append("\n  DeleteRangeTombstone: ");
+    AppendNumberTo(&r, *iter);
+  }
+  for (size_t i = 0; i < new_tombstones_.size(); i++) {
+    const RangeTombstone& t = new_tombstones_[i];
+    r.append("\n  AddRangeTombstone: ");
+    AppendNumberTo(&r, t.seq);
+    r.append(" '");
+    AppendEscapedStringTo(&r, t.begin);
+    r.append("' .. '");
+    AppendEscapedStringTo(&r, t.end);
+    r.append("'");
+  }
   r.append("\n}\n");
   return r;
 }
@@ -17,6 +17,7 @@
 #include "pdlfs-common/leveldb/db/dbformat.h"
 #include "pdlfs-common/status.h"
 
+#include "range_del.h"
 #include "table_file.h"
 
 namespace pdlfs {
@@ -73,6 +74,21 @@ class VersionEdit {
     deleted_files_.insert(std::make_pair(level, file));
   }
 
+  // Add a tombstone deleting all keys in [begin, end) older than "seq".
+  void AddRangeTombstone(const Slice& begin, const Slice& end,
+                         SequenceNumber seq) {
+    RangeTombstone t;
+    t.begin = begin.ToString();
+    t.end = end.ToString();
+    t.seq = seq;
+    new_tombstones_.push_back(t);
+  }
+
+  // Drop the tombstone with the specified sequence number.
+  void DeleteRangeTombstone(SequenceNumber seq) {
+    deleted_tombstones_.insert(seq);
+  }
+
   void EncodeTo(std::string* dst) const;
   Status DecodeFrom(const Slice& src);
 
@@ -97,6 +113,8 @@ class VersionEdit {
   std::vector<std::pair<int, InternalKey> > compact_pointers_;
   DeletedFileSet deleted_files_;
   std::vector<std::pair<int, FileMetaData> > new_files_;
+  std::set<SequenceNumber> deleted_tombstones_;
+  RangeTombstoneList new_tombstones_;
 };
 
 }  // namespace pdlfs
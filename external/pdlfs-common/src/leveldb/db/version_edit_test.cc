@@ -37,6 +37,8 @@ TEST(VersionEditTest, EncodeDecode) {
                  InternalKey("zoo", kBig + 600 + i, kTypeDeletion));
     edit.DeleteFile(4, kBig + 700 + i);
     edit.SetCompactPointer(i, InternalKey("x", kBig + 900 + i, kTypeValue));
+    edit.AddRangeTombstone("a", "m", kBig + 800 + i);
+    edit.DeleteRangeTombstone(kBig + 850 + i);
   }
 
   edit.SetComparatorName("foo");
@@ -124,6 +124,15 @@ static bool BeforeFile(const Comparator* ucmp, const Slice* user_key,
           ucmp->Compare(*user_key, f->smallest.user_key()) < 0);
 }
 
+// Return true if "*f" may hold user keys in [*lower_bound, *upper_bound).
+// A NULL bound leaves that side of the range open.
+static bool FileWithinBounds(const Comparator* ucmp, const Slice* lower_bound,
+                             const Slice* upper_bound, const FileMetaData* f) {
+  return !AfterFile(ucmp, lower_bound, f) &&
+         (upper_bound == NULL ||
+          ucmp->Compare(*upper_bound, f->smallest.user_key()) > 0);
+}
+
 bool SomeFileOverlapsRange(const InternalKeyComparator& icmp,
                            bool disjoint_sorted_files,
                            const std::vector<FileMetaData*>& files,
@@ -165,29 +174,35 @@ bool SomeFileOverlapsRange(const InternalKeyComparator& icmp,
 // information about the files in the level.  For a given entry, key()
 // is the largest key that occurs in the file, and value() is an
 // 24-byte value containing the file number, file size, and sequence offset,
-// all encoded using EncodeFixed64.
+// all encoded using EncodeFixed64.  Only files in [begin, end) of the
+// level are visited.
 class Version::LevelFileNumIterator : public Iterator {
  public:
   LevelFileNumIterator(const InternalKeyComparator& icmp,
-                       const std::vector<FileMetaData*>* flist)
-      : icmp_(icmp), flist_(flist), index_(flist->size()) {  // Marks as invalid
-  }
-  virtual bool Valid() const { return index_ < flist_->size(); }
+                       const std::vector<FileMetaData*>* flist,
+                       uint32_t begin, uint32_t end)
+      : icmp_(icmp),
+        flist_(flist),
+        begin_(begin),
+        end_(end),
+        index_(end) {  // Marks as invalid
+  }
+  virtual bool Valid() const { return index_ >= begin_ && index_ < end_; }
   virtual void Seek(const Slice& target) {
-    index_ = FindFile(icmp_, *flist_, target);
-  }
-  virtual void SeekToFirst() { index_ = 0; }
-  virtual void SeekToLast() {
-    index_ = flist_->empty() ? 0 : flist_->size() - 1;
+    index_ = std::min(std::max<uint32_t>(FindFile(icmp_, *flist_, target),
+                                         begin_),
+                      end_);
   }
+  virtual void SeekToFirst() { index_ = begin_; }
+  virtual void SeekToLast() { index_ = (end_ > begin_) ? end_ - 1 : end_; }
   virtual void Next() {
     assert(Valid());
     index_++;
   }
   virtual void Prev() {
     assert(Valid());
-    if (index_ == 0) {
-      index_ = flist_->size();  // Marks as invalid
+    if (index_ == begin_) {
+      index_ = end_;  // Marks as invalid
     } else {
       index_--;
     }
@@ -208,6 +223,8 @@ class Version::LevelFileNumIterator : public Iterator {
  private:
   const InternalKeyComparator icmp_;
   const std::vector<FileMetaData*>* const flist_;
+  const uint32_t begin_;
+  const uint32_t end_;
   uint32_t index_;
 
   // Backing store for value().  Holds the file number and size.
@@ -227,28 +244,75 @@ static Iterator* GetFileIterator(void* arg, const ReadOptions& options,
   }
 }
 
+static Iterator* GetCompactionFileIterator(void* arg,
+                                           const ReadOptions& options,
+                                           const Slice& file_value) {
+  TableCache* cache = reinterpret_cast<TableCache*>(arg);
+  if (file_value.size() != 24) {
+    return NewErrorIterator(
+        Status::Corruption("FileReader invoked with unexpected value"));
+  } else {
+    return cache->NewCompactionIterator(
+        options, DecodeFixed64(file_value.data()),
+        DecodeFixed64(file_value.data() + 8),
+        DecodeFixed64(file_value.data() + 16));
+  }
+}
+
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
+  const std::vector<FileMetaData*>& files = files_[level];
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  // Restrict the iterator to files that may hold keys within bounds
+  uint32_t begin = 0;
+  if (options.iterate_lower_bound != NULL) {
+    InternalKey lower(*options.iterate_lower_bound, kMaxSequenceNumber,
+                      kValueTypeForSeek);
+    begin = FindFile(vset_->icmp_, files, lower.Encode());
+  }
+  uint32_t end = files.size();
+  if (options.iterate_upper_bound != NULL) {
+    uint32_t left = begin;
+    while (left < end) {
+      uint32_t mid = (left + end) / 2;
+      if (ucmp->Compare(files[mid]->smallest.user_key(),
+                        *options.iterate_upper_bound) < 0) {
+        left = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+  }
+  if (begin >= end) {
+    return NULL;
+  }
   return NewTwoLevelIterator(
-      new LevelFileNumIterator(vset_->icmp_, &files_[level]), &GetFileIterator,
-      vset_->table_cache_, options);
+      new LevelFileNumIterator(vset_->icmp_, &files, begin, end),
+      &GetFileIterator, vset_->table_cache_, options);
 }
 
 void Version::AddIterators(const ReadOptions& options,
                            std::vector<Iterator*>* iters) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
   // Merge all level zero files together since they may overlap
   for (size_t i = 0; i < files_[0].size(); i++) {
-    iters->push_back(vset_->table_cache_->NewIterator(
-        options, files_[0][i]->number, files_[0][i]->file_size,
-        files_[0][i]->seq_off));
+    if (FileWithinBounds(ucmp, options.iterate_lower_bound,
+                         options.iterate_upper_bound, files_[0][i])) {
+      iters->push_back(vset_->table_cache_->NewIterator(
+          options, files_[0][i]->number, files_[0][i]->file_size,
+          files_[0][i]->seq_off));
+    }
   }
 
   // For levels > 0, we can use a concatenating iterator that sequentially
   // walks through the non-overlapping files in the level, opening them
-  // lazily.
+  // lazily.  Levels without any file within bounds are skipped.
   for (int level = 1; level < config::kNumLevels; level++) {
     if (!files_[level].empty()) {
-      iters->push_back(NewConcatenatingIterator(options, level));
+      Iterator* iter = NewConcatenatingIterator(options, level);
+      if (iter != NULL) {
+        iters->push_back(iter);
+      }
     }
   }
 }
@@ -262,6 +326,7 @@ struct Saver {
   const ReadOptions* options;
   const Comparator* ucmp;
   Slice user_key;
+  SequenceNumber tombstone;  // Older entries are deleted
   Buffer* buf;
 };
 }
@@ -273,6 +338,10 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
     s->state = kCorrupt;
   } else {
     if (s->ucmp->Compare(parsed_key.user_key, s->user_key) == 0) {
+      if (parsed_key.sequence < s->tombstone) {
+        s->state = kDeleted;
+        return;
+      }
       s->state = (parsed_key.type == kTypeValue) ? kFound : kDeleted;
       if (s->state == kFound) {
         assert(parsed_key.sequence <= kMaxSequenceNumber);
@@ -331,7 +400,7 @@ void Version::ForEachOverlapping(Slice user_key, Slice internal_key, void* arg,
 }
 
 bool Version::Get(const ReadOptions& options, const LookupKey& k, Buffer* buf,
-                  Status* s, GetStats* stats) {
+                  Status* s, GetStats* stats, SequenceNumber tombstone) {
   Slice ikey = k.internal_key();
   Slice user_key = k.user_key();
   const Comparator* ucmp = vset_->icmp_.user_comparator();
@@ -403,6 +472,7 @@ bool Version::Get(const ReadOptions& options, const LookupKey& k, Buffer* buf,
       saver.options = &options;
       saver.ucmp = ucmp;
       saver.user_key = user_key;
+      saver.tombstone = tombstone;
       saver.buf = buf;
       *s = vset_->table_cache_->Get(options, f->number, f->file_size,
                                     f->seq_off, ikey, &saver, SaveValue);
@@ -428,6 +498,64 @@ bool Version::Get(const ReadOptions& options, const LookupKey& k, Buffer* buf,
   return false;
 }
 
+namespace {
+struct ExistsState {
+  TableCache* table_cache;
+  const ReadOptions* options;
+  Slice ikey;
+  Saver saver;
+  Status s;
+  Table::ReadStats* stats;
+};
+}
+
+static bool CheckFile(void* arg, int level, FileMetaData* f) {
+  ExistsState* state = reinterpret_cast<ExistsState*>(arg);
+  state->s = state->table_cache->Get(*state->options, f->number, f->file_size,
+                                     f->seq_off, state->ikey, &state->saver,
+                                     SaveValue, state->stats);
+  if (!state->s.ok()) {
+    return false;  // Read error
+  }
+  switch (state->saver.state) {
+    case kNotFound:
+      return true;  // Keep searching in other files
+    case kFound:
+      return false;
+    case kDeleted:
+      state->s = Status::NotFound(Slice());
+      return false;
+    case kCorrupt:
+      state->s = Status::Corruption("Corrupted key for ", state->saver.user_key);
+      return false;
+  }
+  return false;
+}
+
+void Version::Exists(const ReadOptions& options, const LookupKey& k, Status* s,
+                     Table::ReadStats* stats, SequenceNumber tombstone) {
+  char tmp[1];
+  buffer::DirectBuf buf(tmp, sizeof(tmp));
+  ReadOptions opts = options;
+  opts.limit = 0;
+  ExistsState state;
+  state.table_cache = vset_->table_cache_;
+  state.options = &opts;
+  state.ikey = k.internal_key();
+  state.saver.state = kNotFound;
+  state.saver.options = &opts;
+  state.saver.ucmp = vset_->icmp_.user_comparator();
+  state.saver.user_key = k.user_key();
+  state.saver.tombstone = tombstone;
+  state.saver.buf = &buf;
+  state.stats = stats;
+  ForEachOverlapping(k.user_key(), k.internal_key(), &state, &CheckFile);
+  if (state.s.ok() && state.saver.state == kNotFound) {
+    state.s = Status::NotFound(Slice());
+  }
+  *s = state.s;
+}
+
 bool Version::UpdateStats(const GetStats& stats) {
   FileMetaData* f = stats.seek_file;
   if (f != NULL) {
@@ -620,10 +748,12 @@ class VersionSet::Builder {
   VersionSet* vset_;
   Version* base_;
   LevelState levels_[config::kNumLevels];
+  RangeTombstoneList tombstones_;
 
  public:
   // Initialize a builder with the files from *base and other info from *vset
-  Builder(VersionSet* vset, Version* base) : vset_(vset), base_(base) {
+  Builder(VersionSet* vset, Version* base)
+      : vset_(vset), base_(base), tombstones_(base->range_tombstones_) {
     base_->Ref();
     BySmallestKey cmp;
     cmp.internal_comparator = &vset_->icmp_;
@@ -696,6 +826,23 @@ class VersionSet::Builder {
       levels_[level].deleted_files.erase(f->number);
       levels_[level].added_files->insert(f);
     }
+
+    // Delete range tombstones
+    if (!edit->deleted_tombstones_.empty()) {
+      RangeTombstoneList::iterator it = tombstones_.begin();
+      while (it != tombstones_.end()) {
+        if (edit->deleted_tombstones_.count(it->seq) != 0) {
+          it = tombstones_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    // Add new range tombstones
+    for (size_t i = 0; i < edit->new_tombstones_.size(); i++) {
+      tombstones_.push_back(edit->new_tombstones_[i]);
+    }
   }
 
   // Save the current state in *v.
@@ -743,6 +890,10 @@ class VersionSet::Builder {
       }
 #endif
     }
+
+    v->range_tombstones_ = tombstones_;
+    v->range_tombstone_fragments_ = FragmentedRangeTombstoneList(
+        vset_->icmp_.user_comparator(), tombstones_);
   }
 
   void MaybeAddFile(Version* v, int level, FileMetaData* f) {
@@ -1160,6 +1311,15 @@ void VersionSet::MarkFileNumberUsed(uint64_t number) {
 }
 
 void VersionSet::Finalize(Version* v) {
+  if (options_->compaction_style == kCompactionStyleTiered) {
+    // All runs live in level-0.  At least two runs are needed for a merge.
+    v->compaction_level_ = 0;
+    v->compaction_score_ =
+        v->files_[0].size() /
+        static_cast<double>(std::max(2, options_->l0_compaction_trigger));
+    return;
+  }
+
   // Precomputed best level for next compaction
   int best_level = -1;
   double best_score = -1;
@@ -1222,6 +1382,13 @@ Status VersionSet::WriteSnapshot(log::Writer* log) {
     }
   }
 
+  // Save range tombstones
+  const RangeTombstoneList& tombstones = current_->range_tombstones_;
+  for (size_t i = 0; i < tombstones.size(); i++) {
+    edit.AddRangeTombstone(tombstones[i].begin, tombstones[i].end,
+                           tombstones[i].seq);
+  }
+
   std::string record;
   edit.EncodeTo(&record);
   return log->AddRecord(record);
@@ -1363,15 +1530,16 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
       if (c->level() + which == 0) {
         const std::vector<FileMetaData*>& files = c->inputs_[which];
         for (size_t i = 0; i < files.size(); i++) {
-          list[num++] =
-              table_cache_->NewIterator(options, files[i]->number,
-                                        files[i]->file_size, files[i]->seq_off);
+          list[num++] = table_cache_->NewCompactionIterator(
+              options, files[i]->number, files[i]->file_size,
+              files[i]->seq_off);
         }
       } else {
         // Create concatenating iterator for the files from this level
         list[num++] = NewTwoLevelIterator(
-            new Version::LevelFileNumIterator(icmp_, &c->inputs_[which]),
-            &GetFileIterator, table_cache_, options);
+            new Version::LevelFileNumIterator(icmp_, &c->inputs_[which], 0,
+                                              c->inputs_[which].size()),
+            &GetCompactionFileIterator, table_cache_, options);
       }
     }
   }
@@ -1389,7 +1557,13 @@ Compaction* VersionSet::PickCompaction(bool allow_seek_compaction) {
   // the compactions triggered by seeks.
   const bool size_compaction = (current_->compaction_score_ >= 1);
   const bool seek_compaction = (current_->file_to_compact_ != NULL);
-  if (size_compaction) {
+  if (options_->compaction_style == kCompactionStyleTiered) {
+    if (size_compaction) {
+      return PickTieredCompaction();
+    } else {
+      return NULL;
+    }
+  } else if (size_compaction) {
     level = current_->compaction_level_;
     assert(level >= 0);
     assert(level + 1 < config::kNumLevels);
@@ -1435,6 +1609,40 @@ Compaction* VersionSet::PickCompaction(bool allow_seek_compaction) {
   return c;
 }
 
+Compaction* VersionSet::PickTieredCompaction() {
+  std::vector<FileMetaData*> runs = current_->files_[0];
+  if (runs.size() < 2) {
+    return NULL;
+  }
+  std::sort(runs.begin(), runs.end(), NewestFirst);
+
+  // Starting from the newest run, keep adding older runs as long as each
+  // of them is not much larger than the runs already picked.  Only
+  // consecutive runs can be merged so that the result of the merge
+  // still sits between the older and the newer runs.
+  const uint64_t ratio = 100 + options_->tiered_size_ratio;
+  uint64_t total = runs[0]->file_size;
+  size_t n = 1;
+  while (n < runs.size() && runs[n]->file_size * 100 <= total * ratio) {
+    total += runs[n]->file_size;
+    n++;
+  }
+  if (n < 2) {
+    // Runs are of very different sizes. Merge just enough newest runs to
+    // get the number of runs below the compaction trigger.
+    const int trigger = std::max(2, options_->l0_compaction_trigger);
+    n = std::max<int>(2, static_cast<int>(runs.size()) - trigger + 2);
+    n = std::min(n, runs.size());
+  }
+
+  Compaction* c = new Compaction(options_, 0);
+  c->input_version_ = current_;
+  c->input_version_->Ref();
+  c->inputs_[0].assign(runs.begin(), runs.begin() + n);
+  c->includes_oldest_run_ = (n == runs.size());
+  return c;
+}
+
 void VersionSet::SetupOtherInputs(Compaction* c) {
   const int level = c->level();
   InternalKey smallest, largest;
@@ -1500,6 +1708,19 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
 
 Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
                                      const InternalKey* end) {
+  if (level == 0 && options_->compaction_style == kCompactionStyleTiered) {
+    // Runs overlap each other, so all of them are merged into one
+    if (current_->files_[0].size() < 2) {
+      return NULL;
+    }
+    Compaction* c = new Compaction(options_, 0);
+    c->input_version_ = current_;
+    c->input_version_->Ref();
+    c->inputs_[0] = current_->files_[0];
+    c->includes_oldest_run_ = true;
+    return c;
+  }
+
   std::vector<FileMetaData*> inputs;
   current_->GetOverlappingInputs(level, begin, end, &inputs);
   if (inputs.empty()) {
@@ -1533,6 +1754,8 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
 
 Compaction::Compaction(const Options* options, int level)
     : level_(level),
+      output_level_(level + 1),
+      includes_oldest_run_(false),
       max_output_file_size_(MaxFileSizeForLevel(options, level)),
       max_grand_parent_overlap_bytes_(MaxGrandParentOverlapBytes(options)),
       input_version_(NULL),
@@ -1542,6 +1765,11 @@ Compaction::Compaction(const Options* options, int level)
   for (int i = 0; i < config::kNumLevels; i++) {
     level_ptrs_[i] = 0;
   }
+  if (options->compaction_style == kCompactionStyleTiered && level == 0) {
+    // Each tiered compaction produces exactly one new run
+    output_level_ = 0;
+    max_output_file_size_ = ~static_cast<uint64_t>(0);
+  }
 }
 
 Compaction::~Compaction() {
@@ -1569,7 +1797,10 @@ void Compaction::AddInputDeletions(VersionEdit* edit) {
 bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
   // Maybe use binary search to find right entry instead of linear search?
   const Comparator* user_cmp = input_version_->vset_->icmp_.user_comparator();
-  for (int lvl = level_ + 2; lvl < config::kNumLevels; lvl++) {
+  if (output_level_ == 0 && !includes_oldest_run_) {
+    return false;  // Older runs may still hold the key
+  }
+  for (int lvl = output_level_ + 1; lvl < config::kNumLevels; lvl++) {
     const std::vector<FileMetaData*>& files = input_version_->files_[lvl];
     for (; level_ptrs_[lvl] < files.size();) {
       FileMetaData* f = files[level_ptrs_[lvl]];
@@ -16,6 +16,7 @@
 
 #include "options_internal.h"
 #include "pdlfs-common/leveldb/db/dbformat.h"
+#include "pdlfs-common/leveldb/table.h"
 #include "pdlfs-common/port.h"
 #include "version_edit.h"
 
@@ -69,7 +70,8 @@ class Version {
   void AddIterators(const ReadOptions&, std::vector<Iterator*>* iters);
 
   // Lookup the value for key.  Return true if either the value or a tombstone
-  // is found or false otherwise.  Also fills *s and *stats.
+  // is found or false otherwise.  Also fills *s and *stats.  Entries older
+  // than "tombstone" are treated as deleted by a range tombstone.
   // REQUIRES: both s and stats are not NULL
   // REQUIRES: lock is not held
   struct GetStats {
@@ -77,7 +79,17 @@ class Version {
     int seek_file_level;
   };
   bool Get(const ReadOptions& options, const LookupKey& key, Buffer* val,
-           Status* s, GetStats* stats);
+           Status* s, GetStats* stats, SequenceNumber tombstone = 0);
+
+  // Check if there is an entry for key without copying its value. Files
+  // whose filters rule out the key are skipped without reading any of
+  // their data blocks. Fills *s and adds filter rejections and data block
+  // reads to *stats. Seeks are not charged. Entries older than "tombstone"
+  // are treated as deleted.
+  // REQUIRES: both s and stats are not NULL
+  // REQUIRES: lock is not held
+  void Exists(const ReadOptions& options, const LookupKey& key, Status* s,
+              Table::ReadStats* stats, SequenceNumber tombstone = 0);
 
   // Adds "stats" into the current state.  Returns true if a new
   // compaction may need to be triggered, false otherwise.
@@ -115,6 +127,16 @@ class Version {
 
   int NumFiles(int level) const { return files_[level].size(); }
 
+  // Return the range tombstones that are live in this version.
+  const RangeTombstoneList& range_tombstones() const {
+    return range_tombstones_;
+  }
+
+  // Return the same range tombstones fragmented for fast lookups.
+  const FragmentedRangeTombstoneList& range_tombstone_fragments() const {
+    return range_tombstone_fragments_;
+  }
+
   // Return a human readable string that describes this version's contents.
   std::string DebugString() const;
 
@@ -123,6 +145,8 @@ class Version {
   friend class VersionSet;
 
   class LevelFileNumIterator;
+  // Return NULL if no file at "level" is within the iterate bounds
+  // specified in the options.
   Iterator* NewConcatenatingIterator(const ReadOptions&, int level) const;
 
   // Call func(arg, level, f) for every file that overlaps user_key in
@@ -141,6 +165,10 @@ class Version {
   // List of files per level
   std::vector<FileMetaData*> files_[config::kNumLevels];
 
+  // List of range tombstones ordered by sequence number
+  RangeTombstoneList range_tombstones_;
+  FragmentedRangeTombstoneList range_tombstone_fragments_;
+
   // Next file to compact based on seek stats.
   FileMetaData* file_to_compact_;
   int file_to_compact_level_;
@@ -301,6 +329,10 @@ class VersionSet {
 
   void SetupOtherInputs(Compaction* c);
 
+  // Pick a set of the newest Level-0 runs to merge into a single run.
+  // REQUIRES: options_->compaction_style == kCompactionStyleTiered
+  Compaction* PickTieredCompaction();
+
   // Save current contents to *log
   Status WriteSnapshot(log::Writer* log);
 
@@ -340,9 +372,13 @@ class Compaction {
   ~Compaction();
 
   // Return the level that is being compacted.  Inputs from "level"
-  // and "level+1" will be merged to produce a set of "level+1" files.
+  // and "level+1" will be merged to produce a set of "output_level" files.
   int level() const { return level_; }
 
+  // Return the level that receives the outputs of the compaction.  This is
+  // "level+1" except for tiered compactions, which write back to Level-0.
+  int output_level() const { return output_level_; }
+
   // Return the object that holds the edits to the descriptor done
   // by this compaction.
   VersionEdit* edit() { return &edit_; }
@@ -364,8 +400,8 @@ class Compaction {
   void AddInputDeletions(VersionEdit* edit);
 
   // Returns true if the information we have available guarantees that
-  // the compaction is producing data in "level+1" for which no data exists
-  // in levels greater than "level+1".
+  // the compaction is producing data in "output_level" for which no data
+  // exists in older runs or in levels greater than "output_level".
   bool IsBaseLevelForKey(const Slice& user_key);
 
   // Returns true iff we should stop building the current output
@@ -383,6 +419,9 @@ class Compaction {
   explicit Compaction(const Options* options, int level);
 
   int level_;
+  int output_level_;
+  // True if a tiered compaction merges the oldest Level-0 run
+  bool includes_oldest_run_;
   uint64_t max_output_file_size_;
   int64_t max_grand_parent_overlap_bytes_;
   Version* input_version_;
@@ -404,7 +443,7 @@ class Compaction {
   // level_ptrs_ holds indices into input_version_->levels_: our state
   // is that we are positioned at one of the file ranges for each
   // higher level than the ones involved in this compaction (i.e. for
-  // all L >= level_ + 2).
+  // all L > output_level_).
   size_t level_ptrs_[config::kNumLevels];
 };
 
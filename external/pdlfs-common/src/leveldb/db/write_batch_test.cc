@@ -51,6 +51,17 @@ static std::string PrintContents(WriteBatch* b) {
     state.append(NumberToString(ikey.sequence));
   }
   delete iter;
+  RangeTombstoneList tombstones;
+  mem->GetRangeTombstones(&tombstones);
+  for (size_t i = 0; i < tombstones.size(); i++) {
+    state.append("DeleteRange(");
+    state.append(tombstones[i].begin);
+    state.append(", ");
+    state.append(tombstones[i].end);
+    state.append(")@");
+    state.append(NumberToString(tombstones[i].seq));
+    count++;
+  }
   if (!s.ok()) {
     state.append("ParseError()");
   } else if (count != WriteBatchInternal::Count(b)) {
@@ -83,6 +94,20 @@ TEST(WriteBatchTest, Multiple) {
       PrintContents(&batch));
 }
 
+TEST(WriteBatchTest, DeleteRange) {
+  WriteBatch batch;
+  batch.Put(Slice("foo"), Slice("bar"));
+  batch.DeleteRange(Slice("a"), Slice("g"));
+  batch.Put(Slice("baz"), Slice("boo"));
+  WriteBatchInternal::SetSequence(&batch, 100);
+  ASSERT_EQ(3, WriteBatchInternal::Count(&batch));
+  ASSERT_EQ(
+      "Put(baz, boo)@102"
+      "Put(foo, bar)@100"
+      "DeleteRange(a, g)@101",
+      PrintContents(&batch));
+}
+
 TEST(WriteBatchTest, Corruption) {
   WriteBatch batch;
   batch.Put(Slice("foo"), Slice("bar"));
@@ -23,6 +23,10 @@ class Block;
 class RandomAccessFile;
 struct ReadOptions;
 
+namespace port {
+struct ZstdUncompressor;
+}
+
 // BlockHandle is a pointer to the extent of a file that stores a data
 // block or a meta block.
 class BlockHandle {
@@ -90,9 +94,11 @@ struct BlockContents {
 };
 
 // Read the block identified by "handle" from "file".  On failure
-// return non-OK.  On success fill *result and return OK.
+// return non-OK.  On success fill *result and return OK.  Zstd blocks
+// compressed with a dictionary require the matching "*zstd".
 extern Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
-                        const BlockHandle& handle, BlockContents* result);
+                        const BlockHandle& handle, BlockContents* result,
+                        port::ZstdUncompressor* zstd = NULL);
 
 // Implementation details follow.  Clients should ignore,
 inline BlockHandle::BlockHandle()
@@ -24,6 +24,7 @@
 #include "pdlfs-common/leveldb/iterator.h"
 #include "pdlfs-common/leveldb/table.h"
 #include "pdlfs-common/leveldb/table_properties.h"
+#include "pdlfs-common/port.h"
 
 namespace pdlfs {
 
@@ -41,11 +42,15 @@ struct Table::Rep {
   TableProperties props;  // All properties embedded in the table
   bool props_valid;
 
+  // Dictionary for data blocks compressed with zstd, or NULL
+  port::ZstdUncompressor* zstd;
+
   explicit Rep() {}
   ~Rep() {
     delete filter;
     delete[] filter_data;
     delete index_block;
+    port::Zstd_DeleteUncompressor(zstd);
   }
 };
 
@@ -92,6 +97,7 @@ Status Table::Open(const Options& options, RandomAccessFile* file,
     rep->filter_data = NULL;
     rep->filter = NULL;
     rep->props_valid = false;
+    rep->zstd = NULL;
 
     *table = new Table(rep);
     (*table)->ReadMeta(footer);
@@ -118,6 +124,12 @@ void Table::ReadMeta(const Footer& footer) {
   Block* meta = new Block(contents);
   Iterator* iter = meta->NewIterator(BytewiseComparator());
 
+  Slice dict_key("compression.dict");
+  iter->Seek(dict_key);
+  if (iter->Valid() && iter->key() == dict_key) {
+    ReadCompressionDict(iter->value());
+  }
+
   Slice props_key("table.properties");
   iter->Seek(props_key);
   if (iter->Valid() && iter->key() == props_key) {
@@ -185,6 +197,28 @@ void Table::ReadProps(const Slice& handle_value) {
   }
 }
 
+void Table::ReadCompressionDict(const Slice& handle_value) {
+  Rep* r = rep_;
+  Slice v = handle_value;
+  BlockHandle handle;
+  if (!handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  ReadOptions opt;
+  if (r->options.paranoid_checks) {
+    opt.verify_checksums = true;
+  }
+  BlockContents block;
+  if (!ReadBlock(r->file, opt, handle, &block).ok()) {
+    return;
+  }
+  r->zstd = port::Zstd_NewUncompressor(block.data.data(), block.data.size());
+  if (block.heap_allocated) {
+    delete[] block.data.data();
+  }
+}
+
 static void DeleteBlock(void* arg, void* ignored) {
   delete reinterpret_cast<Block*>(arg);
 }
@@ -204,7 +238,14 @@ static void ReleaseBlock(void* arg, void* h) {
 // into an iterator over the contents of the corresponding block.
 Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
                              const Slice& index_value) {
-  Table* table = reinterpret_cast<Table*>(arg);
+  bool ignored;
+  return BlockReader(reinterpret_cast<Table*>(arg), options, index_value,
+                     &ignored);
+}
+
+Iterator* Table::BlockReader(Table* table, const ReadOptions& options,
+                             const Slice& index_value, bool* from_storage) {
+  *from_storage = false;
   Cache* block_cache = table->rep_->options.block_cache;
   Block* block = NULL;
   Cache::Handle* cache_handle = NULL;
@@ -226,7 +267,9 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
       if (cache_handle != NULL) {
         block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
       } else {
-        s = ReadBlock(table->rep_->file, options, handle, &contents);
+        *from_storage = true;
+        s = ReadBlock(table->rep_->file, options, handle, &contents,
+                      table->rep_->zstd);
         if (s.ok()) {
           block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
@@ -236,7 +279,9 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
         }
       }
     } else {
-      s = ReadBlock(table->rep_->file, options, handle, &contents);
+      *from_storage = true;
+      s = ReadBlock(table->rep_->file, options, handle, &contents,
+                    table->rep_->zstd);
       if (s.ok()) {
         block = new Block(contents);
       }
@@ -257,6 +302,53 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
   return iter;
 }
 
+void Table::GetCachedBlockRanges(
+    std::vector<std::pair<std::string, std::string> >* ranges) const {
+  Cache* block_cache = rep_->options.block_cache;
+  if (block_cache == NULL) {
+    return;
+  }
+  char cache_key_buffer[16];
+  EncodeFixed64(cache_key_buffer, rep_->cache_id);
+  std::string prev_key;
+  Iterator* iiter = rep_->index_block->NewIterator();
+  for (iiter->SeekToFirst(); iiter->Valid(); iiter->Next()) {
+    Slice handle_value = iiter->value();
+    BlockHandle handle;
+    if (handle.DecodeFrom(&handle_value).ok()) {
+      EncodeFixed64(cache_key_buffer + 8, handle.offset());
+      Slice key(cache_key_buffer, sizeof(cache_key_buffer));
+      Cache::Handle* cache_handle = block_cache->Lookup(key);
+      if (cache_handle != NULL) {
+        ranges->push_back(std::make_pair(prev_key, iiter->key().ToString()));
+        block_cache->Release(cache_handle);
+      }
+    }
+    prev_key = iiter->key().ToString();
+  }
+  delete iiter;
+}
+
+void Table::InsertCachedBlock(uint64_t offset, const Slice& contents) const {
+  Cache* block_cache = rep_->options.block_cache;
+  if (block_cache == NULL) {
+    return;
+  }
+  char cache_key_buffer[16];
+  EncodeFixed64(cache_key_buffer, rep_->cache_id);
+  EncodeFixed64(cache_key_buffer + 8, offset);
+  Slice key(cache_key_buffer, sizeof(cache_key_buffer));
+  char* buf = new char[contents.size()];
+  memcpy(buf, contents.data(), contents.size());
+  BlockContents block_contents;
+  block_contents.data = Slice(buf, contents.size());
+  block_contents.cachable = true;
+  block_contents.heap_allocated = true;
+  Block* block = new Block(block_contents);
+  block_cache->Release(
+      block_cache->Insert(key, block, block->size(), &DeleteCachedBlock));
+}
+
 Iterator* Table::NewIterator(const ReadOptions& options) const {
   return NewTwoLevelIterator(rep_->index_block->NewIterator(),
                              &Table::BlockReader, const_cast<Table*>(this),
@@ -264,7 +356,8 @@ Iterator* Table::NewIterator(const ReadOptions& options) const {
 }
 
 Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
-                          void (*saver)(void*, const Slice&, const Slice&)) {
+                          void (*saver)(void*, const Slice&, const Slice&),
+                          ReadStats* stats) {
   Status s;
   Iterator* iiter = rep_->index_block->NewIterator();
   iiter->Seek(k);
@@ -275,8 +368,16 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
     if (filter != NULL && handle.DecodeFrom(&handle_value).ok() &&
         !filter->KeyMayMatch(handle.offset(), k)) {
       // Not found
+      if (stats != NULL) {
+        stats->filter_rejects++;
+      }
     } else {
-      Iterator* block_iter = BlockReader(this, options, iiter->value());
+      bool from_storage;
+      Iterator* block_iter =
+          BlockReader(this, options, iiter->value(), &from_storage);
+      if (stats != NULL && from_storage) {
+        stats->blocks_read++;
+      }
       block_iter->Seek(k);
       if (block_iter->Valid()) {
         Slice v = (options.limit != 0) ? block_iter->value() : Slice();
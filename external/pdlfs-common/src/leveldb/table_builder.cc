@@ -56,6 +56,15 @@ struct TableBuilder::Rep {
 
   std::string compressed_output;
 
+  // Zstd state, created on first use
+  std::string compression_dict;
+  port::ZstdCompressor* zstd;
+
+  // Data blocks kept for warming a block cache
+  size_t retain_budget;
+  bool data_block_hot;
+  std::vector<std::pair<uint64_t, std::string> > retained_blocks;
+
   Rep(const Options& options, WritableFile* f)
       : options(options),
         file(f),
@@ -68,7 +77,10 @@ struct TableBuilder::Rep {
         filter_block(options.filter_policy != NULL
                          ? new FilterBlockBuilder(options.filter_policy)
                          : NULL),
-        pending_index_entry(false) {
+        pending_index_entry(false),
+        zstd(NULL),
+        retain_budget(0),
+        data_block_hot(false) {
     assert(options.comparator != NULL);
   }
 };
@@ -100,6 +112,7 @@ TableBuilder::~TableBuilder() {
   assert(rep_->closed);  // Catch errors where caller forgot to call Finish()
   delete rep_->filter_block;
   delete rep_->index_block;
+  port::Zstd_DeleteCompressor(rep_->zstd);
   delete rep_;
 }
 
@@ -117,6 +130,26 @@ Status TableBuilder::ChangeOptions(const Options& options) {
   return Status::OK();
 }
 
+void TableBuilder::SetCompressionDictionary(const Slice& dict) {
+  Rep* r = rep_;
+  assert(r->num_blocks == 0);
+  r->compression_dict = dict.ToString();
+  port::Zstd_DeleteCompressor(r->zstd);
+  r->zstd = NULL;
+}
+
+void TableBuilder::RetainHotBlocks(size_t budget) {
+  rep_->retain_budget = budget;
+}
+
+void TableBuilder::MarkNextKeyHot() { rep_->data_block_hot = true; }
+
+void TableBuilder::TakeRetainedBlocks(
+    std::vector<std::pair<uint64_t, std::string> >* blocks) {
+  blocks->swap(rep_->retained_blocks);
+  rep_->retained_blocks.clear();
+}
+
 void TableBuilder::Add(const Slice& key, const Slice& value) {
   Rep* r = rep_;
   assert(!r->closed);
@@ -175,12 +208,20 @@ void TableBuilder::Flush() {
 }
 
 void TableBuilder::AddBlock(BlockBuilder* builder, BlockHandle* handle) {
-  WriteBlock(builder->Finish(), handle);
+  Rep* r = rep_;
+  Slice contents = builder->Finish();
+  WriteBlock(contents, handle, true);
+  if (ok() && r->data_block_hot && contents.size() <= r->retain_budget) {
+    r->retain_budget -= contents.size();
+    r->retained_blocks.push_back(
+        std::make_pair(handle->offset(), contents.ToString()));
+  }
+  r->data_block_hot = false;
   builder->Reset();
 }
 
 void TableBuilder::WriteBlock(const Slice& block_contents,
-                              BlockHandle* handle) {
+                              BlockHandle* handle, bool use_dict) {
   // File format contains a sequence of blocks where each block has:
   //    block_data: uint8[n]
   //    type: uint8
@@ -209,6 +250,29 @@ void TableBuilder::WriteBlock(const Slice& block_contents,
       }
       break;
     }
+
+    case kZstdCompression: {
+      if (r->zstd == NULL) {
+        r->zstd = port::Zstd_NewCompressor(r->compression_dict.data(),
+                                           r->compression_dict.size());
+      }
+      std::string* compressed = &r->compressed_output;
+      if (port::Zstd_Compress(r->zstd, use_dict, block_contents.data(),
+                              block_contents.size(), compressed) &&
+          compressed->size() <
+              block_contents.size() - (block_contents.size() / 8u)) {
+        raw_block_contents = *compressed;
+      } else {
+        raw_block_contents = block_contents;
+        type = kNoCompression;
+      }
+      break;
+    }
+
+    default:
+      raw_block_contents = block_contents;
+      type = kNoCompression;
+      break;
   }
   WriteRawBlock(raw_block_contents, type, handle);
   r->compressed_output.clear();
@@ -240,6 +304,7 @@ Status TableBuilder::Finish() {
   assert(!r->closed);
   r->closed = true;
   BlockHandle filter_block_handle;
+  BlockHandle dict_block_handle;
   BlockHandle props_block_handle;
   BlockHandle metaindex_block_handle;
   BlockHandle index_block_handle;
@@ -252,6 +317,15 @@ Status TableBuilder::Finish() {
     }
   }
 
+  // Write compression dictionary
+  const bool has_dict = r->options.compression == kZstdCompression &&
+                        !r->compression_dict.empty();
+  if (ok()) {
+    if (has_dict) {
+      WriteRawBlock(r->compression_dict, kNoCompression, &dict_block_handle);
+    }
+  }
+
   // Write stats
   if (ok()) {
     r->props_.SetLastKey(r->last_key);
@@ -264,6 +338,12 @@ Status TableBuilder::Finish() {
   if (ok()) {
     BlockBuilder meta_index_block(1);
 
+    if (has_dict) {
+      std::string handle_encoding;
+      dict_block_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add("compression.dict", handle_encoding);
+    }
+
     if (r->filter_block != NULL) {
       // Add mapping from "filter.Name" to location of filter data
       std::string key = "filter.";
@@ -102,4 +102,24 @@ void LookupCache::Erase(const DirId& pid, const Slice& nhash) {
   }
 }
 
+void LookupCache::EnableSimulation() {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.EnableSimulation();
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
+void LookupCache::GetStats(LRUCacheStats* stats) {
+  if (mu_ != NULL) {
+    mu_->Lock();
+  }
+  lru_.GetStats(stats);
+  if (mu_ != NULL) {
+    mu_->Unlock();
+  }
+}
+
 }  // namespace pdlfs
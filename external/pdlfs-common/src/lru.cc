@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2015-2017 Carnegie Mellon University.
+ *
+ * All rights reserved.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file. See the AUTHORS file for names of contributors.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "pdlfs-common/lru.h"
+
+namespace pdlfs {
+
+LRUCacheStats::LRUCacheStats() { Clear(); }
+
+void LRUCacheStats::Clear() {
+  hits = 0;
+  misses = 0;
+  inserts = 0;
+  evictions = 0;
+  for (int i = 0; i < kNumGhostLevels; i++) {
+    ghost_hits[i] = 0;
+  }
+  usage = 0;
+  capacity = 0;
+  eviction_ages.Clear();
+}
+
+void LRUCacheStats::Merge(const LRUCacheStats& other) {
+  hits += other.hits;
+  misses += other.misses;
+  inserts += other.inserts;
+  evictions += other.evictions;
+  for (int i = 0; i < kNumGhostLevels; i++) {
+    ghost_hits[i] += other.ghost_hits[i];
+  }
+  usage += other.usage;
+  capacity += other.capacity;
+  eviction_ages.Merge(other.eviction_ages);
+}
+
+double LRUCacheStats::HitRatio() const {
+  const uint64_t lookups = hits + misses;
+  if (lookups == 0) {
+    return 0;
+  } else {
+    return static_cast<double>(hits) / lookups;
+  }
+}
+
+double LRUCacheStats::SimulatedHitRatio(int level) const {
+  assert(level >= 0 && level < kNumGhostLevels);
+  const uint64_t lookups = hits + misses;
+  if (lookups == 0) {
+    return 0;
+  } else {
+    return static_cast<double>(hits + ghost_hits[level]) / lookups;
+  }
+}
+
+std::string LRUCacheStats::ToString() const {
+  char tmp[200];
+  std::string result;
+  snprintf(tmp, sizeof(tmp),
+           "Hits: %llu Misses: %llu Hit ratio: %.2f%%\n"
+           "Inserts: %llu Evictions: %llu Usage: %llu/%llu\n",
+           static_cast<unsigned long long>(hits),
+           static_cast<unsigned long long>(misses), 100 * HitRatio(),
+           static_cast<unsigned long long>(inserts),
+           static_cast<unsigned long long>(evictions),
+           static_cast<unsigned long long>(usage),
+           static_cast<unsigned long long>(capacity));
+  result.append(tmp);
+  for (int i = 0; i < kNumGhostLevels; i++) {
+    snprintf(tmp, sizeof(tmp), "Simulated hit ratio at %dx capacity: %.2f%%\n",
+             1 << (i + 1), 100 * SimulatedHitRatio(i));
+    result.append(tmp);
+  }
+  if (evictions != 0) {
+    result.append("Eviction ages (in number of inserts):\n");
+    result.append(eviction_ages.ToString());
+  }
+  return result;
+}
+
+}  // namespace pdlfs
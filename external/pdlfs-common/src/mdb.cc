@@ -192,6 +192,26 @@ Status MDB::DelNode(const DirId& id, const Slice& hash, Tx* tx) {
   return s;
 }
 
+// Return the smallest key that is greater than all keys starting with
+// "prefix". The prefix ends with the key type so its successor can be
+// obtained by incrementing the last byte.
+static std::string PrefixLimit(const Slice& prefix) {
+  std::string limit = prefix.ToString();
+  assert(!limit.empty());
+  assert(static_cast<unsigned char>(limit[limit.size() - 1]) < 0xff);
+  limit[limit.size() - 1]++;
+  return limit;
+}
+
+Status MDB::DelDir(const DirId& id) {
+  Key key(KEY_INITIALIZER(id, kDirEntType));
+  Slice prefix = key.prefix();
+  std::string limit = PrefixLimit(prefix);
+  WriteOptions options;
+  options.sync = options_.sync;
+  return db_->DeleteRange(options, prefix, limit);
+}
+
 size_t MDB::List(const DirId& id, StatList* stats, NameList* names, Tx* tx,
                  size_t limit) {
   Key key(KEY_INITIALIZER(id, kDirEntType));
@@ -202,6 +222,11 @@ size_t MDB::List(const DirId& id, StatList* stats, NameList* names, Tx* tx,
     options.snapshot = tx->snap;
   }
   Slice prefix = key.prefix();
+  // Bound the iterator so tables outside the directory are never opened
+  std::string prefix_limit = PrefixLimit(prefix);
+  Slice upper_bound = prefix_limit;
+  options.iterate_lower_bound = &prefix;
+  options.iterate_upper_bound = &upper_bound;
   Iterator* iter = db_->NewIterator(options);
   iter->Seek(prefix);
   Slice name;
@@ -229,20 +254,63 @@ size_t MDB::List(const DirId& id, StatList* stats, NameList* names, Tx* tx,
   return num_entries;
 }
 
+size_t MDB::ListNext(const DirId& id, const Slice& hash, StatList* stats,
+                     HashList* hashes, Tx* tx, size_t limit) {
+  Key key(KEY_INITIALIZER(id, kDirEntType));
+  key.SetHash(hash);
+  ReadOptions options;
+  options.verify_checksums = options_.verify_checksums;
+  options.fill_cache = false;
+  if (tx != NULL) {
+    options.snapshot = tx->snap;
+  }
+  Slice prefix = key.prefix();
+  std::string prefix_limit = PrefixLimit(prefix);
+  Slice lower_bound = key.Encode();
+  Slice upper_bound = prefix_limit;
+  options.iterate_lower_bound = &lower_bound;
+  options.iterate_upper_bound = &upper_bound;
+  Iterator* iter = db_->NewIterator(options);
+  iter->Seek(key.Encode());
+  if (iter->Valid() && iter->key() == key.Encode()) {
+    iter->Next();  // Skip the entry itself
+  }
+  Slice name;
+  Stat stat;
+  size_t num_entries = 0;
+  for (; iter->Valid() && num_entries < limit; iter->Next()) {
+    Slice k = iter->key();
+    if (k.starts_with(prefix)) {
+      Slice input = iter->value();
+      if (stat.DecodeFrom(&input) && GetLengthPrefixedSlice(&input, &name)) {
+        if (stats != NULL) {
+          stats->push_back(stat);
+        }
+        if (hashes != NULL) {
+          k.remove_prefix(prefix.size());
+          hashes->push_back(k.ToString());
+        }
+        num_entries++;
+      }
+    } else {
+      break;
+    }
+  }
+  delete iter;
+
+  return num_entries;
+}
+
 bool MDB::Exists(const DirId& id, const Slice& hash, Tx* tx) {
   Status s;
   Key key(KEY_INITIALIZER(id, kDirEntType));
   key.SetHash(hash);
   ReadOptions options;
   options.verify_checksums = options_.verify_checksums;
-  options.limit = 0;
   if (tx != NULL) {
     options.snapshot = tx->snap;
   }
-  Slice ignored;
-  char tmp[1];
-  s = db_->Get(options, key.Encode(), &ignored, tmp, sizeof(tmp));
-  assert(!s.IsBufferFull());
+  s = db_->Exists(options, key.Encode());
   if (!s.ok()) {
     return false;
   } else {
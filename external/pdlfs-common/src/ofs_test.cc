@@ -97,6 +97,97 @@ TEST(OfsTest, CreateDeleteFile) {
   ASSERT_OK(Unmount());
 }
 
+TEST(OfsTest, FlatStoreKeepsLayout) {
+  ASSERT_OK(Mount());
+  WritableFile* wf;
+  ASSERT_OK(ofs_->NewWritableFile("/mnt/fset/a", &wf));
+  wf->Close();
+  delete wf;
+  ASSERT_OK(Unmount());
+  delete ofs_;
+  delete osd_;
+  // Flat stores record no fan-out
+  ASSERT_TRUE(!Env::Default()->FileExists((root_ + "/FANOUT").c_str()));
+  osd_ = Osd::FromEnv(root_.c_str(), NULL, 16);
+  ofs_ = new Ofs(osd_);
+  ASSERT_OK(Mount());
+  ASSERT_TRUE(ofs_->FileExists("/mnt/fset/a"));
+  ASSERT_OK(ofs_->DeleteFile("/mnt/fset/a"));
+  unmount_opts_.deletion = true;
+  ASSERT_OK(Unmount());
+}
+
+TEST(OfsTest, BadFanoutFile) {
+  delete ofs_;
+  delete osd_;
+  const std::string fname = root_ + "/FANOUT";
+  ASSERT_OK(WriteStringToFile(Env::Default(), "junk", fname.c_str()));
+  osd_ = Osd::FromEnv(root_.c_str(), NULL, 16);
+  ofs_ = new Ofs(osd_);
+  ASSERT_TRUE(osd_->Put("a", "x").IsCorruption());
+  ASSERT_TRUE(!osd_->Exists("a"));
+  // The bad file must be left as is
+  std::string data;
+  ASSERT_OK(ReadFileToString(Env::Default(), fname.c_str(), &data));
+  ASSERT_EQ(data, "junk");
+  ASSERT_OK(Env::Default()->DeleteFile(fname.c_str()));
+}
+
+TEST(OfsTest, HashedFanout) {
+  delete ofs_;
+  delete osd_;
+  // Start over as a brand new store
+  Env::Default()->DeleteFile((root_ + "/FANOUT").c_str());
+  osd_ = Osd::FromEnv(root_.c_str(), NULL, 16);
+  ofs_ = new Ofs(osd_);
+  ASSERT_OK(Mount());
+  char tmp[50];
+  for (int i = 0; i < 100; i++) {
+    snprintf(tmp, sizeof(tmp), "/mnt/fset/f%d", i);
+    WritableFile* wf;
+    ASSERT_OK(ofs_->NewWritableFile(tmp, &wf));
+    wf->Close();
+    delete wf;
+  }
+  ASSERT_OK(Unmount());
+  ASSERT_OK(Mount());
+  for (int i = 0; i < 100; i++) {
+    snprintf(tmp, sizeof(tmp), "/mnt/fset/f%d", i);
+    ASSERT_TRUE(ofs_->FileExists(tmp));
+  }
+  std::vector<std::string> children;
+  ASSERT_OK(Env::Default()->GetChildren(root_.c_str(), &children));
+  size_t num_objs = 0;
+  for (size_t i = 0; i < children.size(); i++) {
+    if (Slice(children[i]).starts_with("obj_")) {
+      num_objs++;
+    }
+  }
+  // Objects must not land in the top-level directory
+  ASSERT_EQ(num_objs, 0);
+  // Re-opening with a different fan-out must not hide existing objects
+  ASSERT_OK(Unmount());
+  delete ofs_;
+  delete osd_;
+  osd_ = Osd::FromEnv(root_.c_str(), NULL, 4);
+  ofs_ = new Ofs(osd_);
+  ASSERT_OK(Mount());
+  for (int i = 0; i < 100; i++) {
+    snprintf(tmp, sizeof(tmp), "/mnt/fset/f%d", i);
+    ASSERT_TRUE(ofs_->FileExists(tmp));
+  }
+  for (int i = 0; i < 100; i++) {
+    snprintf(tmp, sizeof(tmp), "/mnt/fset/f%d", i);
+    ASSERT_OK(ofs_->DeleteFile(tmp));
+  }
+  unmount_opts_.deletion = true;
+  ASSERT_OK(Unmount());
+  for (int i = 0; i < 16; i++) {
+    snprintf(tmp, sizeof(tmp), "%s/%03x", root_.c_str(), i);
+    ASSERT_OK(Env::Default()->DeleteDir(tmp));
+  }
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char** argv) {
@@ -9,6 +9,14 @@
 
 #include "pdlfs-common/osd.h"
 #include "pdlfs-common/env.h"
+#include "pdlfs-common/hash.h"
+#include "pdlfs-common/logging.h"
+#include "pdlfs-common/strutil.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
 
 namespace pdlfs {
 
@@ -16,57 +24,78 @@ Osd::~Osd() {}
 
 class EnvOsd : public Osd {
  public:
-  EnvOsd(Env* env, const char* prefix) : env_(env) {
+  EnvOsd(Env* env, const char* prefix, int fanout)
+      : fanout_(fanout > 1 ? std::min(fanout, int(kMaxFanout)) : 0),
+        env_(env) {
     prefix_ = prefix;
     env_->CreateDir(prefix_.c_str());
-    prefix_.append("/obj_");
+    status_ = ResolveFanout(&fanout_);
+    if (!status_.ok()) {
+      Error(__LOG_ARGS__, "Cannot open osd %s: %s", prefix_.c_str(),
+            status_.ToString().c_str());
+    } else if (fanout_ != 0) {
+      char tmp[20];
+      for (int i = 0; i < fanout_; i++) {
+        snprintf(tmp, sizeof(tmp), "/%03x", i);
+        env_->CreateDir((prefix_ + tmp).c_str());
+      }
+    }
   }
 
   virtual ~EnvOsd() {}
 
   virtual Status NewSequentialObj(const char* name, SequentialFile** r) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return env_->NewSequentialFile(fp.c_str(), r);
   }
 
   virtual Status NewRandomAccessObj(const char* name, RandomAccessFile** r) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return env_->NewRandomAccessFile(fp.c_str(), r);
   }
 
   virtual Status NewWritableObj(const char* name, WritableFile** r) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return env_->NewWritableFile(fp.c_str(), r);
   }
 
   virtual bool Exists(const char* name) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return false;
+    const std::string fp = ObjPath(name);
     return env_->FileExists(fp.c_str());
   }
 
   virtual Status Size(const char* name, uint64_t* obj_size) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return env_->GetFileSize(fp.c_str(), obj_size);
   }
 
   virtual Status Delete(const char* name) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return env_->DeleteFile(fp.c_str());
   }
 
   virtual Status Put(const char* name, const Slice& data) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return WriteStringToFile(env_, data, fp.c_str());
   }
 
   virtual Status Get(const char* name, std::string* data) {
-    const std::string fp = prefix_ + name;
+    if (!status_.ok()) return status_;
+    const std::string fp = ObjPath(name);
     return ReadFileToString(env_, fp.c_str(), data);
   }
 
   virtual Status Copy(const char* src, const char* dst) {
-    const std::string fp1 = prefix_ + src;
-    const std::string fp2 = prefix_ + dst;
+    if (!status_.ok()) return status_;
+    const std::string fp1 = ObjPath(src);
+    const std::string fp2 = ObjPath(dst);
     return env_->CopyFile(fp1.c_str(), fp2.c_str());
   }
 
@@ -75,13 +104,83 @@ class EnvOsd : public Osd {
   void operator=(const EnvOsd&);
   EnvOsd(const EnvOsd&);
 
+  // Set *fanout to the fan-out the objects under the prefix have been laid
+  // out with. A non-zero fan-out is stored in a small metadata file when a
+  // store is first opened with it. Re-opening the store with a different
+  // fan-out would hide all existing objects, so the stored value always
+  // wins. Without the file, the store is flat if it contains any top-level
+  // object. The file is only created when it is missing. Any other error
+  // reading it is returned as is.
+  Status ResolveFanout(int* fanout) {
+    const std::string fname = prefix_ + "/FANOUT";
+    std::string data;
+    Status s = ReadFileToString(env_, fname.c_str(), &data);
+    if (s.ok()) {
+      Slice input(data);
+      uint64_t stored;
+      if (!ConsumeDecimalNumber(&input, &stored) || stored > kMaxFanout) {
+        return Status::Corruption("Bad fanout file", fname);
+      }
+      if (static_cast<int>(stored) != *fanout) {
+        Warn(__LOG_ARGS__, "Osd %s has fanout %d (%d requested)",
+             prefix_.c_str(), static_cast<int>(stored), *fanout);
+      }
+      *fanout = static_cast<int>(stored);
+      return s;
+    } else if (!s.IsNotFound()) {
+      return s;
+    }
+    if (*fanout == 0) {
+      return Status::OK();  // Flat stores record nothing
+    } else if (HasFlatObjs()) {
+      Warn(__LOG_ARGS__, "Osd %s has a flat layout (fanout %d requested)",
+           prefix_.c_str(), *fanout);
+      *fanout = 0;
+      return Status::OK();
+    }
+    char tmp[20];
+    snprintf(tmp, sizeof(tmp), "%d", *fanout);
+    return WriteStringToFile(env_, tmp, fname.c_str());
+  }
+
+  bool HasFlatObjs() {
+    std::vector<std::string> names;
+    env_->GetChildren(prefix_.c_str(), &names);
+    for (size_t i = 0; i < names.size(); i++) {
+      if (Slice(names[i]).starts_with("obj_")) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  enum { kMaxFanout = 4096 };
+
+  // Map an object name to its underlying file path. With fan-out enabled,
+  // objects are spread across sub-directories by the hash of their names.
+  std::string ObjPath(const char* name) const {
+    std::string result = prefix_;
+    if (fanout_ != 0) {
+      char tmp[20];
+      uint32_t h = Hash(name, strlen(name), 0) % fanout_;
+      snprintf(tmp, sizeof(tmp), "/%03x", static_cast<unsigned>(h));
+      result.append(tmp);
+    }
+    result.append("/obj_");
+    result.append(name);
+    return result;
+  }
+
   std::string prefix_;
+  int fanout_;
+  // Error resolving the fan-out. Fails all operations if not OK
+  Status status_;
   Env* env_;
 };
 
-Osd* Osd::FromEnv(const char* prefix, Env* env) {
+Osd* Osd::FromEnv(const char* prefix, Env* env, int fanout) {
   if (env == NULL) env = Env::Default();
-  return new EnvOsd(env, prefix);
+  return new EnvOsd(env, prefix, fanout);
 }
 
 }  // namespace pdlfs
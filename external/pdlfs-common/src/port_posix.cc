@@ -14,6 +14,10 @@
 
 #include <errno.h>
 #include <stdio.h>
+#ifdef PDLFS_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
 
 namespace pdlfs {
 namespace port {
@@ -134,5 +138,162 @@ uint64_t PthreadId() {
   return thread_id;
 }
 
+#ifdef PDLFS_ZSTD
+struct ZstdCompressor {
+  ZSTD_CCtx* cctx;
+  ZSTD_CDict* cdict;  // NULL if there is no dictionary
+};
+
+struct ZstdUncompressor {
+  ZSTD_DDict* ddict;
+  Mutex mu;
+  std::vector<ZSTD_DCtx*> free_ctxs;  // Contexts ready for reuse
+};
+
+ZstdCompressor* Zstd_NewCompressor(const char* dict, size_t dict_size) {
+  ZstdCompressor* c = new ZstdCompressor;
+  c->cctx = ZSTD_createCCtx();
+  c->cdict = NULL;
+  if (dict_size != 0) {
+    c->cdict = ZSTD_createCDict(dict, dict_size, ZSTD_CLEVEL_DEFAULT);
+  }
+  return c;
+}
+
+void Zstd_DeleteCompressor(ZstdCompressor* c) {
+  if (c != NULL) {
+    ZSTD_freeCDict(c->cdict);
+    ZSTD_freeCCtx(c->cctx);
+    delete c;
+  }
+}
+
+bool Zstd_Compress(ZstdCompressor* c, bool use_dict, const char* input,
+                   size_t length, std::string* output) {
+  output->resize(ZSTD_compressBound(length));
+  size_t n;
+  if (use_dict && c->cdict != NULL) {
+    n = ZSTD_compress_usingCDict(c->cctx, &(*output)[0], output->size(), input,
+                                 length, c->cdict);
+  } else {
+    n = ZSTD_compressCCtx(c->cctx, &(*output)[0], output->size(), input,
+                          length, ZSTD_CLEVEL_DEFAULT);
+  }
+  if (ZSTD_isError(n)) {
+    output->clear();
+    return false;
+  }
+  output->resize(n);
+  return true;
+}
+
+ZstdUncompressor* Zstd_NewUncompressor(const char* dict, size_t dict_size) {
+  ZstdUncompressor* u = new ZstdUncompressor;
+  u->ddict = ZSTD_createDDict(dict, dict_size);
+  if (u->ddict == NULL) {
+    delete u;
+    return NULL;
+  }
+  return u;
+}
+
+void Zstd_DeleteUncompressor(ZstdUncompressor* u) {
+  if (u != NULL) {
+    for (size_t i = 0; i < u->free_ctxs.size(); i++) {
+      ZSTD_freeDCtx(u->free_ctxs[i]);
+    }
+    ZSTD_freeDDict(u->ddict);
+    delete u;
+  }
+}
+
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result) {
+  unsigned long long n = ZSTD_getFrameContentSize(input, length);
+  if (n == ZSTD_CONTENTSIZE_UNKNOWN || n == ZSTD_CONTENTSIZE_ERROR) {
+    return false;
+  }
+  *result = static_cast<size_t>(n);
+  return true;
+}
+
+bool Zstd_Uncompress(ZstdUncompressor* u, const char* input, size_t length,
+                     char* output, size_t output_size) {
+  size_t n;
+  if (u == NULL) {
+    n = ZSTD_decompress(output, output_size, input, length);
+  } else {
+    ZSTD_DCtx* dctx = NULL;
+    u->mu.Lock();
+    if (!u->free_ctxs.empty()) {
+      dctx = u->free_ctxs.back();
+      u->free_ctxs.pop_back();
+    }
+    u->mu.Unlock();
+    if (dctx == NULL) {
+      dctx = ZSTD_createDCtx();
+    }
+    n = ZSTD_decompress_usingDDict(dctx, output, output_size, input, length,
+                                   u->ddict);
+    u->mu.Lock();
+    u->free_ctxs.push_back(dctx);
+    u->mu.Unlock();
+  }
+  return !ZSTD_isError(n) && n == output_size;
+}
+
+bool Zstd_TrainDictionary(const std::string& samples,
+                          const std::vector<size_t>& sample_sizes,
+                          size_t max_dict_size, std::string* dict) {
+  if (sample_sizes.empty() || max_dict_size == 0) {
+    return false;
+  }
+  dict->resize(max_dict_size);
+  size_t n = ZDICT_trainFromBuffer(&(*dict)[0], max_dict_size, samples.data(),
+                                   &sample_sizes[0],
+                                   static_cast<unsigned>(sample_sizes.size()));
+  if (ZDICT_isError(n)) {
+    dict->clear();
+    return false;
+  }
+  dict->resize(n);
+  return true;
+}
+
+#else
+ZstdCompressor* Zstd_NewCompressor(const char* dict, size_t dict_size) {
+  return NULL;
+}
+
+void Zstd_DeleteCompressor(ZstdCompressor* c) {}
+
+bool Zstd_Compress(ZstdCompressor* c, bool use_dict, const char* input,
+                   size_t length, std::string* output) {
+  return false;
+}
+
+ZstdUncompressor* Zstd_NewUncompressor(const char* dict, size_t dict_size) {
+  return NULL;
+}
+
+void Zstd_DeleteUncompressor(ZstdUncompressor* u) {}
+
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result) {
+  return false;
+}
+
+bool Zstd_Uncompress(ZstdUncompressor* u, const char* input, size_t length,
+                     char* output, size_t output_size) {
+  return false;
+}
+
+bool Zstd_TrainDictionary(const std::string& samples,
+                          const std::vector<size_t>& sample_sizes,
+                          size_t max_dict_size, std::string* dict) {
+  return false;
+}
+#endif
+
 }  // namespace port
 }  // namespace pdlfs
@@ -259,6 +259,50 @@ class PosixEnv : public Env {
     }
   }
 
+  virtual Status NewDirectWritableFile(const char* fname, WritableFile** r) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(PDLFS_OS_LINUX)
+    flags |= O_DIRECT;
+#endif
+    int fd = open(fname, flags, 0644);
+#if defined(PDLFS_OS_LINUX)
+    if (fd == -1 && errno == EINVAL) {
+      // The underlying file system does not support direct I/O
+      fd = open(fname, flags & ~O_DIRECT, 0644);
+    }
+#endif
+    if (fd != -1) {
+      *r = new PosixDirectWritableFile(fname, fd);
+      return Status::OK();
+    } else {
+      *r = NULL;
+      return IOError(fname, errno);
+    }
+  }
+
+  virtual Status NewDirectRandomAccessFile(const char* fname,
+                                           RandomAccessFile** r) {
+#if defined(PDLFS_OS_LINUX)
+    int fd = open(fname, O_RDONLY | O_DIRECT);
+    if (fd != -1) {
+      *r = new PosixDirectRandomAccessFile(fname, fd);
+      return Status::OK();
+    } else if (errno != EINVAL) {
+      *r = NULL;
+      return IOError(fname, errno);
+    }
+    // The underlying file system does not support direct I/O
+#endif
+    int fd2 = open(fname, O_RDONLY);
+    if (fd2 != -1) {
+      *r = new PosixRandomAccessFile(fname, fd2);
+      return Status::OK();
+    } else {
+      *r = NULL;
+      return IOError(fname, errno);
+    }
+  }
+
   virtual bool FileExists(const char* fname) {
     return access(fname, F_OK) == 0;
   }
@@ -507,15 +551,9 @@ class PosixDirectIOWrapper : public EnvWrapper {
     }
   }
 
+  // Falls back to buffered reads if the file system rejects direct I/O
   virtual Status NewRandomAccessFile(const char* fname, RandomAccessFile** r) {
-    int fd = open(fname, O_RDONLY);
-    if (fd != -1) {
-      *r = new PosixRandomAccessFile(fname, fd);
-      return Status::OK();
-    } else {
-      *r = NULL;
-      return IOError(fname, errno);
-    }
+    return target()->NewDirectRandomAccessFile(fname, r);
   }
 
   virtual Status NewSequentialFile(const char* fname, SequentialFile** r) {
@@ -19,9 +19,12 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 namespace pdlfs {
 
 inline Status IOError(const Slice& err_context, int err_number) {
@@ -333,6 +336,163 @@ class PosixWritableFile : public WritableFile {
   }
 };
 
+// Writes data in whole aligned blocks so that the file can be opened with
+// O_DIRECT.  A partially filled tail block is padded with zeros whenever it
+// has to be written out and the padding is truncated away afterwards.  The
+// tail is kept in memory and rewritten once more data arrives.  Only used
+// by Env::NewDirectWritableFile(), e.g. for compaction outputs.
+class PosixDirectWritableFile : public WritableFile {
+ private:
+  static const size_t kAlignment = 4096;
+  static const size_t kBufferSize = 1 << 20;
+
+  std::string filename_;
+  int fd_;
+  char* buf_;
+  size_t pos_;       // Number of bytes in buf_
+  uint64_t offset_;  // File offset of buf_[0]
+
+  Status WriteBuffer(size_t n) {
+    ssize_t nw = pwrite(fd_, buf_, n, static_cast<off_t>(offset_));
+    if (nw != static_cast<ssize_t>(n)) {
+      return IOError(filename_, errno);
+    } else {
+      return Status::OK();
+    }
+  }
+
+  Status WriteTail() {
+    if (pos_ == 0) return Status::OK();
+    const size_t n = (pos_ + kAlignment - 1) & ~(kAlignment - 1);
+    memset(buf_ + pos_, 0, n - pos_);
+    Status s = WriteBuffer(n);
+    if (s.ok() && ftruncate(fd_, static_cast<off_t>(offset_ + pos_)) != 0) {
+      s = IOError(filename_, errno);
+    }
+    return s;
+  }
+
+ public:
+  PosixDirectWritableFile(const char* fname, int fd)
+      : filename_(fname), fd_(fd), buf_(NULL), pos_(0), offset_(0) {
+    void* ptr;
+    if (posix_memalign(&ptr, kAlignment, kBufferSize) != 0) {
+      abort();
+    }
+    buf_ = static_cast<char*>(ptr);
+  }
+
+  virtual ~PosixDirectWritableFile() {
+    if (fd_ != -1) {
+      WriteTail();  // Ignoring any potential errors
+      close(fd_);
+    }
+    free(buf_);
+  }
+
+  virtual Status Append(const Slice& data) {
+    const char* p = data.data();
+    size_t left = data.size();
+    while (left != 0) {
+      const size_t n = std::min(left, kBufferSize - pos_);
+      memcpy(buf_ + pos_, p, n);
+      pos_ += n;
+      p += n;
+      left -= n;
+      if (pos_ == kBufferSize) {
+        Status s = WriteBuffer(kBufferSize);
+        if (!s.ok()) {
+          return s;
+        }
+        offset_ += kBufferSize;
+        pos_ = 0;
+      }
+    }
+    return Status::OK();
+  }
+
+  virtual Status Close() {
+    Status s = WriteTail();
+    if (close(fd_) != 0 && s.ok()) {
+      s = IOError(filename_, errno);
+    }
+    fd_ = -1;
+    return s;
+  }
+
+  virtual Status Flush() {
+    // Data is only written in whole blocks or when synced
+    return Status::OK();
+  }
+
+  virtual Status Sync() {
+    Status s = WriteTail();
+    if (s.ok() && fdatasync(fd_) != 0) {
+      s = IOError(filename_, errno);
+    }
+    return s;
+  }
+};
+
+// Reads data from a file opened with O_DIRECT.  Reads that are not aligned
+// to kAlignment are served by reading the enclosing aligned range into a
+// temporary aligned buffer and copying the requested bytes out of it.
+// Aligned reads go straight into the caller's buffer.
+class PosixDirectRandomAccessFile : public RandomAccessFile {
+ private:
+  std::string filename_;
+  int fd_;
+
+  static bool IsAligned(uint64_t n) { return (n & (kAlignment - 1)) == 0; }
+
+ public:
+  static const size_t kAlignment = 4096;
+
+  PosixDirectRandomAccessFile(const char* fname, int fd)
+      : filename_(fname), fd_(fd) {}
+
+  virtual ~PosixDirectRandomAccessFile() { close(fd_); }
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const {
+    Status s;
+    if (IsAligned(offset) && IsAligned(n) &&
+        IsAligned(reinterpret_cast<uintptr_t>(scratch))) {
+      ssize_t r = pread(fd_, scratch, n, static_cast<off_t>(offset));
+      *result = Slice(scratch, static_cast<size_t>(r < 0 ? 0 : r));
+      if (r < 0) {
+        s = IOError(filename_, errno);
+      }
+      return s;
+    }
+
+    const uint64_t start = offset & ~static_cast<uint64_t>(kAlignment - 1);
+    const uint64_t end = (offset + n + kAlignment - 1) & ~(kAlignment - 1);
+    const size_t len = static_cast<size_t>(end - start);
+    void* ptr;
+    if (posix_memalign(&ptr, kAlignment, len) != 0) {
+      *result = Slice();
+      return Status::IOError(filename_, "Cannot allocate aligned buffer");
+    }
+    char* const buf = static_cast<char*>(ptr);
+    ssize_t r = pread(fd_, buf, len, static_cast<off_t>(start));
+    if (r < 0) {
+      *result = Slice();
+      s = IOError(filename_, errno);
+    } else {
+      const size_t skip = static_cast<size_t>(offset - start);
+      size_t m = 0;
+      if (static_cast<size_t>(r) > skip) {
+        m = std::min(n, static_cast<size_t>(r) - skip);
+      }
+      memcpy(scratch, buf + skip, m);
+      *result = Slice(scratch, m);
+    }
+    free(buf);
+    return s;
+  }
+};
+
 class PosixEmptyFile : public RandomAccessFile {
  public:
   PosixEmptyFile() {}
@@ -633,6 +633,10 @@ int deltafs_nonop() {
 void deltafs_print_sysinfo() {
   // Print to system logger, usually stderr or glog
   pdlfs::PrintSysInfo();
+  // Cache stats are only available after the client has been initialized
+  if (client != NULL) {
+    client->PrintCacheStats();
+  }
 }
 
 // -------------
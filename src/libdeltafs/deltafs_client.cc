@@ -1260,6 +1260,14 @@ mode_t Client::Umask(mode_t mode) {
   return result;
 }
 
+void Client::PrintCacheStats() {
+  LRUCacheStats lookup_stats;
+  LRUCacheStats index_stats;
+  mdscli_->GetCacheStats(&lookup_stats, &index_stats);
+  Info(__LOG_ARGS__, "Lookup cache:\n%s", lookup_stats.ToString().c_str());
+  Info(__LOG_ARGS__, "Index cache:\n%s", index_stats.ToString().c_str());
+}
+
 Status Client::Chroot(const char* path) {
   Status s;
   Slice p = path;
@@ -1613,6 +1621,9 @@ void Client::Builder::OpenMDSCli() {
     if (ok()) {
       status_ = config::LoadParanoidChecks(&mdscliopts_.paranoid_checks);
     }
+    if (ok()) {
+      status_ = config::LoadCacheSimulation(&mdscliopts_.cache_simulation);
+    }
   }
 
   if (ok()) {
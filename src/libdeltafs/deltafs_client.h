@@ -57,6 +57,9 @@ class Client {
 
   mode_t Umask(mode_t mode);
 
+  // Log the statistics of client-side metadata caches.
+  void PrintCacheStats();
+
  private:
   class Builder;
   Client(size_t max_open_files);  // Called only by Client::Builder
@@ -55,9 +55,11 @@ DEFINE_FLAG(SizeOfSrvLeaseTable, "4k")
 DEFINE_FLAG(SizeOfSrvDirTable, "1k")
 DEFINE_FLAG(SizeOfCliLookupCache, "4k")
 DEFINE_FLAG(SizeOfCliIndexCache, "1k")
+DEFINE_FLAG(LookupPrefetch, "0")
 DEFINE_FLAG(SizeOfMetadataWriteBuffer, "32M")
 DEFINE_FLAG(SizeOfMetadataTables, "32M")
 DEFINE_FLAG(DisableMetadataCompaction, "true")
+DEFINE_FLAG(CacheSimulation, "false")
 DEFINE_FLAG(AtomicPathRes, "false")
 DEFINE_FLAG(ParanoidChecks, "false")
 DEFINE_FLAG(VerifyChecksums, "false")
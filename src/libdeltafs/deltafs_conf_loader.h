@@ -56,9 +56,11 @@ CONF_LOADER_UI64(SizeOfSrvLeaseTable)
 CONF_LOADER_UI64(SizeOfSrvDirTable)
 CONF_LOADER_UI64(SizeOfCliLookupCache)
 CONF_LOADER_UI64(SizeOfCliIndexCache)
+CONF_LOADER_UI64(LookupPrefetch)
 CONF_LOADER_UI64(SizeOfMetadataWriteBuffer)
 CONF_LOADER_UI64(SizeOfMetadataTables)
 CONF_LOADER_BOOL(DisableMetadataCompaction)
+CONF_LOADER_BOOL(CacheSimulation)
 CONF_LOADER_BOOL(AtomicPathRes)
 CONF_LOADER_BOOL(ParanoidChecks)
 CONF_LOADER_BOOL(VerifyChecksums)
@@ -47,6 +47,12 @@ extern std::string SizeOfCliLookupCache();
 // Return the size of directory index cache at each metadata client.
 // e.g. 4096, 16k
 extern std::string SizeOfCliIndexCache();
+// Set the max number of sibling leases piggybacked on each lookup reply.
+// e.g. 0, 16
+extern std::string LookupPrefetch();
+// Indicate if metadata caches should estimate hit ratios at larger sizes.
+// e.g. true, yes
+extern std::string CacheSimulation();
 // Indicate if deltafs should ensure atomic pathname resolutions.
 // e.g. true, yes
 extern std::string AtomicPathRes();
@@ -63,6 +69,8 @@ extern std::string SizeOfMetadataWriteBuffer();
 // e.g. 8M, 32M
 extern std::string SizeOfMetadataTables();
 // True if all background compaction of metadata tables should be disabled.
+// Range tombstones left by directory removals then stay until the next
+// manual compaction.
 // e.g. true, yes
 extern std::string DisableMetadataCompaction();
 // Return the name of the Env implementation to use.
@@ -359,16 +359,23 @@ void MetadataServer::Builder::OpenDB() {
 void MetadataServer::Builder::OpenMDS() {
   uint64_t lease_table_size;
   uint64_t dir_table_size;
+  uint64_t lookup_prefetch;
 
   if (ok()) {
     status_ = config::LoadSizeOfSrvLeaseTable(&lease_table_size);
     if (ok()) {
       status_ = config::LoadSizeOfSrvDirTable(&dir_table_size);
     }
+    if (ok()) {
+      status_ = config::LoadLookupPrefetch(&lookup_prefetch);
+    }
   }
 
   if (ok()) {
     status_ = config::LoadParanoidChecks(&mdsopts_.paranoid_checks);
+    if (ok()) {
+      status_ = config::LoadCacheSimulation(&mdsopts_.cache_simulation);
+    }
   }
 
   if (ok()) {
@@ -376,6 +383,7 @@ void MetadataServer::Builder::OpenMDS() {
     mdsopts_.mds_env = myenv_;
     mdsopts_.lease_table_size = lease_table_size;
     mdsopts_.dir_table_size = dir_table_size;
+    mdsopts_.lookup_prefetch = lookup_prefetch;
     mdsopts_.num_virtual_servers = mdstopo_.num_vir_srvs;
     mdsopts_.num_servers = mdstopo_.num_srvs;
     mdsopts_.snap_id = snap_id_;
@@ -38,6 +38,8 @@ MDSOptions::MDSOptions()
       snap_id(0),
       reg_id(0),
       paranoid_checks(false),
+      cache_simulation(false),
+      lookup_prefetch(0),
       num_virtual_servers(1),
       num_servers(1),
       srv_id(0) {}
@@ -47,6 +49,7 @@ MDS::SRV::SRV(const MDSOptions& options)
       mdb_(options.mdb),
       paranoid_checks_(options.paranoid_checks),
       lease_duration_(options.lease_duration),
+      lookup_prefetch_(options.lookup_prefetch),
       snap_id_(options.snap_id),
       reg_id_(options.reg_id),
       srv_id_(options.srv_id),
@@ -61,6 +64,9 @@ MDS::SRV::SRV(const MDSOptions& options)
   lease_options.max_lease_duration = options.lease_duration;
   lease_options.max_num_leases = options.lease_table_size;
   leases_ = new LeaseTable(lease_options);
+  if (options.cache_simulation) {
+    leases_->EnableSimulation();
+  }
 
   dirs_ = new DirTable(options.dir_table_size);
 
@@ -72,6 +78,12 @@ MDS::SRV::SRV(const MDSOptions& options)
 }
 
 MDS::SRV::~SRV() {
+#if VERBOSE >= 1
+  LRUCacheStats lease_stats;
+  GetLeaseStats(&lease_stats);
+  Verbose(__LOG_ARGS__, 1, "mds.lease_table:\n%s",
+          lease_stats.ToString().c_str());
+#endif
   delete leases_;
   delete dirs_;
 }
@@ -86,6 +98,8 @@ MDS* MDS::Open(const MDSOptions& options) {
   Verbose(__LOG_ARGS__, 1, "mds.dir_table_size -> %zu", options.dir_table_size);
   Verbose(__LOG_ARGS__, 1, "mds.lease_table_size -> %zu",
           options.lease_table_size);
+  Verbose(__LOG_ARGS__, 1, "mds.lookup_prefetch -> %zu",
+          options.lookup_prefetch);
   Verbose(__LOG_ARGS__, 1, "mds.reg_id -> %llu",
           (unsigned long long)options.reg_id);
   Verbose(__LOG_ARGS__, 1, "mds.snap_id -> %llu",
@@ -104,6 +118,7 @@ MDSCliOptions::MDSCliOptions()
       index_cache_size(4096),
       lookup_cache_size(4096),
       paranoid_checks(false),
+      cache_simulation(false),
       atomic_path_resolution(false),
       max_redirects_allowed(20),
       num_virtual_servers(1),
@@ -129,6 +144,10 @@ MDS::CLI::CLI(const MDSCliOptions& options)
 
   lookup_cache_ = new LookupCache(options.lookup_cache_size);
   index_cache_ = new IndexCache(options.index_cache_size);
+  if (options.cache_simulation) {
+    lookup_cache_->EnableSimulation();
+    index_cache_->EnableSimulation();
+  }
 }
 
 MDS::CLI::~CLI() {
@@ -410,8 +410,28 @@ Status MDS::RPC::CLI::Lookup(const LookupOptions& options, LookupRet* ret) {
         throw re;
       } else if (out.err != 0) {
         s = Status::FromCode(out.err);
-      } else if (!ret->stat.DecodeFrom(out.contents)) {
-        s = Status::Corruption(Slice());
+      } else {
+        Slice input = out.contents;
+        if (!ret->stat.DecodeFrom(&input)) {
+          s = Status::Corruption(Slice());
+        } else if (!input.empty()) {
+          // Sibling leases piggybacked by the server
+          uint32_t n;
+          Slice hash;
+          LookupStat stat;
+          if (!GetVarint32(&input, &n)) {
+            s = Status::Corruption(Slice());
+          }
+          for (uint32_t i = 0; s.ok() && i < n; i++) {
+            if (!GetLengthPrefixedSlice(&input, &hash) ||
+                !stat.DecodeFrom(&input)) {
+              s = Status::Corruption(Slice());
+            } else {
+              ret->sibling_hashes.push_back(hash.ToString());
+              ret->sibling_stats.push_back(stat);
+            }
+          }
+        }
       }
     }
   }
@@ -441,7 +461,18 @@ void MDS::RPC::SRV::LOKUP(Msg& in, Msg& out) {
     }
   }
   if (s.ok()) {
-    out.contents = ret.stat.EncodeTo(out.buf);
+    if (ret.sibling_hashes.empty()) {
+      out.contents = ret.stat.EncodeTo(out.buf);
+    } else {
+      char tmp[sizeof(LookupStat)];
+      out.extra_buf.append(ret.stat.EncodeTo(tmp).ToString());
+      PutVarint32(&out.extra_buf, ret.sibling_hashes.size());
+      for (size_t i = 0; i < ret.sibling_hashes.size(); i++) {
+        PutLengthPrefixedSlice(&out.extra_buf, ret.sibling_hashes[i]);
+        out.extra_buf.append(ret.sibling_stats[i].EncodeTo(tmp).ToString());
+      }
+      out.contents = Slice(out.extra_buf);
+    }
     out.err = 0;
   } else {
     out.err = s.err_code();
@@ -58,6 +58,9 @@ struct MDSOptions {
   uint64_t snap_id;
   uint64_t reg_id;
   bool paranoid_checks;
+  bool cache_simulation;  // Estimate lease table hit ratios at larger sizes
+  // Max number of sibling directory leases piggybacked on a lookup reply
+  size_t lookup_prefetch;
   int num_virtual_servers;
   int num_servers;
   int srv_id;
@@ -152,7 +155,13 @@ class MDS {
   MDS_OP(Unlink)
 
   MDS_OP_OPTIONS(Lookup){};
-  MDS_OP_RET(Lookup) { LookupStat stat; };
+  MDS_OP_RET(Lookup) {
+    LookupStat stat;
+    // Leased sibling directories following the target in the same directory
+    // partition. Returned only if the server is configured to prefetch.
+    std::vector<std::string> sibling_hashes;
+    std::vector<LookupStat> sibling_stats;
+  };
   MDS_OP(Lookup)
 
   MDS_OP_OPTIONS(Listdir){};
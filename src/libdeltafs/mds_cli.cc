@@ -90,6 +90,15 @@ Status MDS::CLI::Lookup(const DirId& pid, const Slice& name, int zserver,
         if (stat->LeaseDue() == 0) {
           lookup_cache_->Erase(pid, nhash);
         }
+        // Cache sibling leases piggybacked by the server so that
+        // subsequent lookups under the same parent avoid a round trip
+        for (size_t i = 0; i < ret.sibling_hashes.size(); i++) {
+          const LookupStat& sibling = ret.sibling_stats[i];
+          if (sibling.LeaseDue() != 0) {
+            lookup_cache_->Release(lookup_cache_->Insert(
+                pid, ret.sibling_hashes[i], new LookupStat(sibling)));
+          }
+        }
       }
     }
   }
@@ -1245,4 +1254,11 @@ Status MDS::CLI::Access(const Slice& p, int mode) {
   return s;
 }
 
+void MDS::CLI::GetCacheStats(LRUCacheStats* lookup_stats,
+                             LRUCacheStats* index_stats) {
+  MutexLock ml(&mutex_);
+  lookup_cache_->GetStats(lookup_stats);
+  index_cache_->GetStats(index_stats);
+}
+
 }  // namespace pdlfs
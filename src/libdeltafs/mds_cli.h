@@ -33,6 +33,7 @@ struct MDSCliOptions {
   size_t index_cache_size;
   size_t lookup_cache_size;
   bool paranoid_checks;
+  bool cache_simulation;  // Estimate cache hit ratios at larger sizes
   bool atomic_path_resolution;
   int max_redirects_allowed;
   int num_virtual_servers;
@@ -64,6 +65,9 @@ class MDS::CLI {
   Status Accessdir(const Slice& path, int mode);
   Status Access(const Slice& path, int mode);
 
+  // Store a snapshot of the statistics of the client-side caches.
+  void GetCacheStats(LRUCacheStats* lookup_stats, LRUCacheStats* index_stats);
+
   uid_t uid() const { return uid_; }
   gid_t gid() const { return gid_; }
 
@@ -858,6 +858,59 @@ Status MDS::SRV::Trunc(const TruncOptions& options, TruncRet* ret) {
   return s;
 }
 
+// Install or extend the lookup state lease of a sub-directory.
+// Return the new lease due, or 0 if no lease can be granted.
+// No lease is granted if the lease table is full or if the data read by the
+// caller (which started at the given dir seq) is possibly stale.
+// REQUIRES: mutex_ has been locked.
+uint64_t MDS::SRV::GrantLease(const DirId& dir_id, const Slice& name_hash,
+                              const Dir* d, uint64_t my_seq, uint64_t my_end) {
+  mutex_.AssertHeld();
+  Lease::Ref* lref = leases_->Lookup(dir_id, name_hash);
+  if (lref == NULL) {
+    Lease* new_lease = new Lease;
+    new_lease->state = kLeaseFree;
+    new_lease->parent = d;
+    new_lease->due = 0;
+    new_lease->seq = 0;
+    try {
+      lref = leases_->Insert(dir_id, name_hash, new_lease);
+    } catch (int err) {
+      // Not expecting errors other than ENOBUFS
+      assert(err == ENOBUFS);
+      // If the lease table is full, will return with no lease
+      // and the client does not have to know this error
+      lref = NULL;
+    }
+    if (lref != NULL) {
+      d->num_leases++;
+    } else {
+      delete new_lease;
+    }
+  }
+  uint64_t result = 0;
+  // No lease will be issued if the lease table is full, otherwise...
+  if (lref != NULL) {
+    Lease::Guard lguard(leases_, lref);
+    Lease* const lease = lref->value;
+    assert(lease != NULL);
+    // No lease if the data is possibly stale, otherwise...
+    if (lease->seq <= my_seq) {
+      if (lease->state != kLeaseLocked) {
+        lease->state = kLeaseShared;
+        assert(my_end + lease_duration_ >= lease->due);
+        // TODO: implement dynamic lease duration
+        lease->due = my_end + lease_duration_;
+      } else {
+        // A concurrent write operation is in-progress and not
+        // able to extend the lease nor change its state
+      }
+      result = lease->due;
+    }
+  }
+  return result;
+}
+
 // Lookup a directory for pathname resolution. Return OK on success.
 // Multiple read threads should be able to run concurrently without blocking
 // each other or being blocked by any concurrent write operations.
@@ -913,6 +966,11 @@ Status MDS::SRV::Trunc(const TruncOptions& options, TruncRet* ret) {
 //   lease. Also, if the lease table is full at the moment, the
 //   lookup operation also returns with no lease.
 //
+//   If lookup prefetching is enabled, leases are also issued against
+//   the sub-directories that immediately follow the target in the same
+//   directory partition. These leases obey the same rules as above
+//   and are returned together with the lookup result.
+//
 // Errors may occur when the entry in question does not exist or is not a
 // directory, when the current server is not the right one for the entry,
 // when the data being read from DB is corrupted, and when other internal
@@ -978,49 +1036,40 @@ Status MDS::SRV::Lookup(const LookupOptions& options, LookupRet* ret) {
           ret->stat.CopyFrom(stat);
         }
 
+        // Read the next few entries of the same directory so their
+        // leases can be piggybacked on the reply
+        MDB::StatList sibling_stats;
+        MDB::HashList sibling_hashes;
+        if (s.ok() && lookup_prefetch_ != 0) {
+          mdb_->ListNext(dir_id, name_hash, &sibling_stats, &sibling_hashes,
+                         mdb_tx, lookup_prefetch_);
+        }
+
         mutex_.Lock();
         uint64_t my_end = NowMicros();
         // No lease either we timeout or have a negative result, otherwise...
         if (s.ok() && (my_end - my_start) < (lease_duration_ - 10)) {
-          Lease::Ref* lref = leases_->Lookup(dir_id, name_hash);
-          if (lref == NULL) {
-            Lease* new_lease = new Lease;
-            new_lease->state = kLeaseFree;
-            new_lease->parent = d;
-            new_lease->due = 0;
-            new_lease->seq = 0;
-            try {
-              lref = leases_->Insert(dir_id, name_hash, new_lease);
-            } catch (int err) {
-              // Not expecting errors other than ENOBUFS
-              assert(err == ENOBUFS);
-              // If the lease table is full, will return with no lease
-              // and the client does not have to know this error
-              lref = NULL;
-            }
-            if (lref != NULL) {
-              d->num_leases++;
-            } else {
-              delete new_lease;
-            }
-          }
-          // No lease will be issued if the lease table is full, otherwise...
-          if (lref != NULL) {
-            Lease::Guard lguard(leases_, lref);
-            Lease* const lease = lref->value;
-            assert(lease != NULL);
-            // No lease if the data is possibly stale, otherwise...
-            if (lease->seq <= my_seq) {
-              if (lease->state != kLeaseLocked) {
-                lease->state = kLeaseShared;
-                assert(my_end + lease_duration_ >= lease->due);
-                // TODO: implement dynamic lease duration
-                lease->due = my_end + lease_duration_;
-              } else {
-                // A concurrent write operation is in-progress and not
-                // able to extend the lease nor change its state
+          uint64_t due = GrantLease(dir_id, name_hash, d, my_seq, my_end);
+          ret->stat.SetLeaseDue(due);
+          if (due != 0 && !sibling_hashes.empty()) {
+            const int my_index = d->index.HashToIndex(name_hash);
+            for (size_t i = 0; i < sibling_hashes.size(); i++) {
+              const Slice sibling_hash = sibling_hashes[i];
+              const Stat& sibling_stat = sibling_stats[i];
+              // Skip entries that belong to other partitions or are not
+              // directories
+              if (!S_ISDIR(sibling_stat.FileMode()) ||
+                  d->index.HashToIndex(sibling_hash) != my_index) {
+                continue;
+              }
+              due = GrantLease(dir_id, sibling_hash, d, my_seq, my_end);
+              if (due != 0) {
+                LookupStat lstat;
+                lstat.CopyFrom(sibling_stat);
+                lstat.SetLeaseDue(due);
+                ret->sibling_hashes.push_back(sibling_hashes[i]);
+                ret->sibling_stats.push_back(lstat);
               }
-              ret->stat.SetLeaseDue(lease->due);
             }
           }
         }
@@ -1282,4 +1331,9 @@ Status MDS::SRV::Getoutput(const GetoutputOptions&, GetoutputRet* ret) {
   return Status::OK();
 }
 
+void MDS::SRV::GetLeaseStats(LRUCacheStats* stats) {
+  MutexLock ml(&mutex_);
+  leases_->GetStats(stats);
+}
+
 }  // namespace pdlfs
@@ -43,10 +43,15 @@ class MDS::SRV : public MDS {
 
 #undef DEC_OP
 
+  // Store a snapshot of the statistics of the lease table.
+  void GetLeaseStats(LRUCacheStats* stats);
+
  private:
   Status LoadDir(const DirId& id, DirInfo* info, DirIndex* index);
   Status FetchDir(const DirId& id, Dir::Ref** ref);
   Status ProbeDir(const Dir* dir);
+  uint64_t GrantLease(const DirId& id, const Slice& nhash, const Dir* dir,
+                      uint64_t seq, uint64_t now);
 
   // Constant after construction
   MDSEnv* mds_env_;
@@ -59,6 +64,7 @@ class MDS::SRV : public MDS {
   GIGA giga_;
   bool paranoid_checks_;
   uint64_t lease_duration_;
+  size_t lookup_prefetch_;
   uint64_t snap_id_;
   uint64_t reg_id_;
   int srv_id_;
@@ -27,6 +27,8 @@ class ServerTest {
   DB* db_;
 
  public:
+  MDSOptions mdsopts_;
+
   ServerTest() {
     Env* env = Env::Default();
     dbname_ = test::PrepareTmpDir("mds_srv_test", env);
@@ -39,10 +41,16 @@ class ServerTest {
     mdbopts.db = db_;
     mdb_ = new MDB(mdbopts);
     mds_env_.env = env;
-    MDSOptions mdsopts;
-    mdsopts.mds_env = &mds_env_;
-    mdsopts.mdb = mdb_;
-    mds_ = MDS::Open(mdsopts);
+    mdsopts_.mds_env = &mds_env_;
+    mdsopts_.mdb = mdb_;
+    mds_ = MDS::Open(mdsopts_);
+  }
+
+  // Restart the server with the current options. Metadata already
+  // written to the underlying db is kept.
+  void Reopen() {
+    delete mds_;
+    mds_ = MDS::Open(mdsopts_);
   }
 
   ~ServerTest() {
@@ -118,6 +126,30 @@ class ServerTest {
     }
   }
 
+  // Return the number of sibling leases piggybacked on the reply,
+  // or "-err_code" on errors.
+  int Lookup(int dir_ino, int nod_no) {
+    MDS::LookupOptions options;
+    options.dir_id = DirId(0, 0, dir_ino);
+    std::string name = NodeName(nod_no);
+    options.name = name;
+    std::string name_hash;
+    DirIndex::PutHash(&name_hash, name);
+    options.name_hash = name_hash;
+    MDS::LookupRet ret;
+    Status s = mds_->Lookup(options, &ret);
+    if (s.ok()) {
+      if (ret.stat.LeaseDue() == 0) return -1;
+      for (size_t i = 0; i < ret.sibling_stats.size(); i++) {
+        if (ret.sibling_stats[i].LeaseDue() == 0) return -1;
+        if (ret.sibling_hashes[i] == name_hash) return -1;
+      }
+      return static_cast<int>(ret.sibling_hashes.size());
+    } else {
+      return -1 * s.err_code();
+    }
+  }
+
   int Listdir(int dir_ino) {
     MDS::ListdirOptions options;
     options.dir_id = DirId(0, 0, dir_ino);
@@ -173,6 +205,28 @@ TEST(ServerTest, Scan) {
   ASSERT_TRUE(r == 9);
 }
 
+TEST(ServerTest, LookupPrefetch) {
+  mdsopts_.lookup_prefetch = 8;
+  Reopen();
+  int r1 = Lookup(0, 1);
+  ASSERT_TRUE(r1 == -1 * Status::kNotFound);
+  Mknod(0, 1);
+  Mknod(0, 2);
+  Mknod(0, 3);
+  Mkdir(0, 4);
+  Mkdir(0, 5);
+  Mkdir(0, 6);
+  int total = 0;
+  for (int i = 4; i <= 6; i++) {
+    int r = Lookup(0, i);
+    ASSERT_TRUE(r >= 0);
+    total += r;
+  }
+  // Each lookup carries the sub-directories that follow it in hash
+  // order (2 + 1 + 0); regular files are never piggybacked
+  ASSERT_EQ(total, 3);
+}
+
 }  // namespace pdlfs
 
 int main(int argc, char* argv[]) {
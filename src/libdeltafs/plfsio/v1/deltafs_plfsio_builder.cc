@@ -10,6 +10,8 @@
 #include "deltafs_plfsio_builder.h"
 #include "deltafs_plfsio_recov.h"
 
+#include "pdlfs-common/mutexlock.h"
+
 #include <math.h>
 
 namespace pdlfs {
@@ -214,6 +216,275 @@ Iterator* ArrayBlock::NewIterator(const Comparator* comparator) {
   }
 }
 
+void VarArrayBlockBuilder::Add(const Slice& key, const Slice& value) {
+  assert(!finished_);
+  offsets_.push_back(static_cast<uint32_t>(buffer_.size() - buffer_start_));
+  PutVarint32(&buffer_, static_cast<uint32_t>(key.size()));
+  buffer_.append(key.data(), key.size());
+  buffer_.append(value.data(), value.size());
+}
+
+Slice VarArrayBlockBuilder::Finish(CompressionType compression,
+                                   bool force_compression) {
+  assert(!finished_);
+  // Append the offset table
+  for (size_t i = 0; i < offsets_.size(); i++) {
+    PutFixed32(&buffer_, offsets_[i]);
+  }
+  PutFixed32(&buffer_, static_cast<uint32_t>(offsets_.size()));
+  return AbstractBlockBuilder::Finish(compression, force_compression);
+}
+
+size_t VarArrayBlockBuilder::CurrentSizeEstimate() const {
+  size_t result = buffer_.size() - buffer_start_;
+  if (!finished_) {
+    // Plus the offset table and its length
+    return result + offsets_.size() * sizeof(uint32_t) + sizeof(uint32_t);
+  } else {
+    return result;
+  }
+}
+
+void VarArrayBlockBuilder::Reset() {
+  AbstractBlockBuilder::Reset();
+  offsets_.clear();
+}
+
+VarArrayBlock::VarArrayBlock(const BlockContents& contents)
+    : data_(contents.data.data()),
+      size_(contents.data.size()),
+      owned_(contents.heap_allocated),
+      num_entries_(0),
+      offsets_(0) {
+  if (size_ < sizeof(uint32_t)) {
+    size_ = 0;  // Error marker
+  } else {
+    num_entries_ = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+    const size_t max_entries = (size_ - sizeof(uint32_t)) / sizeof(uint32_t);
+    if (num_entries_ > max_entries) {
+      size_ = 0;  // Error marker
+    } else {
+      offsets_ = static_cast<uint32_t>(size_ - sizeof(uint32_t) -
+                                       num_entries_ * sizeof(uint32_t));
+    }
+  }
+}
+
+VarArrayBlock::~VarArrayBlock() {
+  if (owned_) {
+    delete[] data_;
+  }
+}
+
+class VarArrayBlock::Iter : public Iterator {
+ private:
+  const Comparator* const comparator_;
+  const char* const data_;        // Underlying block contents
+  const uint32_t offsets_;        // Offset of the offset table
+  const uint32_t num_entries_;
+  // Index of the current entry.  >= num_entries_ if !Valid
+  uint32_t current_;
+  Slice key_;
+  Slice value_;
+
+  Status status_;
+
+  inline int Compare(const Slice& a, const Slice& b) const {
+    assert(comparator_ == BytewiseComparator());
+    return a.compare(b);
+  }
+
+  inline uint32_t EntryOffset(uint32_t index) const {
+    return DecodeFixed32(data_ + offsets_ + index * sizeof(uint32_t));
+  }
+
+  // Decode the key of a given entry into *key and return the limit
+  // of its value. Return false on errors.
+  bool DecodeEntry(uint32_t index, Slice* key, uint32_t* value_limit) const {
+    const uint32_t offset = EntryOffset(index);
+    const uint32_t limit =
+        index + 1 < num_entries_ ? EntryOffset(index + 1) : offsets_;
+    if (offset >= limit || limit > offsets_) {
+      return false;
+    }
+    uint32_t key_size;
+    const char* p = GetVarint32Ptr(data_ + offset, data_ + limit, &key_size);
+    if (p == NULL || key_size > static_cast<uint32_t>(data_ + limit - p)) {
+      return false;
+    }
+    *key = Slice(p, key_size);
+    *value_limit = limit;
+    return true;
+  }
+
+  void SeekTo(uint32_t index) {
+    current_ = index;
+    if (current_ < num_entries_) {
+      uint32_t value_limit;
+      if (!DecodeEntry(current_, &key_, &value_limit)) {
+        CorruptionError();
+      } else {
+        const char* value_start = key_.data() + key_.size();
+        value_ = Slice(value_start, data_ + value_limit - value_start);
+      }
+    }
+  }
+
+  void CorruptionError() {
+    current_ = num_entries_;
+    status_ = Status::Corruption("Bad entry in block");
+    key_.clear();
+    value_.clear();
+  }
+
+ public:
+  Iter(const Comparator* comparator, const char* data, uint32_t offsets,
+       uint32_t num_entries)
+      : comparator_(comparator),
+        data_(data),
+        offsets_(offsets),
+        num_entries_(num_entries),
+        current_(num_entries) {}
+
+  virtual ~Iter() {}
+  virtual bool Valid() const { return current_ < num_entries_; }
+  virtual Status status() const { return status_; }
+  virtual Slice key() const {
+    assert(Valid());
+    return key_;
+  }
+
+  virtual Slice value() const {
+    assert(Valid());
+    return value_;
+  }
+
+  virtual void Next() {
+    assert(Valid());
+    SeekTo(current_ + 1);
+  }
+
+  virtual void Prev() {
+    assert(Valid());
+    if (current_ != 0) {
+      SeekTo(current_ - 1);
+    } else {
+      // No more entries
+      current_ = num_entries_;
+    }
+  }
+
+  virtual void SeekToFirst() { SeekTo(0); }
+
+  virtual void SeekToLast() {
+    SeekTo(num_entries_ != 0 ? num_entries_ - 1 : 0);
+  }
+
+  // If comparator_ is not NULL, keys are considered ordered and we use binary
+  // search over the offset table to find the target. Otherwise, linear search
+  // is used.
+  virtual void Seek(const Slice& target) {
+    if (comparator_ != NULL) {
+      uint32_t left = 0;
+      uint32_t right = num_entries_;
+      while (left < right) {
+        uint32_t mid = left + (right - left) / 2;
+        Slice mid_key;
+        uint32_t value_limit;
+        if (!DecodeEntry(mid, &mid_key, &value_limit)) {
+          CorruptionError();
+          return;
+        }
+        if (Compare(mid_key, target) < 0) {
+          // Key at mid is smaller than target.
+          left = mid + 1;
+        } else {
+          // Key at mid is >= target.
+          right = mid;
+        }
+      }
+      SeekTo(left);
+    } else {
+      SeekToFirst();
+      for (; Valid(); Next()) {
+        if (key() == target) {
+          return;
+        }
+      }
+    }
+  }
+};
+
+// Return an iterator to the block contents. The result should be deleted when
+// no longer needed.
+Iterator* VarArrayBlock::NewIterator(const Comparator* comparator) {
+  if (size_ < sizeof(uint32_t)) {
+    return NewErrorIterator(
+        Status::Corruption("Cannot understand block contents"));
+  } else if (num_entries_ != 0) {
+    return new Iter(comparator, data_, offsets_, num_entries_);
+  } else {
+    return NewEmptyIterator();
+  }
+}
+
+// A data block being compressed in the background.
+struct DataBlockJob {
+  const DirOptions* options;
+  // Raw block contents on input. Final block contents, including the block
+  // trailer and any inserted padding, on output.
+  std::string contents;
+  size_t block_size;  // Size of the block contents w/o trailer and padding
+  port::Mutex* mu;
+  port::CondVar* cv;
+  bool done;
+};
+
+// Compress a data block and finalize it with a block trailer and padding.
+// This mirrors what AbstractBlockBuilder::Finish() and Finalize() do for
+// blocks that are compressed inline.
+static void CompressDataBlock(void* arg) {
+  DataBlockJob* const job = reinterpret_cast<DataBlockJob*>(arg);
+  const DirOptions& options = *job->options;
+  std::string* const contents = &job->contents;
+  CompressionType type = kNoCompression;
+  if (options.compression == kSnappyCompression) {
+    const size_t sz = contents->size();
+    std::string compressed;
+    if (port::Snappy_Compress(contents->data(), sz, &compressed) &&
+        (compressed.size() < (sz - sz / 8u) || options.force_compression)) {
+      contents->swap(compressed);
+      type = kSnappyCompression;
+    }
+  }
+
+  const size_t block_size = contents->size();
+  char trailer[kBlockTrailerSize];
+  trailer[0] = type;
+  if (!options.skip_checksums) {
+    uint32_t crc = crc32c::Value(contents->data(), block_size);
+    crc = crc32c::Extend(crc, trailer, 1);  // Extend crc to cover block type
+    EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+  } else {
+    EncodeFixed32(trailer + 1, 0);
+  }
+  contents->append(trailer, sizeof(trailer));
+  if (options.block_padding) {
+    // Target size for the final block contents after padding
+    size_t padding_target =
+        options.block_size - BlockHandle::kMaxEncodedLength;
+    while (padding_target < contents->size())
+      padding_target += options.block_size;
+    contents->resize(padding_target, static_cast<char>(0xff));
+  }
+
+  job->mu->Lock();
+  job->block_size = block_size;
+  job->done = true;
+  job->cv->SignalAll();
+  job->mu->Unlock();
+}
+
 template <typename T>
 SeqDirBuilder<T>::SeqDirBuilder(const DirOptions& options,
                                 DirOutputStats* stats, LogSink* data,
@@ -228,12 +499,17 @@ SeqDirBuilder<T>::SeqDirBuilder(const DirOptions& options,
       epok_block_(1),
       root_block_(1),
       pending_indx_entry_(false),
+      attr_index_(options.attr_extractor != NULL),
       pending_meta_entry_(false),
       pending_root_entry_(false),
       pending_data_flush_(0),
       pending_indx_flush_(0),
       data_sink_(data),
       data_offset_(0),
+      uncommitted_job_bytes_(0),
+      async_compression_(options.compression_pool != NULL &&
+                         options.compression != kNoCompression),
+      job_cv_(&job_mu_),
       indx_writter_(new LogWriter(options, indx)),
       indx_sink_(indx),
       finished_(false) {
@@ -262,6 +538,10 @@ SeqDirBuilder<T>::SeqDirBuilder(const DirOptions& options,
 
 template <typename T>
 SeqDirBuilder<T>::~SeqDirBuilder() {
+  WaitForCompressedBlocks();
+  for (size_t i = 0; i < uncommitted_jobs_.size(); i++) {
+    delete uncommitted_jobs_[i];
+  }
   indx_sink_->Unref();
   data_sink_->Unref();
   delete indx_writter_;
@@ -344,6 +624,7 @@ void SeqDirBuilder<T>::EndTable(const Slice& filter_contents,
     BytewiseComparator()->FindShortSuccessor(&last_key_);
     PutLengthPrefixedSlice(&uncommitted_indexes_, last_key_);
     last_data_info_.EncodeTo(&uncommitted_indexes_);
+    if (attr_index_) last_data_attrs_.EncodeTo(&uncommitted_indexes_);
     pending_indx_entry_ = false;
     num_uncommitted_indx_++;
   }
@@ -397,6 +678,7 @@ void SeqDirBuilder<T>::EndTable(const Slice& filter_contents,
   last_tabl_info_.set_smallest_key(smallest_key_);
   BytewiseComparator()->FindShortSuccessor(&largest_key_);
   last_tabl_info_.set_largest_key(largest_key_);
+  if (attr_index_) last_tabl_info_.set_attr_range(table_attrs_);
   std::string handle_encoding;
   last_tabl_info_.EncodeTo(&handle_encoding);
   epok_block_.Add(EpochTableKey(num_eps_, num_tabls_), handle_encoding);
@@ -407,16 +689,19 @@ void SeqDirBuilder<T>::EndTable(const Slice& filter_contents,
   smallest_key_.clear();
   largest_key_.clear();
   last_key_.clear();
+  table_attrs_.Clear();
 }
 
 template <typename T>
 void SeqDirBuilder<T>::Commit() {
   assert(!finished_);  // Finish() has not been called
   // Skip empty commit
-  if (data_block_->buffer_store()->empty()) return;
+  if (data_block_->buffer_store()->empty() && uncommitted_jobs_.empty())
+    return;
   if (!ok()) return;  // Abort
 
   assert(num_uncommitted_data_ == num_uncommitted_indx_);
+  if (!uncommitted_jobs_.empty()) LayoutCompressedBlocks();
   std::string* const buffer = data_block_->buffer_store();
 
   Slice key;
@@ -432,9 +717,11 @@ void SeqDirBuilder<T>::Commit() {
   Slice input = uncommitted_indexes_;
   std::string handle_encoding;
   BlockHandle handle;
+  AttrRange attrs;
   while (!input.empty()) {
     if (GetLengthPrefixedSlice(&input, &key)) {
       handle.DecodeFrom(&input);
+      if (attr_index_) attrs.DecodeFrom(&input);
       const uint64_t offset = handle.offset();
       handle.set_offset(base + offset);  // Finalize the block offset
       handle_encoding.clear();
@@ -452,6 +739,8 @@ void SeqDirBuilder<T>::Commit() {
                    options_.block_size ==
                0);  // Verify block alignment
       }
+      // Block attribute ranges follow the block handle
+      if (attr_index_) attrs.EncodeTo(&handle_encoding);
       indx_block_.Add(key, handle_encoding);
       num_index_committed++;
     } else {
@@ -472,6 +761,61 @@ void SeqDirBuilder<T>::Commit() {
   pending_restart_ = true;
 }
 
+template <typename T>
+void SeqDirBuilder<T>::WaitForCompressedBlocks() {
+  MutexLock ml(&job_mu_);
+  for (size_t i = 0; i < uncommitted_jobs_.size(); i++) {
+    while (!uncommitted_jobs_[i]->done) {
+      job_cv_.Wait();
+    }
+  }
+}
+
+template <typename T>
+void SeqDirBuilder<T>::LayoutCompressedBlocks() {
+  WaitForCompressedBlocks();
+  std::string* const buffer = data_block_->buffer_store();
+  std::vector<BlockHandle> handles;
+  handles.resize(uncommitted_jobs_.size());
+  for (size_t i = 0; i < uncommitted_jobs_.size(); i++) {
+    DataBlockJob* const job = uncommitted_jobs_[i];
+    // Pre-reserve enough space for the leading block handle
+    buffer->append(BlockHandle::kMaxEncodedLength, 0);
+    handles[i].set_offset(buffer->size());
+    handles[i].set_size(job->block_size);
+    buffer->append(job->contents);
+    compac_stats_->final_data_size += job->contents.size();
+    compac_stats_->data_size += job->block_size;
+    delete job;
+  }
+
+  uncommitted_jobs_.clear();
+  uncommitted_job_bytes_ = 0;
+  // Redirect index entries to the final location of their blocks
+  std::string indexes;
+  indexes.reserve(uncommitted_indexes_.size());
+  Slice input = uncommitted_indexes_;
+  Slice key;
+  BlockHandle handle;
+  AttrRange attrs;
+  while (!input.empty()) {
+    if (GetLengthPrefixedSlice(&input, &key)) {
+      handle.DecodeFrom(&input);
+      assert(handle.offset() < handles.size());
+      PutLengthPrefixedSlice(&indexes, key);
+      handles[handle.offset()].EncodeTo(&indexes);
+      if (attr_index_) {
+        attrs.DecodeFrom(&input);
+        attrs.EncodeTo(&indexes);
+      }
+    } else {
+      break;
+    }
+  }
+
+  uncommitted_indexes_.swap(indexes);
+}
+
 template <typename T>
 void SeqDirBuilder<T>::EndBlock() {
   assert(!finished_);                // Finish() has not been called
@@ -479,6 +823,37 @@ void SeqDirBuilder<T>::EndBlock() {
   if (data_block_->empty()) return;  // Empty block
   if (!ok()) return;                 // Abort
 
+  if (async_compression_) {
+    // Hand the raw block contents to the compression pool. The final block
+    // is placed into the data block buffer at the next commit.
+    Slice block_contents = data_block_->Finish();
+    std::string* const buffer = data_block_->buffer_store();
+    DataBlockJob* const job = new DataBlockJob;
+    job->options = &options_;
+    job->contents = block_contents.ToString();
+    job->block_size = 0;
+    job->mu = &job_mu_;
+    job->cv = &job_cv_;
+    job->done = false;
+    // Remove the block and its leading block handle from the buffer
+    buffer->resize(block_contents.data() - buffer->data() -
+                   BlockHandle::kMaxEncodedLength);
+    compac_stats_->total_num_blocks_++;
+    pending_restart_ = true;
+    last_data_info_.set_size(0);  // To be determined after compression
+    last_data_info_.set_offset(uncommitted_jobs_.size());
+    last_data_attrs_ = block_attrs_;
+    block_attrs_.Clear();
+    assert(!pending_indx_entry_);
+    pending_indx_entry_ = true;
+    num_uncommitted_data_++;
+    uncommitted_job_bytes_ += BlockHandle::kMaxEncodedLength +
+                              block_contents.size() + kBlockTrailerSize;
+    uncommitted_jobs_.push_back(job);
+    options_.compression_pool->Schedule(CompressDataBlock, job);
+    return;
+  }
+
   // | <------------ options_.block_size (e.g. 32KB) ------------> |
   //   block handle   block contents  block trailer  block padding
   //                | <---------- final block contents ----------> |
@@ -511,6 +886,8 @@ void SeqDirBuilder<T>::EndBlock() {
     pending_restart_ = true;
     last_data_info_.set_size(block_size);
     last_data_info_.set_offset(block_offset);
+    last_data_attrs_ = block_attrs_;
+    block_attrs_.Clear();
     assert(!pending_indx_entry_);
     pending_indx_entry_ = true;
     num_uncommitted_data_++;
@@ -553,6 +930,7 @@ void SeqDirBuilder<T>::Add(const Slice& key, const Slice& value) {
     BytewiseComparator()->FindShortestSeparator(&last_key_, key);
     PutLengthPrefixedSlice(&uncommitted_indexes_, last_key_);
     last_data_info_.EncodeTo(&uncommitted_indexes_);
+    if (attr_index_) last_data_attrs_.EncodeTo(&uncommitted_indexes_);
     pending_indx_entry_ = false;
     num_uncommitted_indx_++;
   }
@@ -586,6 +964,13 @@ void SeqDirBuilder<T>::Add(const Slice& key, const Slice& value) {
 #endif
 
   data_block_->Add(key, value);
+  if (attr_index_) {
+    uint64_t attr;
+    if (ExtractAttr(options_, key, value, &attr)) {
+      block_attrs_.Add(attr);
+      table_attrs_.Add(attr);
+    }
+  }
   compac_stats_->total_num_keys_++;
   num_entries_++;  // Num key-value entries within an epoch
   if (IsKeyUnOrdered(options_.mode)) {
@@ -596,7 +981,8 @@ void SeqDirBuilder<T>::Add(const Slice& key, const Slice& value) {
       block_threshold_) {
     EndBlock();
     // Schedule buffer commit if it is about to full
-    if (data_block_->buffer_store()->size() + options_.block_size >
+    if (data_block_->buffer_store()->size() + uncommitted_job_bytes_ +
+            options_.block_size >
         options_.block_batch_size) {
       pending_commit_ = true;
     }
@@ -644,6 +1030,7 @@ void SeqDirBuilder<T>::Finish(uint32_t ep_seq) {
 template <typename T>
 size_t SeqDirBuilder<T>::memory_usage() const {
   size_t result = data_block_->memory_usage();
+  result += uncommitted_job_bytes_;
   result += root_block_.memory_usage();
   result += epok_block_.memory_usage();
   result += indx_block_.memory_usage();
@@ -658,6 +1045,9 @@ DirBuilder* DirBuilder::Open(const DirOptions& options, DirOutputStats* stats,
   if (!options.leveldb_compatible) {
     if (options.fixed_kv_length) {
       return new SeqDirBuilder<ArrayBlockBuilder>(options, stats, data, indx);
+    } else if (options.var_array_blocks) {
+      return new SeqDirBuilder<VarArrayBlockBuilder>(options, stats, data,
+                                                     indx);
     }
   }
 
@@ -677,6 +1067,18 @@ Iterator* OpenArrayBlock(const Comparator* cmp, const BlockContents& contents) {
   return iter;
 }
 
+void CleanupVarArrayBlock(void* arg1, void* arg2) {
+  delete reinterpret_cast<VarArrayBlock*>(arg1);
+}
+
+Iterator* OpenVarArrayBlock(const Comparator* cmp,
+                            const BlockContents& contents) {
+  VarArrayBlock* array_block = new VarArrayBlock(contents);
+  Iterator* iter = array_block->NewIterator(cmp);
+  iter->RegisterCleanup(CleanupVarArrayBlock, array_block, NULL);
+  return iter;
+}
+
 void CleanupBlock(void* arg1, void* arg2) {
   delete reinterpret_cast<Block*>(arg1);
 }
@@ -698,8 +1100,8 @@ Iterator* OpenDirBlock  // Use options to determine the block format to use
   }
   if (!options.leveldb_compatible) {
     if (options.fixed_kv_length) return OpenArrayBlock(comparator, contents);
-    // XXX: should we provide our own block format
-    // to support variable kv?
+    if (options.var_array_blocks)
+      return OpenVarArrayBlock(comparator, contents);
   }
 
   return OpenBlock(comparator, contents);
@@ -14,6 +14,7 @@
 #include "deltafs_plfsio_types.h"
 
 #include <set>
+#include <vector>
 
 namespace pdlfs {
 namespace plfsio {
@@ -97,6 +98,16 @@ class ArrayBlock {
 
   Iterator* NewIterator(const Comparator* comparator);
 
+  // Direct access to the fixed-sized entries of the block. The i-th entry
+  // starts at data() + i * (key_size() + value_size()) and holds the key
+  // followed by the value.
+  const char* data() const { return data_; }
+  uint32_t key_size() const { return key_size_; }
+  uint32_t value_size() const { return value_size_; }
+  size_t NumEntries() const {
+    return limit_ != 0 ? limit_ / (key_size_ + value_size_) : 0;
+  }
+
  private:
   const char* data_;
   size_t size_;
@@ -108,6 +119,58 @@ class ArrayBlock {
   class Iter;
 };
 
+// A block builder that stores variable-length key-value pairs in write order.
+// In this format, keys are not prefix-compressed. Each entry is stored as a
+// varint32 key length followed by the key and the value. The block ends with
+// the offset of each entry and the number of entries, so each block can be
+// seen as an array that can be binary searched without decoding any
+// neighboring entries.
+class VarArrayBlockBuilder : public AbstractBlockBuilder {
+ public:
+  explicit VarArrayBlockBuilder(const DirOptions& options)
+      : AbstractBlockBuilder(BytewiseComparator()) {
+    if (IsKeyUnOrdered(options.mode)) {
+      cmp_ = NULL;
+    }
+  }
+
+  // REQUIRES: Finish() has not been called since the previous Reset().
+  void Add(const Slice& key, const Slice& value);
+
+  // Finish building the block and return a slice that refers to the block
+  // contents.
+  Slice Finish(CompressionType compression = kNoCompression,
+               bool force_compression = false);
+
+  // Return an estimate of the size of the block we are building.
+  size_t CurrentSizeEstimate() const;
+
+  // Reset block contents.
+  void Reset();
+
+ private:
+  std::vector<uint32_t> offsets_;  // Offset of each entry
+};
+
+// Read block contents built by VarArrayBlockBuilder.
+class VarArrayBlock {
+ public:
+  explicit VarArrayBlock(const BlockContents&);  // Open block contents for read
+
+  ~VarArrayBlock();
+
+  Iterator* NewIterator(const Comparator* comparator);
+
+ private:
+  const char* data_;
+  size_t size_;
+  bool owned_;  // If data_[] is owned by us
+  uint32_t num_entries_;
+  uint32_t offsets_;  // Offset of the offset table
+
+  class Iter;
+};
+
 // Open an iterator on top of a given data block. The returned the iterator
 // should be deleted when no longer needed.
 extern Iterator* OpenDirBlock  // Use options to determine block formats
@@ -194,7 +257,9 @@ class DirBuilder {
 
 class SortedStringBlockBuilder;
 class ArrayBlockBuilder;
+class VarArrayBlockBuilder;
 class LogWriter;
+struct DataBlockJob;
 
 // Write directory contents into an index log and a data log object. Directory
 // contents are divided into epochs. Epoch id starts with 0, and increments
@@ -233,6 +298,14 @@ class SeqDirBuilder : public DirBuilder {
   // Flush buffered data blocks and finalize their indexes.
   // REQUIRES: Finish() has not been called.
   void Commit();
+
+  // Wait for all data blocks being compressed in the background and append
+  // them to the data block buffer in their original order. Index entries of
+  // these blocks are rewritten to point to their final buffer locations.
+  void LayoutCompressedBlocks();
+
+  // Wait for all outstanding background compressions to finish.
+  void WaitForCompressedBlocks();
 #ifndef NDEBUG
   // Used to verify the uniqueness of all input keys
   std::set<std::string> keys_;
@@ -252,6 +325,13 @@ class SeqDirBuilder : public DirBuilder {
   BlockBuilder root_block_;  // Locate each epoch
   bool pending_indx_entry_;
   BlockHandle last_data_info_;
+  // Attribute ranges of the current data block, the last finished data
+  // block, and the current table. Only maintained when the secondary range
+  // index is enabled.
+  bool attr_index_;
+  AttrRange block_attrs_;
+  AttrRange last_data_attrs_;
+  AttrRange table_attrs_;
   bool pending_meta_entry_;
   TableHandle last_tabl_info_;
   bool pending_root_entry_;
@@ -261,6 +341,14 @@ class SeqDirBuilder : public DirBuilder {
   uint64_t pending_indx_flush_;  // Offset of the index pending flush
   LogSink* data_sink_;
   uint64_t data_offset_;  // Latest data offset
+  // Data blocks handed to the compression pool and not yet committed.
+  // Index entries of these blocks temporarily store the position of the block
+  // in this list instead of its offset in the data block buffer.
+  std::vector<DataBlockJob*> uncommitted_jobs_;
+  size_t uncommitted_job_bytes_;  // Total raw size of the uncommitted jobs
+  bool async_compression_;
+  port::Mutex job_mu_;
+  port::CondVar job_cv_;
   LogWriter* indx_writter_;
   LogSink* indx_sink_;
   bool finished_;
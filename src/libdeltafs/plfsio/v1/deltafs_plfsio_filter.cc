@@ -92,10 +92,10 @@ void BloomBlock::Reset(uint32_t num_keys) {
   bits_ = bytes * 8;
 }
 
-void BloomBlock::AddKey(const Slice& key) {
+void BloomBlock::AddHash(uint32_t hash) {
   assert(!finished_);  // Finish() has not been called
   // Use double-hashing to generate a sequence of hash values.
-  uint32_t h = BloomHash(key);
+  uint32_t h = hash;
   const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
   for (size_t j = 0; j < k_; j++) {
     const uint32_t b = h % bits_;
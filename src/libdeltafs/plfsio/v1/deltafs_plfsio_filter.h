@@ -52,7 +52,12 @@ class BloomBlock {
   // Insert a key into the bloom filter.
   // REQUIRES: Reset(num_keys) has been called.
   // REQUIRES: Finish() has not been called.
-  void AddKey(const Slice& key);
+  void AddKey(const Slice& key) { AddHash(BloomHash(key)); }
+
+  // Insert a key whose bloom hash has already been computed.
+  // REQUIRES: Reset(num_keys) has been called.
+  // REQUIRES: Finish() has not been called.
+  void AddHash(uint32_t hash);
 
   // Finalize the block data and return its contents.
   Slice Finish();
@@ -19,6 +19,16 @@ std::string DirInfoFileName(const std::string& dirname) {
   return dirname + "/DIR.info";
 }
 
+std::string DirSummaryFileName(const std::string& dirname) {
+  return dirname + "/DIR.summary";
+}
+
+std::string RankSummaryFileName(const std::string& dirname, int rank) {
+  char tmp[30];
+  snprintf(tmp, sizeof(tmp), "/L-%08x.sum", rank);
+  return dirname + tmp;
+}
+
 std::string DirModeName(DirMode mode) {
   switch (mode) {
     case kDmMultiMap:
@@ -78,6 +88,9 @@ void TableHandle::EncodeTo(std::string* dst) const {
   PutVarint64(dst, filter_size_);
   PutVarint64(dst, index_offset_);
   PutVarint64(dst, index_size_);
+  if (has_attr_range_) {
+    attr_range_.EncodeTo(dst);
+  }
 }
 
 Status TableHandle::DecodeFrom(Slice* input) {
@@ -93,10 +106,56 @@ Status TableHandle::DecodeFrom(Slice* input) {
   } else {
     smallest_key_ = smallest_key.ToString();
     largest_key_ = largest_key.ToString();
+    // Tables written without the secondary range index
+    // end right after their index handle
+    has_attr_range_ = !input->empty();
+    if (has_attr_range_) {
+      return attr_range_.DecodeFrom(input);
+    } else {
+      attr_range_.Clear();
+      return Status::OK();
+    }
+  }
+}
+
+void AttrRange::EncodeTo(std::string* dst) const {
+  PutVarint64(dst, smallest_);
+  PutVarint64(dst, largest_);
+}
+
+Status AttrRange::DecodeFrom(Slice* input) {
+  if (!GetVarint64(input, &smallest_) || !GetVarint64(input, &largest_)) {
+    return Status::Corruption("Bad attribute range");
+  } else {
     return Status::OK();
   }
 }
 
+bool ExtractAttr(const DirOptions& options, const Slice& key,
+                 const Slice& value, uint64_t* attr) {
+  assert(options.attr_extractor != NULL);
+  if (!options.value_log) {
+    return options.attr_extractor(options.attr_extractor_arg, key, value,
+                                  attr);
+  }
+  Slice input = value;
+  if (input.empty()) {
+    return false;
+  }
+  const unsigned char type = static_cast<unsigned char>(input[0]);
+  input.remove_prefix(1);
+  if (type == kValueInline) {
+    return options.attr_extractor(options.attr_extractor_arg, key, input,
+                                  attr);
+  } else if (type == kValuePointer) {
+    BlockHandle handle;
+    // The attribute, if any, follows the handle
+    return handle.DecodeFrom(&input).ok() && GetVarint64(&input, attr);
+  } else {
+    return false;
+  }
+}
+
 void EpochHandle::EncodeTo(std::string* dst) const {
   assert(index_offset_ != ~static_cast<uint64_t>(0));
   assert(index_size_ != ~static_cast<uint64_t>(0));
@@ -150,6 +209,8 @@ DirOptions ApplyFooter(const DirOptions& options, const Footer& footer) {
   result.skip_checksums = footer.skip_checksums();
   result.filter = static_cast<FilterType>(footer.filter_type());
   result.mode = static_cast<DirMode>(footer.mode());
+  result.value_log = footer.value_log();
+  result.var_array_blocks = footer.var_array_blocks();
   return result;
 }
 
@@ -167,6 +228,9 @@ Footer Mkfoot(const DirOptions& options) {
   result.set_skip_checksums(static_cast<unsigned char>(options.skip_checksums));
   result.set_filter_type(static_cast<unsigned char>(options.filter));
   result.set_mode(static_cast<unsigned char>(options.mode));
+  result.set_value_log(static_cast<unsigned char>(options.value_log));
+  result.set_var_array_blocks(
+      static_cast<unsigned char>(options.var_array_blocks));
   return result;
 }
 
@@ -181,6 +245,8 @@ void Footer::EncodeTo(std::string* dst) const {
   assert(skip_checksums_ != 0xFF);
   assert(filter_type_ != 0xFF);
   assert(mode_ != 0xFF);
+  assert(value_log_ != 0xFF);
+  assert(var_array_blocks_ != 0xFF);
 
   epoch_index_handle_.EncodeTo(dst);
   dst->resize(BlockHandle::kMaxEncodedLength, 0);  // Padding
@@ -196,54 +262,87 @@ void Footer::EncodeTo(std::string* dst) const {
   dst->push_back(static_cast<char>(skip_checksums_));
   dst->push_back(static_cast<char>(filter_type_));
   dst->push_back(static_cast<char>(mode_));
+  dst->push_back(static_cast<char>(value_log_));
+  dst->push_back(static_cast<char>(var_array_blocks_));
+  dst->push_back(static_cast<char>(kFormatVersion));
+}
+
+static bool HasFooterMagic(const char* footer) {
+  const char* magic_ptr = footer + BlockHandle::kMaxEncodedLength;
+  const uint32_t magic_lo = DecodeFixed32(magic_ptr);
+  const uint32_t magic_hi = DecodeFixed32(magic_ptr + 4);
+  const uint64_t magic = ((static_cast<uint64_t>(magic_hi) << 32) |
+                          (static_cast<uint64_t>(magic_lo)));
+  return magic == kTableMagicNumber;
 }
 
 Status Footer::DecodeFrom(Slice* input) {
-  const char* start = input->data();
-  size_t size = input->size();
-  uint64_t magic;
+  const char* const limit = input->data() + input->size();
+  const size_t size = input->size();
+  const char* start;
 
-  if (size < kEncodedLength) {
+  // Both footer layouts begin with an encoded block handle followed by a
+  // magic number, so the magic tells us where the footer starts
+  if (size < kLegacyEncodedLength) {
     return Status::Corruption("Truncated dir footer");
+  } else if (size >= kEncodedLength && HasFooterMagic(limit - kEncodedLength)) {
+    start = limit - kEncodedLength;
+    version_ = static_cast<unsigned char>(start[kEncodedLength - 1]);
+    if (version_ == 0 || version_ > kFormatVersion) {
+      return Status::NotSupported("Unknown dir footer version");
+    }
+    lg_parts_ = DecodeFixed32(start + kEncodedLength - 25);
+    num_epochs_ = DecodeFixed32(start + kEncodedLength - 21);
+    value_size_ = DecodeFixed32(start + kEncodedLength - 17);
+    key_size_ = DecodeFixed32(start + kEncodedLength - 13);
+    fixed_kv_length_ = static_cast<unsigned char>(start[kEncodedLength - 9]);
+    leveldb_compatible_ = static_cast<unsigned char>(start[kEncodedLength - 8]);
+    epoch_log_rotation_ = static_cast<unsigned char>(start[kEncodedLength - 7]);
+    skip_checksums_ = static_cast<unsigned char>(start[kEncodedLength - 6]);
+    filter_type_ = static_cast<unsigned char>(start[kEncodedLength - 5]);
+    mode_ = static_cast<unsigned char>(start[kEncodedLength - 4]);
+    value_log_ = static_cast<unsigned char>(start[kEncodedLength - 3]);
+    var_array_blocks_ = static_cast<unsigned char>(start[kEncodedLength - 2]);
+  } else if (HasFooterMagic(limit - kLegacyEncodedLength)) {
+    start = limit - kLegacyEncodedLength;
+    version_ = 0;
+    lg_parts_ = DecodeFixed32(start + kLegacyEncodedLength - 22);
+    num_epochs_ = DecodeFixed32(start + kLegacyEncodedLength - 18);
+    value_size_ = DecodeFixed32(start + kLegacyEncodedLength - 14);
+    key_size_ = DecodeFixed32(start + kLegacyEncodedLength - 10);
+    fixed_kv_length_ =
+        static_cast<unsigned char>(start[kLegacyEncodedLength - 6]);
+    leveldb_compatible_ =
+        static_cast<unsigned char>(start[kLegacyEncodedLength - 5]);
+    epoch_log_rotation_ =
+        static_cast<unsigned char>(start[kLegacyEncodedLength - 4]);
+    skip_checksums_ =
+        static_cast<unsigned char>(start[kLegacyEncodedLength - 3]);
+    filter_type_ = static_cast<unsigned char>(start[kLegacyEncodedLength - 2]);
+    mode_ = static_cast<unsigned char>(start[kLegacyEncodedLength - 1]);
+    // Neither feature existed when version 0 footers were written
+    value_log_ = 0;
+    var_array_blocks_ = 0;
   } else {
-    const char* magic_ptr = start + BlockHandle::kMaxEncodedLength;
-    const uint32_t magic_lo = DecodeFixed32(magic_ptr);
-    const uint32_t magic_hi = DecodeFixed32(magic_ptr + 4);
-    magic = ((static_cast<uint64_t>(magic_hi) << 32) |
-             (static_cast<uint64_t>(magic_lo)));
+    return Status::Corruption("Bad dir footer magic number");
   }
 
-  if (magic != kTableMagicNumber) {
-    return Status::Corruption("Bad dir footer magic number");
-  } else {
-    lg_parts_ = DecodeFixed32(start + kEncodedLength - 22);
-    num_epochs_ = DecodeFixed32(start + kEncodedLength - 18);
-    value_size_ = DecodeFixed32(start + kEncodedLength - 14);
-    key_size_ = DecodeFixed32(start + kEncodedLength - 10);
-    fixed_kv_length_ = static_cast<unsigned char>(start[kEncodedLength - 6]);
-    leveldb_compatible_ = static_cast<unsigned char>(start[kEncodedLength - 5]);
-    epoch_log_rotation_ = static_cast<unsigned char>(start[kEncodedLength - 4]);
-    skip_checksums_ = static_cast<unsigned char>(start[kEncodedLength - 3]);
-    filter_type_ = static_cast<unsigned char>(start[kEncodedLength - 2]);
-    mode_ = static_cast<unsigned char>(start[kEncodedLength - 1]);
-    switch (mode_) {
-      case kDmMultiMap:
-      case kDmMultiMapUnordered:
-      case kDmUniqueUnordered:
-      case kDmUniqueDrop:
-      case kDmUniqueKey:
-        break;
-      default:
-        return Status::Corruption("Bad dir mode");
-    }
+  switch (mode_) {
+    case kDmMultiMap:
+    case kDmMultiMapUnordered:
+    case kDmUniqueUnordered:
+    case kDmUniqueDrop:
+    case kDmUniqueKey:
+      break;
+    default:
+      return Status::Corruption("Bad dir mode");
   }
 
-  Status result = epoch_index_handle_.DecodeFrom(input);
+  Slice handle_input(start, BlockHandle::kMaxEncodedLength);
+  Status result = epoch_index_handle_.DecodeFrom(&handle_input);
   if (result.ok()) {
-    Slice source(start, size);
-    source.remove_prefix(kEncodedLength);
-    // This skips over any leftover data
-    *input = source;
+    // The entire input has been consumed
+    *input = Slice(limit, 0);
   }
 
   return result;
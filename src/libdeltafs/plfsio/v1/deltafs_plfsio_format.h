@@ -51,6 +51,53 @@ enum ChunkType {
   kFooter = 0xfe
 };
 
+// Type definition for values stored in data blocks when the value log is
+// enabled. Each value is prefixed with one of these types.
+enum ValueType {
+  kValueInline = 0x00,  // Value follows the type as-is
+  kValuePointer = 0x01  // Handle to the value in the value log follows
+};
+
+// The smallest and the largest value attribute seen in a data block or a
+// table. Used by the secondary range index. A range is empty if no value
+// carries an attribute.
+class AttrRange {
+ public:
+  AttrRange();
+
+  uint64_t smallest() const { return smallest_; }
+  uint64_t largest() const { return largest_; }
+
+  bool empty() const { return smallest_ > largest_; }
+  void Clear();
+
+  // Extend the range to cover a given attribute.
+  void Add(uint64_t attr) {
+    if (attr < smallest_) smallest_ = attr;
+    if (attr > largest_) largest_ = attr;
+  }
+
+  // Return true iff the range may contain attributes in [lo, hi].
+  bool Overlaps(uint64_t lo, uint64_t hi) const {
+    return !empty() && smallest_ <= hi && lo <= largest_;
+  }
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(Slice* input);
+
+ private:
+  uint64_t smallest_;
+  uint64_t largest_;
+};
+
+// Extract the attribute of a value stored in data blocks using the
+// attribute extractor set in options. Values stored in the value log carry
+// an attribute extracted when they were inserted. Return true if the value
+// has an attribute.
+// REQUIRES: options.attr_extractor != NULL.
+extern bool ExtractAttr(const DirOptions& options, const Slice& key,
+                        const Slice& value, uint64_t* attr);
+
 // Information regarding a table.
 class TableHandle {
  public:
@@ -80,6 +127,15 @@ class TableHandle {
   Slice largest_key() const { return largest_key_; }
   void set_largest_key(const Slice& key) { largest_key_ = key.ToString(); }
 
+  // The attribute range of the table. Only stored when the
+  // secondary range index is enabled.
+  bool has_attr_range() const { return has_attr_range_; }
+  const AttrRange& attr_range() const { return attr_range_; }
+  void set_attr_range(const AttrRange& range) {
+    attr_range_ = range;
+    has_attr_range_ = true;
+  }
+
   void EncodeTo(std::string* dst) const;
   Status DecodeFrom(Slice* input);
 
@@ -92,6 +148,9 @@ class TableHandle {
   uint64_t filter_size_;
   uint64_t index_offset_;
   uint64_t index_size_;
+  // Optional attribute range
+  bool has_attr_range_;
+  AttrRange attr_range_;
 };
 
 // Information regarding an epoch.
@@ -179,6 +238,12 @@ class Footer {
   unsigned char mode() const { return mode_; }
   void set_mode(unsigned char mode) { mode_ = mode; }
 
+  unsigned char value_log() const { return value_log_; }
+  void set_value_log(unsigned char v) { value_log_ = v; }
+
+  unsigned char var_array_blocks() const { return var_array_blocks_; }
+  void set_var_array_blocks(unsigned char v) { var_array_blocks_ = v; }
+
   // The block handle for the root index.
   const BlockHandle& epoch_index_handle() const { return epoch_index_handle_; }
   void set_epoch_index_handle(const BlockHandle& h) { epoch_index_handle_ = h; }
@@ -187,13 +252,30 @@ class Footer {
   uint32_t num_epochs() const { return num_epochs_; }
   void set_num_epochs(uint32_t num) { num_epochs_ = num; }
 
+  // Format version of the footer. Version 0 denotes a footer written
+  // before versions were introduced.
+  unsigned char version() const { return version_; }
+
   void EncodeTo(std::string* dst) const;
+  // Decode a footer stored at the end of *input. Footers of version 0
+  // are upgraded with the value log and the var array block flags off.
   Status DecodeFrom(Slice* input);
 
-  // Encoded length of a Footer. It consists of one encoded block
-  // handle, a set of persisted options (22 bytes in total),
-  // and a magic number (8 bytes).
-  enum { kEncodedLength = BlockHandle::kMaxEncodedLength + 22 + 8 };
+  // Number of bytes taken by the footer that has been decoded.
+  size_t encoded_length() const {
+    return version_ == 0 ? kLegacyEncodedLength : kEncodedLength;
+  }
+
+  enum {
+    // Encoded length of a Footer. It consists of one encoded block
+    // handle, a magic number (8 bytes), a set of persisted options
+    // (24 bytes in total), and a format version (1 byte).
+    kEncodedLength = BlockHandle::kMaxEncodedLength + 8 + 24 + 1,
+    // Encoded length of a version 0 Footer, which has 22 bytes of options
+    // and no format version.
+    kLegacyEncodedLength = BlockHandle::kMaxEncodedLength + 8 + 22
+  };
+  enum { kFormatVersion = 1 };
 
  private:
   BlockHandle epoch_index_handle_;
@@ -207,6 +289,9 @@ class Footer {
   unsigned char skip_checksums_;
   unsigned char filter_type_;
   unsigned char mode_;
+  unsigned char value_log_;  // If values may be stored in a value log
+  unsigned char var_array_blocks_;
+  unsigned char version_;
 };
 
 // Override directory options using a specified footer.
@@ -216,13 +301,30 @@ extern Footer Mkfoot(const DirOptions& options);
 
 extern std::string DirInfoFileName(const std::string& dirname);
 
+// Job-level key summary merged from the summaries of all ranks.
+extern std::string DirSummaryFileName(const std::string& dirname);
+
+// Key summary written by a specific rank at the end of a job.
+extern std::string RankSummaryFileName(const std::string& dirname, int rank);
+
 extern std::string DirModeName(DirMode mode);
 
+inline AttrRange::AttrRange()
+    : smallest_(~static_cast<uint64_t>(0)), largest_(0) {
+  // Empty
+}
+
+inline void AttrRange::Clear() {
+  smallest_ = ~static_cast<uint64_t>(0);
+  largest_ = 0;
+}
+
 inline TableHandle::TableHandle()
     : filter_offset_(~static_cast<uint64_t>(0) /* Invalid offset */),
       filter_size_(~static_cast<uint64_t>(0) /* Invalid size */),
       index_offset_(~static_cast<uint64_t>(0) /* Invalid offset */),
-      index_size_(~static_cast<uint64_t>(0) /* Invalid size */) {
+      index_size_(~static_cast<uint64_t>(0) /* Invalid size */),
+      has_attr_range_(false) {
   // Empty
 }
 
@@ -249,7 +351,10 @@ inline Footer::Footer()
       epoch_log_rotation_(0xFF /* Invalid */),
       skip_checksums_(0xFF /* Invalid */),
       filter_type_(0xFF /* Invalid */),
-      mode_(0xFF /* Invalid */) {
+      mode_(0xFF /* Invalid */),
+      value_log_(0xFF /* Invalid */),
+      var_array_blocks_(0xFF /* Invalid */),
+      version_(kFormatVersion) {
   // Empty
 }
 
@@ -483,6 +483,8 @@ Status DirIndexer::Open(LogSink* data, LogSink* indx) {
   // builder type with one specific block format.
   if (!options_.leveldb_compatible && options_.fixed_kv_length)
     compactor_ = OpenCompactor<SeqDirBuilder<ArrayBlockBuilder> >(bu);
+  else if (!options_.leveldb_compatible && options_.var_array_blocks)
+    compactor_ = OpenCompactor<SeqDirBuilder<VarArrayBlockBuilder> >(bu);
 
   if (compactor_ == NULL)  // Use the default block format
     compactor_ = OpenCompactor<SeqDirBuilder<> >(bu);
@@ -502,21 +504,15 @@ Status DirIndexer::bg_status() {
   return bg_status_;
 }
 
-// Sync and pre-close all linked log files.
+// Sync and pre-close the index log.
 // By default, log files are reference-counted and are implicitly closed when
 // de-referenced by the last opener. Optionally, a caller may force data
-// sync and pre-closing all log files.
-Status DirIndexer::SyncAndClose() {
-  mu_->AssertHeld();
-  assert(!has_bg_compaction_);
+// sync and pre-closing the index log.
+Status DirIndexer::SyncAndCloseIndex() {
   Status status;
   if (!opened_) return status;
-  assert(data_ != NULL);
-  data_->Lock();
-  status = data_->Lclose(true);
-  data_->Unlock();
   assert(indx_ != NULL);
-  if (status.ok()) status = indx_->Lclose(true);
+  status = indx_->Lclose(true);
   return status;
 }
 
@@ -781,7 +777,13 @@ static Status ReadBlock(LogSource* source, const DirOptions& options,
     buf = new char[m];
   }
   Slice contents;
-  Status status = source->Read(handle.offset(), m, &contents, buf, file_index);
+  Status status;
+  if (options.direct_io_reads && !cached) {
+    status =
+        source->ReadAligned(handle.offset(), m, &contents, buf, file_index);
+  } else {
+    status = source->Read(handle.offset(), m, &contents, buf, file_index);
+  }
   if (status.ok()) {
     if (contents.size() != m) {
       status = Status::Corruption("Truncated block read");
@@ -843,12 +845,201 @@ static Status ReadBlock(LogSource* source, const DirOptions& options,
   return status;
 }
 
+namespace {
+
+// Reads data blocks ahead of a scan using a thread pool. Block reads are
+// issued in order and at most "window" blocks are in flight or waiting to
+// be consumed at any time. A block whose read has not started by the time
+// the scan needs it is read directly by the scan thread, so a busy pool can
+// never stall the scan. The scan itself may run on the same pool, so the
+// scan never waits for a read that has not started: queued reads hold a
+// reference to the prefetcher and the last one to run deletes it.
+class BlockPrefetcher {
+ public:
+  BlockPrefetcher(LogSource* source, const DirOptions& options,
+                  uint32_t file_index, const std::vector<BlockHandle>& handles,
+                  size_t window, ThreadPool* pool)
+      : source_(source),
+        options_(options),
+        file_index_(file_index),
+        window_(window),
+        pool_(pool),
+        cv_(&mu_),
+        slots_(handles.size()),
+        next_(0),
+        num_running_(0),
+        refs_(1) {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      slots_[i].handle = handles[i];
+      slots_[i].state = kQueued;
+      slots_[i].parent = this;
+    }
+    while (next_ < slots_.size() && next_ < window_) {
+      Schedule();
+    }
+  }
+
+  // Cancel reads that have not started, wait for those that have, and
+  // release blocks never taken by the scan. The prefetcher is deleted
+  // once all queued reads have been dequeued by the pool.
+  void Release() {
+    mu_.Lock();
+    for (size_t i = 0; i < next_; i++) {
+      if (slots_[i].state == kQueued) {
+        slots_[i].state = kTaken;  // Cancel the read
+      }
+    }
+    while (num_running_ != 0) {
+      cv_.Wait();
+    }
+    for (size_t i = 0; i < next_; i++) {
+      if (slots_[i].state == kDone && slots_[i].contents.heap_allocated) {
+        delete[] slots_[i].contents.data.data();
+        slots_[i].state = kTaken;
+      }
+    }
+    Unref();
+  }
+
+  // Obtain the contents of the i-th block. Blocks must be taken in order.
+  Status Take(size_t i, BlockContents* result) {
+    assert(i < slots_.size());
+    Slot* const slot = &slots_[i];
+    MutexLock ml(&mu_);
+    while (next_ < slots_.size() && next_ < i + 1 + window_) {
+      Schedule();
+    }
+    if (slot->state == kQueued) {
+      slot->state = kRunning;  // Read it ourselves
+      mu_.Unlock();
+      Read(slot);
+      mu_.Lock();
+      slot->state = kDone;
+    }
+    while (slot->state != kDone) {
+      cv_.Wait();
+    }
+    slot->state = kTaken;
+    *result = slot->contents;
+    return slot->status;
+  }
+
+ private:
+  enum State { kQueued, kRunning, kDone, kTaken };
+
+  struct Slot {
+    BlockPrefetcher* parent;
+    BlockHandle handle;
+    BlockContents contents;
+    Status status;
+    State state;
+  };
+
+  ~BlockPrefetcher() { assert(refs_ == 0); }
+
+  // REQUIRES: mu_ has been locked.
+  void Schedule() {
+    mu_.AssertHeld();
+    refs_++;
+    pool_->Schedule(BGRead, &slots_[next_++]);
+  }
+
+  // Drop a reference and delete the prefetcher if it was the last one.
+  // REQUIRES: mu_ has been locked. Unlocks mu_.
+  void Unref() {
+    mu_.AssertHeld();
+    assert(refs_ > 0);
+    refs_--;
+    const bool do_delete = (refs_ == 0);
+    mu_.Unlock();
+    if (do_delete) {
+      delete this;
+    }
+  }
+
+  void Read(Slot* slot) {
+    slot->status = ReadBlock(source_, options_, slot->handle, &slot->contents,
+                             false, file_index_);
+  }
+
+  static void BGRead(void* arg) {
+    Slot* const slot = reinterpret_cast<Slot*>(arg);
+    BlockPrefetcher* const pf = slot->parent;
+    pf->mu_.Lock();
+    if (slot->state == kQueued) {
+      slot->state = kRunning;
+      pf->num_running_++;
+      pf->mu_.Unlock();
+      pf->Read(slot);
+      pf->mu_.Lock();
+      slot->state = kDone;
+      assert(pf->num_running_ > 0);
+      pf->num_running_--;
+      pf->cv_.SignalAll();
+    }
+    pf->Unref();
+  }
+
+  LogSource* const source_;
+  const DirOptions& options_;
+  const uint32_t file_index_;
+  const size_t window_;
+  ThreadPool* const pool_;
+  port::Mutex mu_;
+  port::CondVar cv_;
+  // State below is protected by mu_
+  std::vector<Slot> slots_;
+  size_t next_;       // Index of the next block to schedule
+  int num_running_;   // Number of background reads in progress
+  int refs_;          // The scan plus the reads waiting in the pool
+
+  // No copying allowed
+  void operator=(const BlockPrefetcher& pf);
+  BlockPrefetcher(const BlockPrefetcher&);
+};
+
+// Schedules block prefetches on the Env's background threads.
+class EnvPool : public ThreadPool {
+ public:
+  EnvPool() {}
+  virtual ~EnvPool() {}
+
+  virtual void Schedule(void (*function)(void*), void* arg) {
+    Env::Default()->Schedule(function, arg);
+  }
+
+  virtual std::string ToDebugString() { return "env"; }
+  virtual void Pause() {}
+  virtual void Resume() {}
+};
+
+}  // namespace
+
+Status Dir::DecodeBlockHandle(const IterOptions& opts, Slice* input,
+                              BlockHandle* handle, bool* skip) {
+  *skip = false;
+  Status status = handle->DecodeFrom(input);
+  if (!status.ok()) {
+    return status;
+  }
+  // Data blocks indexed by the secondary range index store their attribute
+  // range right after their block handle
+  if (opts.has_attr_range && !input->empty()) {
+    AttrRange attrs;
+    status = attrs.DecodeFrom(input);
+    if (status.ok() && !attrs.Overlaps(opts.attr_lo, opts.attr_hi)) {
+      *skip = true;
+    }
+  }
+  return status;
+}
+
 // Retrieve all keys from a given data block.
 Status Dir::Iter(const IterOptions& opts, Slice* input) {
-  Status status;
   BlockHandle handle;
-  status = handle.DecodeFrom(input);
-  if (!status.ok()) {
+  bool skip;
+  Status status = DecodeBlockHandle(opts, input, &handle, &skip);
+  if (!status.ok() || skip) {
     return status;
   }
   BlockContents contents;
@@ -860,10 +1051,36 @@ Status Dir::Iter(const IterOptions& opts, Slice* input) {
     opts.stats->seeks++;
   }
 
+  return Iter(opts, contents);
+}
+
+// Retrieve all keys from a given block whose contents have been fetched.
+Status Dir::Iter(const IterOptions& opts, const BlockContents& contents) {
+  if (opts.agg != NULL) {
+    return Aggregate(opts, contents);
+  }
+  Status status;
+  const bool filter_values =
+      opts.has_attr_range && options_.attr_extractor != NULL;
   Iterator* const iter = OpenDirBlock(options_, contents);
+  std::string scratch;
   iter->SeekToFirst();
   for (; iter->Valid(); iter->Next()) {
-    if (opts.saver(opts.arg, iter->key(), iter->value()) == -1) {
+    Slice value = iter->value();
+    if (filter_values) {
+      uint64_t attr;
+      if (!ExtractAttr(options_, iter->key(), value, &attr) ||
+          attr < opts.attr_lo || attr > opts.attr_hi) {
+        continue;
+      }
+    }
+    if (options_.value_log) {
+      status = ReadValue(opts.file_index, &value, &scratch);
+      if (!status.ok()) {
+        break;
+      }
+    }
+    if (opts.saver(opts.arg, iter->key(), value) == -1) {
       // User does not want to continue
       break;
     }
@@ -877,10 +1094,140 @@ Status Dir::Iter(const IterOptions& opts, Slice* input) {
   return status;
 }
 
+// Decode an unsigned little-endian integer of "n" bytes.
+static inline uint64_t DecodeField(const char* p, size_t n) {
+  switch (n) {
+    case 1:
+      return static_cast<unsigned char>(p[0]);
+    case 2:
+      return static_cast<unsigned char>(p[0]) |
+             (static_cast<uint64_t>(static_cast<unsigned char>(p[1])) << 8);
+    case 4:
+      return DecodeFixed32(p);
+    case 8:
+      return DecodeFixed64(p);
+    default:
+      return 0;
+  }
+}
+
+// Aggregate all keys from a given block whose contents have been fetched.
+Status Dir::Aggregate(const IterOptions& opts, const BlockContents& contents) {
+  Status status;
+  const AggregateSpec& spec = *opts.agg;
+  AggregateResult* const result = opts.stats->agg;
+  assert(result != NULL);
+  const bool filter_values =
+      opts.has_attr_range && options_.attr_extractor != NULL;
+  const size_t field_end = spec.field_offset + spec.field_size;
+  // Fixed-sized entries are aggregated directly from the block buffer
+  // without going through an iterator
+  if (!options_.leveldb_compatible && options_.fixed_kv_length &&
+      !options_.value_log && !filter_values && spec.predicate == NULL) {
+    ArrayBlock block(contents);
+    const size_t n = block.NumEntries();
+    if (spec.field_size == 0 || field_end <= block.value_size()) {
+      const size_t stride = block.key_size() + block.value_size();
+      const char* p = block.data() + block.key_size() + spec.field_offset;
+      if (spec.bucket_limits.empty() && n != 0) {
+        uint64_t min = result->min;
+        uint64_t max = result->max;
+        uint64_t sum = result->sum;
+        for (size_t i = 0; i < n; i++) {
+          const uint64_t v = DecodeField(p, spec.field_size);
+          min = std::min(min, v);
+          max = std::max(max, v);
+          sum += v;
+          p += stride;
+        }
+        result->count += n;
+        result->min = min;
+        result->max = max;
+        result->sum = sum;
+      } else {
+        for (size_t i = 0; i < n; i++) {
+          result->Add(spec, DecodeField(p, spec.field_size));
+          p += stride;
+        }
+      }
+      opts.stats->n += n;
+    }
+    return status;
+  }
+
+  Iterator* const iter = OpenDirBlock(options_, contents);
+  std::string scratch;
+  iter->SeekToFirst();
+  for (; iter->Valid(); iter->Next()) {
+    Slice value = iter->value();
+    if (filter_values) {
+      uint64_t attr;
+      if (!ExtractAttr(options_, iter->key(), value, &attr) ||
+          attr < opts.attr_lo || attr > opts.attr_hi) {
+        continue;
+      }
+    }
+    if (options_.value_log) {
+      status = ReadValue(opts.file_index, &value, &scratch);
+      if (!status.ok()) {
+        break;
+      }
+    }
+    if (spec.predicate != NULL &&
+        !spec.predicate(spec.predicate_arg, iter->key(), value)) {
+      continue;
+    }
+    if (value.size() >= field_end) {
+      opts.stats->n++;
+      result->Add(spec, DecodeField(value.data() + spec.field_offset,
+                                    spec.field_size));
+    }
+  }
+  if (status.ok()) {
+    status = iter->status();
+  }
+
+  delete iter;
+  return status;
+}
+
+// Retrieve all keys from a list of data blocks while reading blocks ahead
+// in the background. Return OK on success and a non-OK status on errors.
+Status Dir::IterWithPrefetch(const IterOptions& opts,
+                             const std::vector<BlockHandle>& handles) {
+  Status status;
+  EnvPool env_pool;
+  ThreadPool* pool = options_.reader_pool;
+  if (pool == NULL) pool = &env_pool;
+  BlockPrefetcher* const prefetcher =
+      new BlockPrefetcher(data_, options_, opts.file_index, handles,
+                          options_.prefetch_blocks, pool);
+  for (size_t i = 0; i < handles.size(); i++) {
+    BlockContents contents;
+    status = prefetcher->Take(i, &contents);
+    if (!status.ok()) {
+      break;
+    } else {
+      opts.stats->seeks++;
+    }
+    status = Iter(opts, contents);
+    if (!status.ok()) {
+      break;
+    }
+  }
+
+  prefetcher->Release();
+  return status;
+}
+
 // Retrieve all keys from a given table and call "opts.saver" to handle the
 // results. Return OK on success and a non-OK status on errors.
 Status Dir::Iter(const IterOptions& opts, const TableHandle& h) {
   Status status;
+  if (opts.has_attr_range && h.has_attr_range() &&
+      !h.attr_range().Overlaps(opts.attr_lo, opts.attr_hi)) {
+    return status;  // Skip the table
+  }
   // Load the index block
   BlockContents index_contents;
   BlockHandle index_handle;
@@ -897,12 +1244,26 @@ Status Dir::Iter(const IterOptions& opts, const TableHandle& h) {
     opts.stats->table_seeks++;
   }
 
+  // Blocks can only be read ahead if there are threads to read them
+  const bool prefetch =
+      options_.prefetch_blocks != 0 &&
+      (options_.reader_pool != NULL || options_.allow_env_threads);
+  std::vector<BlockHandle> handles;
   Block* index_block = new Block(index_contents);
   Iterator* const iter = index_block->NewIterator(BytewiseComparator());
   iter->SeekToFirst();
   for (; iter->Valid(); iter->Next()) {
     Slice input = iter->value();
-    status = Iter(opts, &input);
+    if (prefetch) {
+      BlockHandle handle;
+      bool skip;
+      status = DecodeBlockHandle(opts, &input, &handle, &skip);
+      if (status.ok() && !skip) {
+        handles.push_back(handle);
+      }
+    } else {
+      status = Iter(opts, &input);
+    }
     if (!status.ok()) {
       break;
     }
@@ -910,6 +1271,9 @@ Status Dir::Iter(const IterOptions& opts, const TableHandle& h) {
   if (status.ok()) {
     status = iter->status();
   }
+  if (status.ok() && !handles.empty()) {
+    status = IterWithPrefetch(opts, handles);
+  }
 
   delete iter;
   delete index_block;
@@ -973,9 +1337,17 @@ Status Dir::Fetch(const FetchOptions& opts, const Slice& key, Slice* input,
   }
 
   // Collect all results
+  std::string scratch;
   for (; iter->Valid(); iter->Next()) {
     if (iter->key() == key) {  // Hit
-      opts.saver(opts.arg, key, iter->value());
+      Slice value = iter->value();
+      if (options_.value_log) {
+        status = ReadValue(opts.file_index, &value, &scratch);
+        if (!status.ok()) {
+          break;
+        }
+      }
+      opts.saver(opts.arg, key, value);
       if (IsKeyUnique(options_.mode)) {
         *found = true;
         break;  // Done
@@ -996,6 +1368,42 @@ Status Dir::Fetch(const FetchOptions& opts, const Slice& key, Slice* input,
   return status;
 }
 
+Status Dir::ReadValue(uint32_t file_index, Slice* value,
+                     std::string* scratch) {
+  Status status;
+  if (value->empty()) {
+    return Status::Corruption("Missing value type");
+  }
+  const unsigned char type = static_cast<unsigned char>((*value)[0]);
+  value->remove_prefix(1);
+  if (type == kValueInline) {
+    return status;
+  } else if (type != kValuePointer) {
+    return Status::Corruption("Bad value type");
+  } else if (vlog_ == NULL) {
+    return Status::Corruption("Missing value log");
+  }
+
+  BlockHandle handle;
+  status = handle.DecodeFrom(value);
+  if (!status.ok()) {
+    return status;
+  }
+  const size_t n = static_cast<size_t>(handle.size());
+  if (n == 0) {
+    *value = Slice();
+    return status;
+  }
+  scratch->resize(n);
+  status = vlog_->Read(handle.offset(), n, value, &(*scratch)[0], file_index);
+  if (status.ok()) {
+    if (value->size() != n) {
+      status = Status::Corruption("Truncated value read");
+    }
+  }
+  return status;
+}
+
 // Check if a specific key may or must not exist in one or more blocks
 // indexed by the given filter.
 bool Dir::KeyMayMatch(const Slice& key, const BlockHandle& h) {
@@ -1156,6 +1564,10 @@ Status Dir::DoList(const BlockHandle& h, uint32_t epoch, ListContext* ctx,
       opts.stats = stats;
       opts.tmp_length = ctx->tmp_length;
       opts.tmp = ctx->tmp;
+      opts.has_attr_range = ctx->has_attr_range;
+      opts.attr_lo = ctx->attr_lo;
+      opts.attr_hi = ctx->attr_hi;
+      opts.agg = ctx->agg;
       opts.saver = reinterpret_cast<Saver>(ctx->usr_cb);
       opts.arg = ctx->arg_cb;
       status = Iter(opts, table_handle);
@@ -1307,11 +1719,13 @@ void Dir::List(uint32_t epoch, ListContext* ctx) {
     rt_iter = NewRtIterator(rt_);
   }
   mu_->Unlock();
+  AggregateResult partial;  // Aggregated without holding the lock
   ListStats stats;
   stats.table_seeks = 0;  // Number of tables touched
   // Number of data blocks fetched
   stats.seeks = 0;
   stats.n = 0;
+  stats.agg = ctx->agg != NULL ? &partial : NULL;
   Status status;
   for (uint32_t dummy = epoch; dummy == epoch; dummy++) {
     std::string epoch_key = EpochKey(epoch);
@@ -1348,6 +1762,9 @@ void Dir::List(uint32_t epoch, ListContext* ctx) {
   ctx->num_table_seeks += stats.table_seeks;
   ctx->num_seeks += stats.seeks;
   ctx->n += stats.n;
+  if (ctx->agg_result != NULL) {
+    ctx->agg_result->Merge(partial);
+  }
   assert(ctx->num_open_lists > 0);
   ctx->num_open_lists--;
   bg_cv_->SignalAll();
@@ -1519,6 +1936,11 @@ Status Dir::Scan(const ScanOptions& opts, ScanStats* stats) {
   ListContext ctx;
   ctx.tmp = opts.tmp;  // User-supplied buffer space
   ctx.tmp_length = opts.tmp_length;
+  ctx.has_attr_range = opts.has_attr_range;
+  ctx.attr_lo = opts.attr_lo;
+  ctx.attr_hi = opts.attr_hi;
+  ctx.agg = opts.agg;
+  ctx.agg_result = opts.agg_result;
   ctx.num_open_lists = 0;  // Number of outstanding list operations
   ctx.status = &status;
   ctx.num_table_seeks = 0;  // Total number of tables touched
@@ -1533,12 +1955,15 @@ Status Dir::Scan(const ScanOptions& opts, ScanStats* stats) {
   }
   ctx.usr_cb = opts.usr_cb;
   ctx.arg_cb = opts.arg_cb;
+  // Items must outlive the background list operations they are passed to
+  std::vector<BGListItem> items;
   if (num_eps_ != 0) {
     uint32_t epoch = opts.epoch_start;
     uint32_t epoch_end = std::min(num_eps_, opts.epoch_end);
+    if (epoch < epoch_end) items.resize(epoch_end - epoch);
     for (; epoch < epoch_end; epoch++) {
       ctx.num_open_lists++;
-      BGListItem item;
+      BGListItem& item = items[epoch - opts.epoch_start];
       item.epoch = epoch;
       item.dir = this;
       item.ctx = &ctx;
@@ -1601,12 +2026,15 @@ Status Dir::Read(const ReadOptions& opts, const Slice& key, std::string* dst,
     ctx.rt_iter = NULL;
   }
   ctx.dst = dst;
+  // Items must outlive the background read operations they are passed to
+  std::vector<BGGetItem> items;
   if (num_eps_ != 0) {
     uint32_t epoch = opts.epoch_start;
     uint32_t epoch_end = std::min(num_eps_, opts.epoch_end);
+    if (epoch < epoch_end) items.resize(epoch_end - epoch);
     for (; epoch < epoch_end; epoch++) {
       ctx.num_open_reads++;
-      BGGetItem item;
+      BGGetItem& item = items[epoch - opts.epoch_start];
       item.epoch = epoch;
       item.dir = this;
       item.ctx = &ctx;
@@ -1662,8 +2090,13 @@ Dir::ScanOptions::ScanOptions()
     : force_serial_reads(false),
       epoch_start(0),
       epoch_end(~static_cast<uint32_t>(0)),
+      has_attr_range(false),
+      attr_lo(0),
+      attr_hi(~static_cast<uint64_t>(0)),
       usr_cb(NULL),
       arg_cb(NULL),
+      agg(NULL),
+      agg_result(NULL),
       tmp_length(0),
       tmp(NULL) {}
 
@@ -1682,6 +2115,7 @@ Dir::Dir(const DirOptions& options, port::Mutex* mu, port::CondVar* bg_cv)
       num_eps_(0),
       data_(NULL),
       indx_(NULL),
+      vlog_(NULL),
       mu_(mu),
       bg_cv_(bg_cv),
       rt_(NULL),
@@ -1691,6 +2125,7 @@ Dir::~Dir() {
   mu_->AssertHeld();
   if (data_ != NULL) data_->Unref();
   if (indx_ != NULL) indx_->Unref();
+  if (vlog_ != NULL) vlog_->Unref();
   delete rt_;
 }
 
@@ -1704,6 +2139,16 @@ void Dir::InstallDataSource(LogSource* data) {
   }
 }
 
+void Dir::InstallValueSource(LogSource* vlog) {
+  if (vlog != vlog_) {
+    if (vlog_ != NULL) vlog_->Unref();
+    vlog_ = vlog;
+    if (vlog_ != NULL) {
+      vlog_->Ref();
+    }
+  }
+}
+
 template <typename U, typename V>
 static inline bool UnMatch(U a, V b) {
   return a != static_cast<U>(b);
@@ -1720,7 +2165,9 @@ static Status VerifyOptions(const DirOptions& options, const Footer& footer) {
       UnMatch(options.epoch_log_rotation, footer.epoch_log_rotation()) ||
       UnMatch(options.skip_checksums, footer.skip_checksums()) ||
       UnMatch(options.filter, footer.filter_type()) ||
-      UnMatch(options.mode, footer.mode())) {
+      UnMatch(options.mode, footer.mode()) ||
+      UnMatch(options.value_log, footer.value_log()) ||
+      UnMatch(options.var_array_blocks, footer.var_array_blocks())) {
     return Status::AssertionFailed("Options does not match footer");
   } else {
     return Status::OK();
@@ -1731,8 +2178,10 @@ Status Dir::Open(LogSource* indx) {
   Status status;
   char tmp[Footer::kEncodedLength];
   Slice input;
-  if (indx->Size() >= sizeof(tmp)) {
-    status = indx->Read(indx->Size() - sizeof(tmp), sizeof(tmp), &input, tmp);
+  // Footers of older dirs may be shorter
+  if (indx->Size() >= Footer::kLegacyEncodedLength) {
+    const size_t n = std::min(indx->Size(), uint64_t(sizeof(tmp)));
+    status = indx->Read(indx->Size() - n, n, &input, tmp);
   } else {
     status = Status::Corruption("Dir index too short to be valid");
   }
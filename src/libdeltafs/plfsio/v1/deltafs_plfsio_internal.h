@@ -212,9 +212,11 @@ class DirIndexer {
   };
   Status Flush(const FlushOptions& options, Epoch* epoch);
 
-  // Sync and close all associated log sinks.
-  // REQUIRES: *mu_ has been locked and no on-going compactions.
-  Status SyncAndClose();
+  // Sync and close the index log only, leaving the shared data log to the
+  // caller. Does not touch any state protected by *mu_ so partitions may
+  // be closed concurrently from different threads.
+  // REQUIRES: no on-going or future compactions.
+  Status SyncAndCloseIndex();
 
   void Ref() { refs_++; }
 
@@ -341,9 +343,18 @@ class Dir {
     bool force_serial_reads;  // Do not fetch data in parallel
     uint32_t epoch_start;
     uint32_t epoch_end;
+    // Skip tables and data blocks with no values whose attributes are
+    // within [attr_lo, attr_hi]
+    bool has_attr_range;
+    uint64_t attr_lo;
+    uint64_t attr_hi;
     // User callback to handle fetched data
     void* usr_cb;
     void* arg_cb;
+    // If not NULL, fetched data is aggregated into *agg_result according
+    // to *agg instead of being passed to the user callback
+    const AggregateSpec* agg;
+    AggregateResult* agg_result;
     // Temporary storage for data blocks
     size_t tmp_length;
     char* tmp;
@@ -361,6 +372,10 @@ class Dir {
 
   void InstallDataSource(LogSource* data);
 
+  // Install the value log of the directory. Must be called before any reads
+  // if the directory stores values in a value log.
+  void InstallValueSource(LogSource* vlog);
+
   void Ref() { refs_++; }
 
   void Unref() {
@@ -405,6 +420,12 @@ class Dir {
   // Return true if the given key matches a specific filter block.
   bool KeyMayMatch(const Slice& key, const BlockHandle& h);
 
+  // Translate a value stored in a data block into the value originally
+  // inserted. Values stored in the value log are read using the given log
+  // rotation # and "*scratch". Return OK on success, or a non-OK status on
+  // errors. REQUIRES: the value log is enabled.
+  Status ReadValue(uint32_t file_index, Slice* value, std::string* scratch);
+
   // Obtain the value to a specific key from a given table.
   // If key is found, "opts.saver" will be called.
   // NOTE: "opts.saver" may be called multiple times.
@@ -461,16 +482,44 @@ class Dir {
     char* tmp;
     // Scratch size
     size_t tmp_length;
+    // Attribute range to filter tables, data blocks, and values
+    bool has_attr_range;
+    uint64_t attr_lo;
+    uint64_t attr_hi;
+    // Aggregate to compute instead of calling the saver, or NULL
+    const AggregateSpec* agg;
     // Callback for handling fetched data
     Saver saver;
     // Callback argument
     void* arg;
   };
 
+  // Decode the handle of a table data block from *input. Set *skip to true if
+  // the block holds no values within the attribute range of the scan.
+  // Return OK on success, or a non-OK status on errors.
+  Status DecodeBlockHandle(const IterOptions& opts, Slice* input,
+                           BlockHandle* handle, bool* skip);
+
   // Iterate through all keys within a given table data block whose block handle
   // is encoded as *input. Return OK on success, or a non-OK status on errors.
   Status Iter(const IterOptions& opts, Slice* input);
 
+  // Iterate through all keys within a given data block that has already been
+  // read. Takes the ownership of any heap-allocated block contents.
+  // Return OK on success, or a non-OK status on errors.
+  Status Iter(const IterOptions& opts, const BlockContents& contents);
+
+  // Aggregate all keys within a given data block that has already been read
+  // into opts.stats->agg. Takes the ownership of any heap-allocated block
+  // contents. Return OK on success, or a non-OK status on errors.
+  Status Aggregate(const IterOptions& opts, const BlockContents& contents);
+
+  // Iterate through all keys within the given data blocks of a table while
+  // reading up to options_.prefetch_blocks blocks ahead in the background.
+  // Return OK on success, or a non-OK status on errors.
+  Status IterWithPrefetch(const IterOptions& opts,
+                          const std::vector<BlockHandle>& handles);
+
   // Iterate through all keys within a given table.
   // For each key obtained, "opts.saver" will be called to save the results.
   // Return OK on success, or a non-OK status on errors.
@@ -484,6 +533,11 @@ class Dir {
     Status* status;
     char* tmp;  // Temporary storage for block contents
     size_t tmp_length;
+    bool has_attr_range;
+    uint64_t attr_lo;
+    uint64_t attr_hi;
+    const AggregateSpec* agg;
+    AggregateResult* agg_result;  // Partial results are merged into it
     size_t num_table_seeks;  // Total number of tables touched
     // Total number of data blocks fetched
     size_t num_seeks;
@@ -498,6 +552,8 @@ class Dir {
     size_t seeks;
     // Total number of keys read
     size_t n;
+    // Partial aggregate for a certain epoch, or NULL
+    AggregateResult* agg;
   };
   Status DoList(const BlockHandle& h, uint32_t epoch, ListContext* ctx,
                 ListStats* stats);
@@ -519,6 +575,7 @@ class Dir {
   uint32_t num_eps_;
   LogSource* data_;
   LogSource* indx_;
+  LogSource* vlog_;
 
   port::Mutex* mu_;
   port::CondVar* bg_cv_;
@@ -14,6 +14,8 @@
 #include "pdlfs-common/logging.h"
 #include "pdlfs-common/strutil.h"
 
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm>
 #include <vector>
 
@@ -127,6 +129,8 @@ static std::string Lpart(int sub_partition) {
 static std::string Lsuffix(LogType type) {
   if (type == kIdxIoType) {
     return ".idx";
+  } else if (type == kValIoType) {
+    return ".val";
   } else {
     return ".dat";
   }
@@ -346,6 +350,50 @@ LogSource::~LogSource() {
     delete files_[i].first;
   }
   delete[] files_;
+  free(aligned_buf_);
+}
+
+Status LogSource::ReadAligned(uint64_t offset, size_t n, Slice* result,
+                              char* scratch, size_t index) {
+  const uint64_t start = offset & ~uint64_t(kDirectIoAlignment - 1);
+  const uint64_t end =
+      (offset + n + kDirectIoAlignment - 1) & ~uint64_t(kDirectIoAlignment - 1);
+  const size_t len = static_cast<size_t>(end - start);
+  char* buf = NULL;
+  size_t buf_size = 0;
+  mu_.Lock();
+  std::swap(buf, aligned_buf_);
+  std::swap(buf_size, aligned_buf_size_);
+  mu_.Unlock();
+  if (buf_size < len) {
+    free(buf);
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, kDirectIoAlignment, len) != 0) {
+      return Status::IOError("Cannot allocate aligned buffer");
+    }
+    buf = static_cast<char*>(ptr);
+    buf_size = len;
+  }
+  Slice contents;
+  Status status = Read(start, len, &contents, buf, index);
+  if (status.ok()) {
+    const size_t skip = static_cast<size_t>(offset - start);
+    size_t m = 0;
+    if (contents.size() > skip) {
+      m = std::min(n, contents.size() - skip);
+    }
+    memcpy(scratch, contents.data() + skip, m);
+    *result = Slice(scratch, m);
+  }
+  // Keep the larger buffer for later reads
+  mu_.Lock();
+  if (aligned_buf_size_ < buf_size) {
+    std::swap(buf, aligned_buf_);
+    std::swap(buf_size, aligned_buf_size_);
+  }
+  mu_.Unlock();
+  free(buf);
+  return status;
 }
 
 // Default options for read logged data.
@@ -357,6 +405,7 @@ LogSource::LogOptions::LogOptions()
       seq_stats(NULL),
       stats(NULL),
       io_size(4096),
+      direct_io(false),
       env(Env::Default()) {}
 
 static Status OpenWithEagerSeqReads(
@@ -397,11 +446,17 @@ static Status OpenWithEagerSeqReads(
 }
 
 static Status RandomAccessOpen(
-    const std::string& filename, Env* env, RandomAccessFileStats* stats,
+    const std::string& filename, bool direct_io, Env* env,
+    RandomAccessFileStats* stats,
     std::vector<std::pair<RandomAccessFile*, uint64_t> >* result) {
   RandomAccessFile* base = NULL;
   uint64_t size = 0;
-  Status status = env->NewRandomAccessFile(filename.c_str(), &base);
+  Status status;
+  if (direct_io) {
+    status = env->NewDirectRandomAccessFile(filename.c_str(), &base);
+  } else {
+    status = env->NewRandomAccessFile(filename.c_str(), &base);
+  }
   if (status.ok()) {
     status = env->GetFileSize(filename.c_str(), &size);
     if (!status.ok()) {
@@ -417,8 +472,9 @@ static Status RandomAccessOpen(
     file = new MeasuredRandomAccessFile(stats, base);
   }
 #if VERBOSE >= 3
-  Verbose(__LOG_ARGS__, 3, "Reading from %s (random access), size=%s",
-          filename.c_str(), PrettySize(size).c_str());
+  Verbose(__LOG_ARGS__, 3, "Reading from %s (random access%s), size=%s",
+          filename.c_str(), direct_io ? ", direct i/o" : "",
+          PrettySize(size).c_str());
 #endif
   result->push_back(std::make_pair(file, size));
   return status;
@@ -431,7 +487,7 @@ static Status TryOpenIt(
     std::vector<std::pair<RandomAccessFile*, uint64_t> >* r) {
   if (opts.type == kIdxIoType)
     return OpenWithEagerSeqReads(f, opts.io_size, opts.env, opts.seq_stats, r);
-  return RandomAccessOpen(f, opts.env, opts.stats, r);
+  return RandomAccessOpen(f, opts.direct_io, opts.env, opts.stats, r);
 }
 
 Status LogSource::Open(const LogOptions& opts, const std::string& prefix,
@@ -29,7 +29,10 @@ enum LogType {
   kDefIoType = 0x00,  // Optimized for random read accesses
 
   // For index logs consisting of table indexes, filters, and other index blocks
-  kIdxIoType = 0x01  // Sequential reads expected
+  kIdxIoType = 0x01,  // Sequential reads expected
+
+  // For value logs holding values stored separately from data blocks
+  kValIoType = 0x02  // Optimized for random read accesses
 };
 
 // Log rotation types.
@@ -245,6 +248,10 @@ class LogSource {
     // Bulk read size
     size_t io_size;
 
+    // True if the log should be opened for direct I/O.
+    // Ignored for index logs
+    bool direct_io;
+
     // Low-level storage abstraction
     Env* env;
   };
@@ -266,6 +273,15 @@ class LogSource {
     return status;
   }
 
+  // Read "n" bytes at "offset" by reading the enclosing range aligned to
+  // kDirectIoAlignment into an aligned buffer, so that a file opened for
+  // direct I/O can transfer data straight into it. The requested bytes are
+  // then copied to "scratch". The aligned buffer is kept for later reads.
+  // Return OK on success, or a non-OK status on errors.
+  Status ReadAligned(uint64_t offset, size_t n, Slice* result, char* scratch,
+                     size_t index = 0);
+  static const size_t kDirectIoAlignment = 4096;
+
   // Return the size of a given file
   uint64_t Size(size_t index = 0) const {
     if (index < num_files_) {
@@ -297,7 +313,13 @@ class LogSource {
 
  private:
   LogSource(const LogOptions& opts, const std::string& p)
-      : opts_(opts), prefix_(p), files_(NULL), num_files_(0), refs_(0) {}
+      : opts_(opts),
+        prefix_(p),
+        files_(NULL),
+        num_files_(0),
+        aligned_buf_(NULL),
+        aligned_buf_size_(0),
+        refs_(0) {}
   ~LogSource();
   // No copying allowed
   void operator=(const LogSource& s);
@@ -308,6 +330,12 @@ class LogSource {
   const std::string prefix_;  // Parent directory name
   std::pair<RandomAccessFile*, uint64_t>* files_;
   size_t num_files_;
+  // An aligned buffer for ReadAligned(). A reader takes the buffer out
+  // while reading so concurrent readers never share it; those that find
+  // it taken allocate their own. Protected by mu_
+  port::Mutex mu_;
+  char* aligned_buf_;
+  size_t aligned_buf_size_;
   uint32_t refs_;
 };
 
@@ -45,6 +45,12 @@ Status LogWriter::Write(ChunkType chunk_type, const Slice& block_contents,
         compre_type = kNoCompression;
       }
       break;
+
+    default:
+      // Other codecs are not supported by directory logs
+      raw_contents = block_contents;
+      compre_type = kNoCompression;
+      break;
   }
   status = LogRaw(chunk_type, compre_type, raw_contents, handle);
   compressed_.clear();
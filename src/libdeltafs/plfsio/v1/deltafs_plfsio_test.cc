@@ -12,6 +12,7 @@
 #include "deltafs_plfsio_internal.h"
 #include "deltafs_plfsio_v1.h"
 
+#include "pdlfs-common/env_mem.h"
 #include "pdlfs-common/histogram.h"
 #include "pdlfs-common/mutexlock.h"
 #include "pdlfs-common/port.h"
@@ -109,6 +110,90 @@ TEST(WriteBufTest<>, FixedSizedValue) {
   delete iter;
 }
 
+class FooterTest {
+ public:
+  FooterTest() {
+    DirOptions options;
+    options.lg_parts = 2;
+    options.key_size = 12;
+    options.value_size = 20;
+    options.mode = kDmUniqueDrop;
+    options.value_log = true;
+    Footer footer = Mkfoot(options);
+    BlockHandle handle;
+    handle.set_offset(1000);
+    handle.set_size(200);
+    footer.set_epoch_index_handle(handle);
+    footer.set_num_epochs(7);
+    footer.EncodeTo(&encoding_);
+  }
+
+  std::string encoding_;
+};
+
+TEST(FooterTest, EncodeDecode) {
+  ASSERT_EQ(encoding_.size(), size_t(Footer::kEncodedLength));
+  Footer footer;
+  Slice input = encoding_;
+  ASSERT_OK(footer.DecodeFrom(&input));
+  ASSERT_EQ(int(footer.version()), int(Footer::kFormatVersion));
+  ASSERT_EQ(footer.lg_parts(), 2);
+  ASSERT_EQ(footer.num_epochs(), 7);
+  ASSERT_EQ(footer.key_size(), 12);
+  ASSERT_EQ(footer.value_size(), 20);
+  ASSERT_EQ(int(footer.mode()), int(kDmUniqueDrop));
+  ASSERT_EQ(int(footer.value_log()), 1);
+  ASSERT_EQ(footer.epoch_index_handle().offset(), 1000);
+  ASSERT_EQ(footer.epoch_index_handle().size(), 200);
+}
+
+// Footers written before the format version was added lack the last
+// two option bytes and the version byte.
+TEST(FooterTest, LegacyFooter) {
+  std::string legacy = encoding_.substr(0, Footer::kLegacyEncodedLength);
+  // Readers always fetch kEncodedLength bytes from the end of a file
+  std::string tail = std::string(3, 'x') + legacy;
+  Footer footer;
+  Slice input = tail;
+  ASSERT_OK(footer.DecodeFrom(&input));
+  ASSERT_EQ(int(footer.version()), 0);
+  ASSERT_EQ(footer.encoded_length(), size_t(Footer::kLegacyEncodedLength));
+  ASSERT_EQ(footer.lg_parts(), 2);
+  ASSERT_EQ(footer.num_epochs(), 7);
+  ASSERT_EQ(footer.key_size(), 12);
+  ASSERT_EQ(footer.value_size(), 20);
+  ASSERT_EQ(int(footer.mode()), int(kDmUniqueDrop));
+  ASSERT_EQ(int(footer.value_log()), 0);
+  ASSERT_EQ(int(footer.var_array_blocks()), 0);
+  input = legacy;
+  ASSERT_OK(footer.DecodeFrom(&input));
+  ASSERT_EQ(footer.num_epochs(), 7);
+}
+
+TEST(FooterTest, VarArrayBlocks) {
+  DirOptions options;
+  options.var_array_blocks = true;
+  std::string encoding;
+  Mkfoot(options).EncodeTo(&encoding);
+  Footer footer;
+  Slice input = encoding;
+  ASSERT_OK(footer.DecodeFrom(&input));
+  ASSERT_EQ(int(footer.var_array_blocks()), 1);
+  ASSERT_EQ(int(footer.value_log()), 0);
+  // Dropping the version byte must not leave a footer that still
+  // decodes with the new flags read from the wrong offsets
+  encoding.resize(encoding.size() - 1);
+  input = encoding;
+  ASSERT_TRUE(!footer.DecodeFrom(&input).ok());
+}
+
+TEST(FooterTest, UnknownVersion) {
+  encoding_[encoding_.size() - 1] = char(Footer::kFormatVersion + 1);
+  Footer footer;
+  Slice input = encoding_;
+  ASSERT_TRUE(footer.DecodeFrom(&input).IsNotSupported());
+}
+
 class PlfsIoTest {
  public:
   PlfsIoTest() {
@@ -267,6 +352,215 @@ TEST(PlfsIoTest, MultiEpoch) {
   ASSERT_EQ(Count(3), 0);
 }
 
+TEST(PlfsIoTest, MemEnv) {
+  Env* const env = NewMemEnv(Env::Default());
+  options_.env = env;
+  Append("k1", "v1");
+  Append("k2", "v2");
+  MakeEpoch();
+  Append("k1", "v3");
+  MakeEpoch();
+  ASSERT_EQ(Read("k1"), "v1v3");
+  ASSERT_EQ(Read("k2"), "v2");
+  ASSERT_EQ(Scan(-1), "v1v2v3");
+  uint64_t usage;
+  ASSERT_OK(MemEnvUsage(env, &usage));
+  ASSERT_TRUE(usage != 0);
+  ASSERT_TRUE(env->FileExists(dirname_.c_str()));
+  delete reader_;
+  reader_ = NULL;
+  delete env;
+}
+
+TEST(PlfsIoTest, DirectIoReads) {
+  options_.direct_io_reads = true;
+  options_.compression = kSnappyCompression;
+  options_.force_compression = true;
+  char tmp[100];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(tmp, sizeof(tmp), "k%d", i);
+    Append(tmp, std::string(200, 'a' + i % 26));
+  }
+  MakeEpoch();
+  for (int i = 0; i < 1000; i += 97) {
+    snprintf(tmp, sizeof(tmp), "k%d", i);
+    ASSERT_EQ(Read(tmp), std::string(200, 'a' + i % 26));
+  }
+  ASSERT_EQ(Count(0), 1000);
+}
+
+TEST(PlfsIoTest, PrefetchScan) {
+  ThreadPool* const pool = ThreadPool::NewFixed(2);
+  options_.reader_pool = pool;
+  options_.prefetch_blocks = 3;
+  options_.block_size = 256;
+  options_.block_util = 0.5;
+  std::string expected;
+  char tmp[100];
+  for (int e = 0; e < 2; e++) {
+    for (int i = 0; i < 500; i++) {
+      snprintf(tmp, sizeof(tmp), "k%03d", i);
+      std::string value(20, 'a' + (i + e) % 26);
+      Append(tmp, value);
+    }
+    MakeEpoch();
+  }
+  std::string scanned = Scan(0);
+  ASSERT_EQ(scanned.size(), 500 * 20);
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(scanned.substr(i * 20, 20), std::string(20, 'a' + i % 26));
+  }
+  ASSERT_EQ(Scan(-1).size(), 2 * 500 * 20);
+  ASSERT_EQ(Read("k042"), std::string(20, 'a' + 42 % 26) +
+                              std::string(20, 'a' + 43 % 26));
+  delete reader_;
+  reader_ = NULL;
+  delete pool;
+}
+
+// Scans run on the same pool as their block prefetches and outnumber
+// the threads of the pool.
+TEST(PlfsIoTest, PrefetchParallelScan) {
+  ThreadPool* const pool = ThreadPool::NewFixed(2);
+  options_.reader_pool = pool;
+  options_.parallel_reads = true;
+  options_.prefetch_blocks = 3;
+  options_.block_size = 256;
+  options_.block_util = 0.5;
+  char tmp[100];
+  for (int e = 0; e < 4; e++) {
+    for (int i = 0; i < 500; i++) {
+      snprintf(tmp, sizeof(tmp), "k%03d", i);
+      Append(tmp, std::string(20, 'a' + (i + e) % 26));
+    }
+    MakeEpoch();
+  }
+  ASSERT_EQ(Scan(-1).size(), 4 * 500 * 20);
+  ASSERT_EQ(Scan(-1).size(), 4 * 500 * 20);
+  delete reader_;
+  reader_ = NULL;
+  delete pool;
+}
+
+TEST(PlfsIoTest, ParallelFinish) {
+  ThreadPool* const pool = ThreadPool::NewFixed(4);
+  options_.compaction_pool = pool;
+  options_.total_memtable_budget = 4 << 20;
+  options_.lg_parts = 2;
+  char tmp[20];
+  for (int i = 0; i < 200; i++) {
+    snprintf(tmp, sizeof(tmp), "k%d", i);
+    Append(tmp, tmp);
+  }
+  MakeEpoch();
+  ASSERT_OK(writer_->Finish());
+  FinishStats stats = writer_->TEST_finish_stats();
+  ASSERT_TRUE(stats.total_micros >= stats.finalize_micros);
+  ASSERT_TRUE(stats.finalize_micros >= stats.index_close_micros);
+  ASSERT_TRUE(stats.index_close_micros >= stats.data_close_micros);
+  Finish();  // Idempotent
+  for (int i = 0; i < 200; i++) {
+    snprintf(tmp, sizeof(tmp), "k%d", i);
+    ASSERT_EQ(Read(tmp), tmp);
+  }
+  delete reader_;
+  reader_ = NULL;
+  delete pool;
+}
+
+static bool EvenKey(void* arg, const Slice& key, const Slice& value) {
+  return (DecodeFixed32(key.data()) & 1) == 0;
+}
+
+TEST(PlfsIoTest, Aggregate) {
+  ThreadPool* const pool = ThreadPool::NewFixed(2);
+  options_.reader_pool = pool;
+  options_.parallel_reads = true;
+  for (int e = 0; e < 3; e++) {
+    for (uint32_t i = 0; i < 100; i++) {
+      char k[4];
+      EncodeFixed32(k, i);
+      char v[12];
+      EncodeFixed32(v, 0);
+      EncodeFixed64(v + 4, 1000 * e + i);
+      Append(Slice(k, 4), Slice(v, 12));
+    }
+    MakeEpoch();
+  }
+  Finish();
+  OpenReader();
+  DirReader::ScanOp op;
+  AggregateSpec spec;
+  spec.field_offset = 4;
+  spec.field_size = 8;
+  spec.bucket_limits.push_back(999);
+  spec.bucket_limits.push_back(1999);
+  AggregateResult result;
+  ASSERT_OK(reader_->Aggregate(op, spec, &result));
+  ASSERT_EQ(result.count, 300);
+  ASSERT_EQ(result.min, 0);
+  ASSERT_EQ(result.max, 2099);
+  ASSERT_EQ(result.sum, 3 * 4950 + 100 * 1000 + 100 * 2000);
+  ASSERT_EQ(result.buckets.size(), 3);
+  ASSERT_EQ(result.buckets[0], 100);
+  ASSERT_EQ(result.buckets[1], 100);
+  ASSERT_EQ(result.buckets[2], 100);
+  op.SetEpoch(1);
+  spec.predicate = EvenKey;
+  ASSERT_OK(reader_->Aggregate(op, spec, &result));
+  ASSERT_EQ(result.count, 50);
+  ASSERT_EQ(result.min, 1000);
+  ASSERT_EQ(result.max, 1098);
+  spec.field_size = 3;
+  ASSERT_TRUE(reader_->Aggregate(op, spec, &result).IsInvalidArgument());
+  delete reader_;
+  reader_ = NULL;
+  delete pool;
+}
+
+TEST(PlfsIoTest, AggregateArrayBlockFmt) {
+  options_.leveldb_compatible = false;
+  options_.fixed_kv_length = true;
+  options_.key_size = 4;
+  options_.value_size = 4;
+  for (uint32_t i = 0; i < 1000; i++) {
+    char k[4];
+    EncodeFixed32(k, i);
+    char v[4];
+    EncodeFixed16(v, 0);
+    EncodeFixed16(v + 2, i % 500);
+    Append(Slice(k, 4), Slice(v, 4));
+  }
+  MakeEpoch();
+  Finish();
+  OpenReader();
+  DirReader::ScanOp op;
+  size_t n = 0;
+  op.n = &n;
+  AggregateSpec spec;
+  spec.field_offset = 2;
+  spec.field_size = 2;
+  AggregateResult result;
+  ASSERT_OK(reader_->Aggregate(op, spec, &result));
+  ASSERT_EQ(n, 1000);
+  ASSERT_EQ(result.count, 1000);
+  ASSERT_EQ(result.min, 0);
+  ASSERT_EQ(result.max, 499);
+  ASSERT_EQ(result.sum, 2 * 124750);
+  spec.field_size = 0;
+  spec.predicate = EvenKey;
+  ASSERT_OK(reader_->Aggregate(op, spec, &result));
+  ASSERT_EQ(result.count, 500);
+  ASSERT_EQ(n, 500);
+  // Fields that do not fit in the values are not aggregated
+  spec.predicate = NULL;
+  spec.field_offset = 2;
+  spec.field_size = 4;
+  ASSERT_OK(reader_->Aggregate(op, spec, &result));
+  ASSERT_EQ(result.count, 0);
+  ASSERT_EQ(n, 0);
+}
+
 TEST(PlfsIoTest, ArrayBlockFmt) {
   options_.leveldb_compatible = false;
   options_.fixed_kv_length = true;
@@ -293,6 +587,52 @@ TEST(PlfsIoTest, ArrayBlockFmt) {
   ASSERT_EQ(Count(3), 0);
 }
 
+TEST(PlfsIoTest, VarArrayBlockFmt) {
+  options_.leveldb_compatible = false;
+  options_.var_array_blocks = true;
+  options_.block_size = 256;
+  char tmp[20];
+  for (int i = 0; i < 200; i++) {
+    snprintf(tmp, sizeof(tmp), "k%0*d", 1 + i % 7, i);
+    Append(tmp, std::string(i % 13, 'v'));
+  }
+  MakeEpoch();
+  Append("k1", "v1");
+  Append("k22", "v222");
+  MakeEpoch();
+  for (int i = 0; i < 200; i++) {
+    snprintf(tmp, sizeof(tmp), "k%0*d", 1 + i % 7, i);
+    std::string expected(i % 13, 'v');
+    if (strcmp(tmp, "k1") == 0) expected += "v1";
+    if (strcmp(tmp, "k22") == 0) expected += "v222";
+    ASSERT_EQ(Read(tmp), expected);
+  }
+  ASSERT_TRUE(Read("k").empty());
+  ASSERT_TRUE(Read("k1.1").empty());
+  ASSERT_TRUE(Read("z").empty());
+  ASSERT_EQ(Scan(1), "v1v222");
+  ASSERT_EQ(Count(0), 200);
+  ASSERT_EQ(Count(1), 2);
+}
+
+TEST(PlfsIoTest, UnorderedWithVarArrayBlockFmt) {
+  options_.mode = kDmUniqueUnordered;
+  options_.leveldb_compatible = false;
+  options_.var_array_blocks = true;
+  Append("k2", "v2");
+  Append("k1", "v1");
+  MakeEpoch();
+  Append("k1", "v3");
+  Append("k22", "v4");
+  MakeEpoch();
+  ASSERT_EQ(Read("k1"), "v1v3");
+  ASSERT_TRUE(Read("k1.1").empty());
+  ASSERT_EQ(Read("k2"), "v2");
+  ASSERT_EQ(Read("k22"), "v4");
+  ASSERT_EQ(Scan(0), "v2v1");
+  ASSERT_EQ(Scan(1), "v3v4");
+}
+
 TEST(PlfsIoTest, Unordered) {
   options_.mode = kDmUniqueUnordered;
   Append("k2", "v2");
@@ -391,6 +731,46 @@ TEST(PlfsIoTest, Snappy2) {
   ASSERT_EQ(Count(3), 0);
 }
 
+TEST(PlfsIoTest, ParallelCompression) {
+  ThreadPool* const pool = ThreadPool::NewFixed(4, true);
+  options_.compression_pool = pool;
+  options_.compression = kSnappyCompression;
+  options_.force_compression = true;
+  const int num_keys = 16 << 10;
+  char tmp[20];
+  for (int epoch = 0; epoch < 2; epoch++) {
+    for (int i = 0; i < num_keys; i++) {
+      snprintf(tmp, sizeof(tmp), "k%07d", i);
+      std::string value(32, 'a' + (i + epoch) % 26);
+      Append(Slice(tmp), value);
+    }
+    MakeEpoch();
+  }
+  for (int i = 0; i < num_keys; i += 7) {
+    snprintf(tmp, sizeof(tmp), "k%07d", i);
+    std::string expected(32, 'a' + i % 26);
+    expected.append(32, 'a' + (i + 1) % 26);
+    ASSERT_EQ(Read(Slice(tmp)), expected) << tmp;
+  }
+  ASSERT_TRUE(Read("kx").empty());
+  ASSERT_EQ(Count(0), num_keys);
+  ASSERT_EQ(Count(1), num_keys);
+  delete pool;
+}
+
+TEST(PlfsIoTest, SharedCompressionPool) {
+  ThreadPool* const pool = ThreadPool::NewFixed(2, true);
+  DirOptions options = options_;
+  options.compaction_pool = pool;
+  options.compression_pool = pool;
+  options.compression = kSnappyCompression;
+  DirWriter* writer = NULL;
+  Status s = DirWriter::Open(options, dirname_, &writer);
+  ASSERT_TRUE(s.IsInvalidArgument());
+  ASSERT_TRUE(writer == NULL);
+  delete pool;
+}
+
 TEST(PlfsIoTest, LargeBatch) {
   const std::string dummy_val(32, 'x');
   const int batch_size = 64 << 10;
@@ -457,6 +837,139 @@ TEST(PlfsIoTest, LogRotation) {
   Finish();
 }
 
+TEST(PlfsIoTest, ValueLog) {
+  options_.value_log = true;
+  options_.value_log_threshold = 64;
+  const std::string v1(100, 'x');
+  const std::string v2(1000, 'y');
+  Append("k1", "v1");
+  Append("k2", v1);
+  MakeEpoch();
+  Append("k1", v2);
+  Append("k2", "v2");
+  Append("k3", v1);
+  MakeEpoch();
+  ASSERT_EQ(writer_->TEST_value_log_bytes(), 2 * v1.size() + v2.size());
+  ASSERT_EQ(Read("k1"), "v1" + v2);
+  ASSERT_EQ(Read("k2"), v1 + "v2");
+  ASSERT_EQ(Read("k3"), v1);
+  ASSERT_TRUE(Read("k4").empty());
+  ASSERT_EQ(Scan(0), "v1" + v1);
+  ASSERT_EQ(Scan(1), v2 + "v2" + v1);
+  ASSERT_EQ(Count(0), 2);
+  ASSERT_EQ(Count(1), 3);
+}
+
+TEST(PlfsIoTest, ValueLogRotation) {
+  options_.value_log = true;
+  options_.value_log_threshold = 16;
+  options_.epoch_log_rotation = true;
+  const std::string v1(32, 'x');
+  const std::string v2(64, 'y');
+  Append("k1", v1);
+  MakeEpoch();
+  Append("k1", v2);
+  MakeEpoch();
+  Append("k1", "v3");
+  MakeEpoch();
+  ASSERT_EQ(Read("k1"), v1 + v2 + "v3");
+  ASSERT_EQ(Scan(1), v2);
+}
+
+// Use the first byte of each value as its attribute.
+static bool FirstByteAttr(void* arg, const Slice& key, const Slice& value,
+                          uint64_t* attr) {
+  if (value.empty()) return false;
+  *attr = static_cast<unsigned char>(value[0]);
+  return true;
+}
+
+TEST(PlfsIoTest, AttrRangeScan) {
+  options_.attr_extractor = FirstByteAttr;
+  options_.block_size = 256;
+  char tmp[20];
+  for (int i = 0; i < 200; i++) {
+    snprintf(tmp, sizeof(tmp), "k%04d", i);
+    Append(tmp, std::string(1, char('a' + i / 40)) + std::string(15, 'x'));
+  }
+  MakeEpoch();
+  Append("k0000", "zzzz");
+  MakeEpoch();
+  if (writer_ != NULL) Finish();
+  if (reader_ == NULL) OpenReader();
+  size_t seeks = 0, table_seeks = 0;
+  std::string tmp_all;
+  SaverState state;
+  state.tmp = &tmp_all;
+  DirReader::ScanOp op;
+  op.seeks = &seeks;
+  op.table_seeks = &table_seeks;
+  ASSERT_OK(reader_->Scan(op, SaveValue, &state));
+  ASSERT_EQ(tmp_all.size(), 200 * 16 + 4);
+  const size_t all_seeks = seeks;
+  ASSERT_EQ(table_seeks, 2);
+  std::string tmp_c;
+  state.tmp = &tmp_c;
+  op.SetAttrRange('c', 'c');
+  ASSERT_OK(reader_->Scan(op, SaveValue, &state));
+  ASSERT_EQ(tmp_c.size(), 40 * 16);
+  for (size_t i = 0; i < tmp_c.size(); i += 16) ASSERT_EQ(tmp_c[i], 'c');
+  ASSERT_TRUE(seeks < all_seeks);
+  ASSERT_EQ(table_seeks, 1);  // The second epoch is skipped
+  std::string tmp_z;
+  state.tmp = &tmp_z;
+  op.SetAttrRange('z', 'z');
+  ASSERT_OK(reader_->Scan(op, SaveValue, &state));
+  ASSERT_EQ(tmp_z, "zzzz");
+  ASSERT_EQ(seeks, 1);
+  ASSERT_EQ(table_seeks, 1);
+}
+
+TEST(PlfsIoTest, MultiRankRead) {
+  options_.summary_bits_per_key = 10;
+  const int num_ranks = 4;
+  char tmp[20];
+  DestroyDir(dirname_, options_);
+  for (int r = 0; r < num_ranks; r++) {
+    options_.rank = r;
+    // Odd ranks overflow the summary key buffer
+    options_.summary_max_keys = (r % 2) ? 32 : 0;
+    ASSERT_OK(DirWriter::Open(options_, dirname_, &writer_));
+    for (int i = 0; i < 100; i++) {
+      snprintf(tmp, sizeof(tmp), "r%d-k%03d", r, i);
+      ASSERT_OK(writer_->Add(tmp, tmp, 0));
+    }
+    ASSERT_OK(writer_->EpochFlush(0));
+    Finish();
+  }
+  options_.rank = 0;
+  for (int merged = 0; merged < 2; merged++) {
+    if (merged) ASSERT_OK(MergeDirSummaries(dirname_, options_, num_ranks));
+    MultiDirReader* reader;
+    ASSERT_OK(MultiDirReader::Open(options_, dirname_, num_ranks, &reader));
+    size_t total_probes = 0;
+    size_t probes;
+    MultiDirReader::ReadOp op;
+    op.rank_probes = &probes;
+    for (int r = 0; r < num_ranks; r++) {
+      for (int i = 0; i < 100; i++) {
+        std::string dst;
+        snprintf(tmp, sizeof(tmp), "r%d-k%03d", r, i);
+        ASSERT_OK(reader->Read(op, tmp, &dst));
+        ASSERT_EQ(dst, tmp);
+        ASSERT_TRUE(probes >= 1);
+        total_probes += probes;
+      }
+    }
+    // Without summaries every lookup would probe all ranks
+    ASSERT_TRUE(total_probes < 2 * num_ranks * 100);
+    std::string dst;
+    ASSERT_OK(reader->Read(op, "non-exists", &dst));
+    ASSERT_TRUE(dst.empty());
+    delete reader;
+  }
+}
+
 TEST(PlfsIoTest, MultiMap) {
   options_.mode = kDmMultiMap;
   Append("k1", "v1");
@@ -764,6 +1277,7 @@ class PlfsIoBench {
     options_.skip_sort = ordered_keys_ != 0;
     options_.leveldb_compatible = GetOption("LEVELDB_FMT", true) != 0;
     options_.fixed_kv_length = GetOption("FIXED_KV", true) != 0;
+    options_.var_array_blocks = GetOption("VAR_ARRAY", false) != 0;
     options_.compression =
         GetOption("SNAPPY", false) ? kSnappyCompression : kNoCompression;
     options_.index_compression =
@@ -1126,6 +1640,12 @@ class PlfsIoBench {
             options_.block_padding ? "Yes" : "No");
     fprintf(stderr, "                 TB Fmt: %s\n",
             options_.leveldb_compatible ? "SST" : "CUSTOM");
+    if (!options_.leveldb_compatible) {
+      fprintf(stderr, "                Blk Fmt: %s\n",
+              options_.fixed_kv_length    ? "FIXED ARRAY"
+              : options_.var_array_blocks ? "VAR ARRAY"
+                                          : "SORTED STRING");
+    }
     fprintf(stderr, "                FT Type: %s\n", ToString(options_.filter));
     fprintf(stderr, "          FT Mem Budget: %d (bits per key)\n",
             int(options_.filter_bits_per_key));
@@ -1559,6 +2079,7 @@ static void BM_Usage() {
   fprintf(stderr, "ORDERED_KEYS\n");
   fprintf(stderr, "LEVELDB_FMT\n");
   fprintf(stderr, "FIXED_KV\n");
+  fprintf(stderr, "VAR_ARRAY\n");
   fprintf(stderr, "VALUE_SIZE\n");
   fprintf(stderr, "KEY_SIZE\n");
   fprintf(stderr, "\n");
@@ -12,6 +12,7 @@
 #include "pdlfs-common/logging.h"
 #include "pdlfs-common/strutil.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -20,6 +21,46 @@ namespace plfsio {
 
 IoStats::IoStats() : index_bytes(0), index_ops(0), data_bytes(0), data_ops(0) {}
 
+FinishStats::FinishStats()
+    : flush_micros(0),
+      compaction_micros(0),
+      data_close_micros(0),
+      index_close_micros(0),
+      finalize_micros(0),
+      total_micros(0) {}
+
+AggregateSpec::AggregateSpec()
+    : predicate(NULL), predicate_arg(NULL), field_offset(0), field_size(0) {}
+
+AggregateResult::AggregateResult()
+    : count(0), min(~static_cast<uint64_t>(0)), max(0), sum(0) {}
+
+void AggregateResult::Add(const AggregateSpec& spec, uint64_t value) {
+  count++;
+  if (value < min) min = value;
+  if (value > max) max = value;
+  sum += value;
+  if (!spec.bucket_limits.empty()) {
+    if (buckets.empty()) buckets.resize(spec.bucket_limits.size() + 1, 0);
+    buckets[std::lower_bound(spec.bucket_limits.begin(),
+                             spec.bucket_limits.end(), value) -
+            spec.bucket_limits.begin()]++;
+  }
+}
+
+void AggregateResult::Merge(const AggregateResult& other) {
+  count += other.count;
+  if (other.min < min) min = other.min;
+  if (other.max > max) max = other.max;
+  sum += other.sum;
+  if (buckets.size() < other.buckets.size()) {
+    buckets.resize(other.buckets.size(), 0);
+  }
+  for (size_t i = 0; i < other.buckets.size(); i++) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
 DirOptions::DirOptions()
     : total_memtable_budget(4 << 20),
       memtable_util(0.97),
@@ -27,11 +68,18 @@ DirOptions::DirOptions()
       leveldb_compatible(true),
       skip_sort(false),
       fixed_kv_length(false),
+      var_array_blocks(false),
       key_size(8),
       value_size(32),
+      value_log(false),
+      value_log_threshold(256),
+      attr_extractor(NULL),
+      attr_extractor_arg(NULL),
       filter(kFtBloomFilter),
       filter_bits_per_key(0),
       bf_bits_per_key(8),
+      summary_bits_per_key(0),
+      summary_max_keys(4 << 20),
       bm_fmt(kFmtUncompressed),
       bm_key_bits(24),
       cuckoo_seed(301),
@@ -48,9 +96,12 @@ DirOptions::DirOptions()
       epoch_log_rotation(false),
       tail_padding(false),
       compaction_pool(NULL),
+      compression_pool(NULL),
       reader_pool(NULL),
       read_size(8 << 20),
       parallel_reads(false),
+      direct_io_reads(false),
+      prefetch_blocks(0),
       paranoid_checks(false),
       ignore_filters(false),
       compression(kNoCompression),
@@ -238,6 +289,14 @@ DirOptions ParseDirOptions(const char* input) {
       if (ParseBool(conf_key, conf_value, &flag)) {
         result.parallel_reads = flag;
       }
+    } else if (conf_key == "direct_io_reads") {
+      if (ParseBool(conf_key, conf_value, &flag)) {
+        result.direct_io_reads = flag;
+      }
+    } else if (conf_key == "prefetch_blocks") {
+      if (ParseInteger(conf_key, conf_value, &num)) {
+        result.prefetch_blocks = num;
+      }
     } else if (conf_key == "paranoid_checks") {
       if (ParseBool(conf_key, conf_value, &flag)) {
         result.paranoid_checks = flag;
@@ -254,6 +313,10 @@ DirOptions ParseDirOptions(const char* input) {
       if (ParseBool(conf_key, conf_value, &flag)) {
         result.fixed_kv_length = flag;
       }
+    } else if (conf_key == "var_array_blocks") {
+      if (ParseBool(conf_key, conf_value, &flag)) {
+        result.var_array_blocks = flag;
+      }
     } else if (conf_key == "leveldb_compatible") {
       if (ParseBool(conf_key, conf_value, &flag)) {
         result.leveldb_compatible = flag;
@@ -270,6 +333,14 @@ DirOptions ParseDirOptions(const char* input) {
       if (ParseInteger(conf_key, conf_value, &num)) {
         result.bf_bits_per_key = num;
       }
+    } else if (conf_key == "summary_bits_per_key") {
+      if (ParseInteger(conf_key, conf_value, &num)) {
+        result.summary_bits_per_key = num;
+      }
+    } else if (conf_key == "summary_max_keys") {
+      if (ParseInteger(conf_key, conf_value, &num)) {
+        result.summary_max_keys = num;
+      }
     } else if (conf_key == "bm_fmt") {
       if (ParseBitmapFormat(conf_key, conf_value, &bm_fmt)) {
         result.bm_fmt = bm_fmt;
@@ -294,6 +365,14 @@ DirOptions ParseDirOptions(const char* input) {
       if (ParseInteger(conf_key, conf_value, &num)) {
         result.value_size = num;
       }
+    } else if (conf_key == "value_log") {
+      if (ParseBool(conf_key, conf_value, &flag)) {
+        result.value_log = flag;
+      }
+    } else if (conf_key == "value_log_threshold") {
+      if (ParseInteger(conf_key, conf_value, &num)) {
+        result.value_log_threshold = num;
+      }
     } else if (conf_key == "key_size") {
       if (ParseInteger(conf_key, conf_value, &num)) {
         result.key_size = num;
@@ -15,6 +15,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 namespace pdlfs {
 namespace plfsio {
@@ -36,6 +37,78 @@ struct IoStats {
   uint64_t data_ops;
 };
 
+// Time spent in each phase of DirWriter::Finish(), in microseconds.
+struct FinishStats {
+  FinishStats();
+
+  // Scheduling the final memtable compaction
+  uint64_t flush_micros;
+  // Waiting for all outstanding compactions to finish
+  uint64_t compaction_micros;
+  // Writing the footer, and syncing and closing the shared data and
+  // value logs
+  uint64_t data_close_micros;
+  // Syncing and closing the index logs of all partitions. These run in
+  // the background and overlap the footer write.
+  uint64_t index_close_micros;
+  // Finalizing the directory as a whole
+  uint64_t finalize_micros;
+  // The entire Finish() call
+  uint64_t total_micros;
+};
+
+// Select the key-value pairs to include in an aggregate. Return true to
+// include a pair. May be called concurrently from different reader threads.
+typedef bool (*AggPredicate)(void* arg, const Slice& key, const Slice& value);
+
+// A simple aggregate to compute over the key-value pairs of a scan. Each
+// value is treated as a record holding an unsigned little-endian integer
+// field of "field_size" bytes at "field_offset".
+struct AggregateSpec {
+  AggregateSpec();
+
+  // Only include pairs for which "predicate" returns true.
+  // Set to NULL to include all pairs.
+  // Default: NULL
+  AggPredicate predicate;
+  void* predicate_arg;
+
+  // Byte offset of the field within each value.
+  // Default: 0
+  size_t field_offset;
+
+  // Size of the field in bytes. Must be 0, 1, 2, 4, or 8.
+  // Set to 0 to only count pairs. Pairs whose values are too short to
+  // hold the field are ignored.
+  // Default: 0
+  size_t field_size;
+
+  // Inclusive upper limits of the histogram buckets in ascending order.
+  // A final bucket holds all larger field values.
+  // Leave empty to skip the histogram.
+  // Default: empty
+  std::vector<uint64_t> bucket_limits;
+};
+
+struct AggregateResult {
+  AggregateResult();
+
+  // Include a field value in the result.
+  void Add(const AggregateSpec& spec, uint64_t value);
+
+  // Combine the result of another set of pairs into this result.
+  void Merge(const AggregateResult& other);
+
+  // Total number of pairs included
+  uint64_t count;
+  // Min, max, and sum of the field. Undefined if count is 0
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  // Number of field values in each histogram bucket
+  std::vector<uint64_t> buckets;
+};
+
 // Directory semantics
 enum DirMode {
   // Each epoch is structured as a set of ordered multi-maps.
@@ -81,6 +154,13 @@ enum BitmapFormat {
   kFmtPfDelta = 0x06
 };
 
+// Extract a fixed-width numeric attribute from a value. Store the attribute
+// in *attr and return true, or return false if the value has no attribute.
+// Signed or floating-point attributes should be mapped to an
+// order-preserving unsigned integer.
+typedef bool (*AttrExtractor)(void* arg, const Slice& key, const Slice& value,
+                              uint64_t* attr);
+
 struct DirOptions {
   DirOptions();
 
@@ -113,6 +193,13 @@ struct DirOptions {
   // Default: false
   bool fixed_kv_length;
 
+  // Store variable-length key-value pairs in array blocks indexed by an
+  // offset table instead of prefix-compressed blocks. Point lookups then
+  // binary search all entries of a block without decoding shared prefixes.
+  // Ignored if "fixed_kv_length" or "leveldb_compatible" is ON.
+  // Default: false
+  bool var_array_blocks;
+
   // Estimated key size.
   // If not known, keep the default.
   // Default: 8 bytes
@@ -123,6 +210,30 @@ struct DirOptions {
   // Default: 32 bytes
   size_t value_size;
 
+  // Store large values in a separate value log instead of inlining them in
+  // data blocks. Data blocks then only hold a pointer to each such value, so
+  // compactions move fewer bytes and point lookups read smaller blocks.
+  // Ignored if "fixed_kv_length" is ON.
+  // Default: false
+  bool value_log;
+
+  // Values no smaller than this are written to the value log.
+  // This option is only used when the value log is enabled.
+  // Default: 256 bytes
+  size_t value_log_threshold;
+
+  // Build a secondary range index on a numeric attribute of each value.
+  // When set, the smallest and the largest attribute of each data block and
+  // each table are kept in the indexes so scans restricted to an attribute
+  // range can skip blocks and tables that cannot match. Readers may set it
+  // too in order to filter individual values.
+  // Default: NULL
+  AttrExtractor attr_extractor;
+
+  // Argument passed to the attribute extractor.
+  // Default: NULL
+  void* attr_extractor_arg;
+
   // Filter type to be applied to directory storage.
   // Default: kFtBloomFilter
   FilterType filter;
@@ -140,6 +251,25 @@ struct DirOptions {
   // Default: 8 bits
   size_t bf_bits_per_key;
 
+  // Bits per key of the rank-level key summary written at Finish().
+  // The summary is a bloom filter over all keys ever inserted by a rank
+  // and allows readers to find the ranks that may hold a key without
+  // opening every rank. Per-rank summaries may be merged into a single
+  // job-level summary using MergeDirSummaries().
+  // Set to 0 to disable rank summaries.
+  // Default: 0 bit
+  size_t summary_bits_per_key;
+
+  // Max number of keys a rank buffers for its key summary. Key hashes are
+  // buffered in memory (4 bytes per key) so that the summary can be sized
+  // to the number of distinct keys at Finish(). Once this many keys are
+  // buffered, the summary switches to a fixed-size bloom filter sized for
+  // this many keys and further keys are added to it as they arrive. The
+  // false positive rate of the summary then grows with the number of keys
+  // beyond this limit. Set to 0 to buffer keys without a limit.
+  // Default: 4M keys
+  size_t summary_max_keys;
+
   // Storage format used to encoding the bitmap filter.
   // This option is only used when bitmap filter is enabled.
   // Default: kFmtUncompressed
@@ -226,6 +356,15 @@ struct DirOptions {
   // Default: NULL
   ThreadPool* compaction_pool;
 
+  // Thread pool used to compress data blocks in the background. Blocks
+  // finished by a compaction are compressed in parallel and then written out
+  // in their original order. Only used when compression is enabled. Must not
+  // be the same pool as the compaction pool since compactions wait for
+  // their blocks to be compressed.
+  // If set to NULL, data blocks are compressed by the compaction itself.
+  // Default: NULL
+  ThreadPool* compression_pool;
+
   // Thread pool used to run concurrent background reads.
   // If set to NULL, Env::Default() may be used to schedule reads if permitted.
   // Otherwise, the caller's thread context will be used directly.
@@ -243,6 +382,21 @@ struct DirOptions {
   // Default: false
   bool parallel_reads;
 
+  // Set to true to read data blocks with direct I/O, bypassing the OS page
+  // cache. Block reads are then widened to the enclosing aligned range so the
+  // underlying file can serve them without an extra copy. Useful for large
+  // data logs that are read only once. Index logs are still read normally.
+  // Default: false
+  bool direct_io_reads;
+
+  // Number of data blocks to read ahead of a scan. Block reads are issued
+  // through reader_pool, or Env::Default() if allow_env_threads is true,
+  // so that storage i/o overlaps with block decoding and user callbacks.
+  // Set to 0 to read each block only when the scan reaches it.
+  // Ignored if neither reader_pool nor env threads are available.
+  // Default: 0
+  size_t prefetch_blocks;
+
   // Perform aggressive checking of the data so we stop early on errors.
   // Default: false
   bool paranoid_checks;
@@ -18,6 +18,7 @@
 #include "pdlfs-common/mutexlock.h"
 #include "pdlfs-common/strutil.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -35,12 +36,25 @@ struct DirWriter::Rep {
   Status MaybeRotateLogs(Epoch*);
   Status TryFlush(Epoch*, bool ef = false, bool fi = false);
   Status TryAdd(Epoch*, const Slice& fid, const Slice& data);
+  Status SeparateValue(const Slice& key, const Slice& data,
+                       std::string* result);
   Status EnsureDataPadding(LogSink* sink, size_t footer_size);
   Status InstallDirInfo(const std::string& footer);
+  void AddToSummary(uint32_t hash);
+  Status WriteSummary();
   Status Finalize();
 
+  // Sync and close the index log of a single partition in the background.
+  struct BGCloseItem {
+    Rep* rep;
+    DirIndexer* idxer;
+  };
+  static void BGClose(void*);
+  void ScheduleIndexClose(BGCloseItem* item);
+
   const DirOptions options_;
-  mutable port::Mutex io_mutex_;  // Protecting the shared data log
+  mutable port::Mutex io_mutex_;    // Protecting the shared data log
+  mutable port::Mutex vlog_mutex_;  // Protecting the value log
   mutable port::Mutex mutex_;
   port::CondVar bg_cv_;
   port::CondVar cv_;
@@ -51,9 +65,26 @@ struct DirWriter::Rep {
   Epoch* epoch_;   // Current epoch
   bool finished_;  // If Finish() has been called
   WritableFileStats io_stats_;
+  WritableFileStats vlog_io_stats_;
   const DirOutputStats** compac_stats_;
   DirIndexer** idxers_;
   LogSink* data_;
+  // NULL if the value log is disabled. Writes to it are protected by
+  // vlog_mutex_ so that writers do not hold mutex_ during value log I/O
+  LogSink* vlog_;
+  // Total size of values stored in the value log. Protected by vlog_mutex_
+  uint64_t vlog_bytes_;
+  // Bloom hashes of all keys inserted so far. Used to build the rank summary.
+  // Empty if rank summaries are disabled. Protected by mutex_
+  std::vector<uint32_t> key_hashes_;
+  // Fixed-size rank summary used once key_hashes_ reaches the summary key
+  // limit. NULL before that. Protected by mutex_
+  BloomBlock* summary_;
+  // Number of partition index logs still being closed in the background
+  // and the first error seen. Protected by mutex_
+  uint32_t num_bg_closes_;
+  Status bg_close_status_;
+  FinishStats finish_stats_;  // Protected by mutex_
   Env* env_;
 };
 
@@ -69,6 +100,10 @@ DirWriter::Rep::Rep(const DirOptions& o, const std::string& d)
       compac_stats_(NULL),
       idxers_(NULL),
       data_(NULL),
+      vlog_(NULL),
+      vlog_bytes_(0),
+      summary_(NULL),
+      num_bg_closes_(0),
       env_(options_.env) {
   epoch_ = new Epoch(0, &mutex_);
   epoch_->Ref();
@@ -87,6 +122,10 @@ DirWriter::Rep::~Rep() {
   if (data_ != NULL) {
     data_->Unref();
   }
+  if (vlog_ != NULL) {
+    vlog_->Unref();
+  }
+  delete summary_;
 }
 
 Status DirWriter::Rep::EnsureDataPadding(LogSink* sink, size_t footer_size) {
@@ -121,6 +160,12 @@ Status DirWriter::Rep::MaybeRotateLogs(Epoch* ep) {
     status = data_->Lrotate(1 + ep->seq_);
     data_->Unlock();
     mutex_.Lock();
+    // Values of the next epoch go to a new value log as well
+    if (status.ok() && vlog_ != NULL) {
+      vlog_->Lock();
+      status = vlog_->Lrotate(1 + ep->seq_);
+      vlog_->Unlock();
+    }
   }
 
   return status;
@@ -165,6 +210,61 @@ Status DirWriter::Rep::InstallDirInfo(const std::string& footer) {
   return status;
 }
 
+// Insert the bloom hash of a key into the rank summary. Hashes are buffered
+// until the summary key limit is reached, after which they go into a
+// fixed-size bloom filter so that memory usage stays bounded.
+// REQUIRES: mutex_ has been locked.
+void DirWriter::Rep::AddToSummary(uint32_t hash) {
+  mutex_.AssertHeld();
+  if (summary_ != NULL) {
+    summary_->AddHash(hash);
+    return;
+  }
+  key_hashes_.push_back(hash);
+  const size_t limit = options_.summary_max_keys;
+  if (limit != 0 && key_hashes_.size() >= limit) {
+    DirOptions bf_opts = options_;
+    bf_opts.bf_bits_per_key = options_.summary_bits_per_key;
+    summary_ = new BloomBlock(bf_opts, 0);
+    summary_->Reset(static_cast<uint32_t>(limit));
+    for (size_t i = 0; i < key_hashes_.size(); i++) {
+      summary_->AddHash(key_hashes_[i]);
+    }
+    std::vector<uint32_t>().swap(key_hashes_);  // Release memory
+  }
+}
+
+// Write a bloom filter over all keys inserted by this rank to a dedicated
+// summary file. The filter is followed by a masked crc32c of its contents.
+// REQUIRES: mutex_ has been locked.
+Status DirWriter::Rep::WriteSummary() {
+  mutex_.AssertHeld();
+  std::string contents;
+  if (summary_ != NULL) {
+    contents = summary_->Finish().ToString();
+    delete summary_;
+    summary_ = NULL;
+  } else {
+    // Keys may be inserted multiple times across epochs
+    std::sort(key_hashes_.begin(), key_hashes_.end());
+    key_hashes_.erase(std::unique(key_hashes_.begin(), key_hashes_.end()),
+                      key_hashes_.end());
+    DirOptions bf_opts = options_;
+    bf_opts.bf_bits_per_key = options_.summary_bits_per_key;
+    BloomBlock bf(bf_opts, 0);
+    bf.Reset(static_cast<uint32_t>(key_hashes_.size()));
+    for (size_t i = 0; i < key_hashes_.size(); i++) {
+      bf.AddHash(key_hashes_[i]);
+    }
+    contents = bf.Finish().ToString();
+    std::vector<uint32_t>().swap(key_hashes_);  // Release memory
+  }
+  PutFixed32(&contents,
+             crc32c::Mask(crc32c::Value(contents.data(), contents.size())));
+  return WriteStringToFileSync(
+      env_, contents, RankSummaryFileName(dirname_, options_.rank).c_str());
+}
+
 // REQUIRES: mutex_ has been locked and no on-going compactions.
 Status DirWriter::Rep::Finalize() {
   mutex_.AssertHeld();
@@ -180,9 +280,23 @@ Status DirWriter::Rep::Finalize() {
   footer.set_epoch_index_handle(dummy_handle);
   footer.set_num_epochs(max_epochs);
 
-  Status status;
   std::string ftdata;
   footer.EncodeTo(&ftdata);
+
+  // Index logs are per-partition and are no longer written once compactions
+  // have stopped, so sync and close them in the background while we write the
+  // footer and close the shared logs below.
+  const uint64_t idx_start = env_->NowMicros();
+  std::vector<BGCloseItem> items(num_parts_);
+  bg_close_status_ = Status::OK();
+  for (uint32_t i = 0; i < num_parts_; i++) {
+    items[i].rep = this;
+    items[i].idxer = idxers_[i];
+    ScheduleIndexClose(&items[i]);
+  }
+
+  const uint64_t data_start = env_->NowMicros();
+  Status status;
   if (options_.tail_padding) {
     status = EnsureDataPadding(data_, ftdata.size());
   }
@@ -190,17 +304,36 @@ Status DirWriter::Rep::Finalize() {
   if (status.ok()) {
     data_->Lock();
     status = data_->Lwrite(ftdata);
+    if (status.ok()) {
+      status = data_->Lclose(true);
+    }
     data_->Unlock();
   }
 
-  if (status.ok()) {
-    for (uint32_t i = 0; i < num_parts_; i++) {
-      status = idxers_[i]->SyncAndClose();
-      if (!status.ok()) {
-        break;
-      }
+  if (status.ok() && vlog_ != NULL) {
+    if (options_.tail_padding) {
+      status = EnsureDataPadding(vlog_, 0);
+    }
+    if (status.ok()) {
+      vlog_->Lock();
+      status = vlog_->Lclose(true);
+      vlog_->Unlock();
     }
   }
+  finish_stats_.data_close_micros = env_->NowMicros() - data_start;
+
+  // Always wait since items are allocated on our stack
+  while (num_bg_closes_ != 0) {
+    bg_cv_.Wait();
+  }
+  finish_stats_.index_close_micros = env_->NowMicros() - idx_start;
+  if (status.ok()) {
+    status = bg_close_status_;
+  }
+
+  if (status.ok() && options_.summary_bits_per_key != 0) {
+    status = WriteSummary();
+  }
 
   // Write out our primary footer copy
   if (status.ok()) {
@@ -212,6 +345,35 @@ Status DirWriter::Rep::Finalize() {
   return status;
 }
 
+void DirWriter::Rep::ScheduleIndexClose(BGCloseItem* item) {
+  mutex_.AssertHeld();
+  if (options_.compaction_pool != NULL) {
+    num_bg_closes_++;
+    options_.compaction_pool->Schedule(BGClose, item);
+  } else if (options_.allow_env_threads) {
+    num_bg_closes_++;
+    Env::Default()->Schedule(BGClose, item);
+  } else {
+    Status s = item->idxer->SyncAndCloseIndex();
+    if (bg_close_status_.ok()) {
+      bg_close_status_ = s;
+    }
+  }
+}
+
+void DirWriter::Rep::BGClose(void* arg) {
+  BGCloseItem* const item = reinterpret_cast<BGCloseItem*>(arg);
+  Status s = item->idxer->SyncAndCloseIndex();
+  Rep* const r = item->rep;
+  MutexLock ml(&r->mutex_);
+  if (r->bg_close_status_.ok()) {
+    r->bg_close_status_ = s;
+  }
+  assert(r->num_bg_closes_ > 0);
+  r->num_bg_closes_--;
+  r->bg_cv_.SignalAll();
+}
+
 Status DirWriter::Rep::ObtainCompactionStatus() {
   mutex_.AssertHeld();
   Status status;
@@ -254,10 +416,68 @@ Status DirWriter::Rep::TryAdd(Epoch* ep, const Slice& fid, const Slice& data) {
   mutex_.AssertHeld();
   assert(ep->num_ongoing_ops_ != 0);
   Status status;
+  if (options_.summary_bits_per_key != 0) {
+    AddToSummary(BloomHash(fid));
+  }
   const uint32_t hash = Hash(fid.data(), fid.size(), 0);
   const uint32_t part = hash & part_mask_;
   assert(part < num_parts_);
-  status = idxers_[part]->Add(ep, fid, data);
+  if (vlog_ != NULL) {
+    std::string value;
+    // Value log I/O goes without mutex_. The epoch cannot be committed
+    // while this op is ongoing so the value log is not rotated or closed.
+    mutex_.Unlock();
+    status = SeparateValue(fid, data, &value);
+    mutex_.Lock();
+    if (status.ok()) {
+      status = idxers_[part]->Add(ep, fid, value);
+    }
+  } else {
+    status = idxers_[part]->Add(ep, fid, data);
+  }
+  return status;
+}
+
+// Prepare the value to be inserted into the memtable for a given piece of
+// data. Data no smaller than the value log threshold is appended to the value
+// log and replaced by a handle to it. Smaller data is kept inline. Either is
+// prefixed with its value type. Return OK on success, or a non-OK status on
+// errors.
+// REQUIRES: mutex_ has NOT been locked.
+Status DirWriter::Rep::SeparateValue(const Slice& key, const Slice& data,
+                                     std::string* result) {
+  assert(vlog_ != NULL);
+  Status status;
+  result->clear();
+  if (data.size() >= options_.value_log_threshold) {
+    // Physical offset is used since the value log may be rotated
+    BlockHandle handle;
+    vlog_->Lock();  // Ptell() and Lwrite() must go as an atomic operation
+    handle.set_offset(vlog_->Ptell());
+    handle.set_size(data.size());
+    status = vlog_->Lwrite(data);
+    if (status.ok()) {
+      vlog_mutex_.AssertHeld();  // vlog_->Lock() takes vlog_mutex_
+      vlog_bytes_ += data.size();
+    }
+    vlog_->Unlock();
+    if (status.ok()) {
+      result->push_back(static_cast<char>(kValuePointer));
+      handle.EncodeTo(result);
+      // Keep the attribute of the value next to its handle so the secondary
+      // range index can be built without reading the value log
+      uint64_t attr;
+      if (options_.attr_extractor != NULL &&
+          options_.attr_extractor(options_.attr_extractor_arg, key, data,
+                                  &attr)) {
+        PutVarint64(result, attr);
+      }
+    }
+  } else {
+    result->reserve(1 + data.size());
+    result->push_back(static_cast<char>(kValueInline));
+    result->append(data.data(), data.size());
+  }
   return status;
 }
 
@@ -335,9 +555,35 @@ Status DirWriter::Finish() {
       while (cur->num_ongoing_ops_ != 0) {
         cur->cv_.Wait();
       }
+      FinishStats* const stats = &r->finish_stats_;
+      const uint64_t start = r->env_->NowMicros();
       status = r->TryFlush(cur, true /*epoch flush*/, true /*finalize*/);
-      if (status.ok()) status = r->WaitForCompaction();
-      if (status.ok()) status = r->Finalize();
+      uint64_t now = r->env_->NowMicros();
+      stats->flush_micros = now - start;
+      if (status.ok()) {
+        status = r->WaitForCompaction();
+        const uint64_t then = now;
+        now = r->env_->NowMicros();
+        stats->compaction_micros = now - then;
+      }
+      if (status.ok()) {
+        status = r->Finalize();
+        const uint64_t then = now;
+        now = r->env_->NowMicros();
+        stats->finalize_micros = now - then;
+      }
+      stats->total_micros = now - start;
+#if VERBOSE >= 3
+      Verbose(__LOG_ARGS__, 3,
+              "Finish: flush %llu us, compaction %llu us, data %llu us, "
+              "index %llu us, finalize %llu us, total %llu us",
+              static_cast<unsigned long long>(stats->flush_micros),
+              static_cast<unsigned long long>(stats->compaction_micros),
+              static_cast<unsigned long long>(stats->data_close_micros),
+              static_cast<unsigned long long>(stats->index_close_micros),
+              static_cast<unsigned long long>(stats->finalize_micros),
+              static_cast<unsigned long long>(stats->total_micros));
+#endif
       r->finish_status_ = status;
       r->finished_ = true;
       r->epoch_ = NULL;
@@ -488,6 +734,11 @@ Status DirWriter::Sync() {
   sink->Lock();
   status = sink->Lsync();
   sink->Unlock();
+  if (status.ok() && r->vlog_ != NULL) {
+    r->vlog_->Lock();
+    status = r->vlog_->Lsync();
+    r->vlog_->Unlock();
+  }
   if (status.ok()) {
     for (uint32_t part = 0; part < r->num_parts_; part++) {
       status = r->idxers_[part]->indx_->Lsync();
@@ -509,9 +760,17 @@ IoStats DirWriter::TEST_iostats() const {
   }
   result.data_bytes = r->io_stats_.TotalBytes();
   result.data_ops = r->io_stats_.TotalOps();
+  result.data_bytes += r->vlog_io_stats_.TotalBytes();
+  result.data_ops += r->vlog_io_stats_.TotalOps();
   return result;
 }
 
+FinishStats DirWriter::TEST_finish_stats() const {
+  Rep* const r = rep_;
+  MutexLock ml(&r->mutex_);
+  return r->finish_stats_;
+}
+
 uint64_t DirWriter::TEST_estimated_sstable_size() const {
   Rep* const r = rep_;
   MutexLock ml(&r->mutex_);
@@ -577,6 +836,12 @@ uint64_t DirWriter::TEST_total_memory_usage() const {
   MutexLock ml(&r->mutex_);
   uint64_t result = 0;
   result += r->data_->memory_usage();
+  if (r->vlog_ != NULL) {
+    MutexLock vl(&r->vlog_mutex_);
+    result += r->vlog_->memory_usage();
+  }
+  result += r->key_hashes_.capacity() * sizeof(uint32_t);
+  if (r->summary_ != NULL) result += r->summary_->memory_usage();
   for (size_t i = 0; i < r->num_parts_; i++)
     result += r->idxers_[i]->indx_->memory_usage();
   for (size_t i = 0; i < r->num_parts_; i++)
@@ -624,6 +889,12 @@ uint64_t DirWriter::TEST_value_bytes() const {
   return result;
 }
 
+uint64_t DirWriter::TEST_value_log_bytes() const {
+  Rep* const r = rep_;
+  MutexLock ml(&r->vlog_mutex_);
+  return r->vlog_bytes_;
+}
+
 uint64_t DirWriter::TEST_key_bytes() const {
   Rep* const r = rep_;
   MutexLock ml(&r->mutex_);
@@ -662,6 +933,9 @@ static DirOptions SanitizeWriteOptions(const DirOptions& options) {
   if (result.data_buffer < result.min_data_buffer) {
     result.data_buffer = result.min_data_buffer;
   }
+  if (result.fixed_kv_length) {  // Values must be stored as-is
+    result.value_log = false;
+  }
   if (result.env == NULL) {
     result.env = Env::Default();
   }
@@ -743,6 +1017,7 @@ Status DirWriter::TryOpen(Rep* rep) {
   std::vector<DirIndexer*> diridxers(num_parts, NULL);
   std::vector<LogSink*> index(num_parts, NULL);
   std::vector<LogSink*> data(1, NULL);  // Shared among all partitions
+  LogSink* vlog = NULL;                 // Shared among all partitions
   std::vector<const DirOutputStats*> output_stats;
   LogSink::LogOptions io_opts;
   io_opts.rank = my_rank;
@@ -754,6 +1029,13 @@ Status DirWriter::TryOpen(Rep* rep) {
   io_opts.max_buf = options->data_buffer;
   io_opts.env = env;
   status = LogSink::Open(io_opts, rep->dirname_, &data[0]);
+  if (status.ok() && options->value_log) {
+    LogSink::LogOptions val_opts = io_opts;
+    val_opts.type = kValIoType;
+    if (options->measure_writes) val_opts.stats = &rep->vlog_io_stats_;
+    val_opts.mu = &rep->vlog_mutex_;
+    status = LogSink::Open(val_opts, rep->dirname_, &vlog);
+  }
   if (status.ok()) {
     for (size_t i = 0; i < num_parts; i++) {
       diridxers[i] =
@@ -790,6 +1072,10 @@ Status DirWriter::TryOpen(Rep* rep) {
     }
     rep->data_ = data[0];
     rep->data_->Ref();
+    rep->vlog_ = vlog;
+    if (rep->vlog_ != NULL) {
+      rep->vlog_->Ref();
+    }
     rep->compac_stats_ = compac_stats;
     rep->part_mask_ = num_parts - 1;
     rep->num_parts_ = num_parts;
@@ -805,6 +1091,9 @@ Status DirWriter::TryOpen(Rep* rep) {
       }
     }
   }
+  if (vlog != NULL) {
+    vlog->Unref();
+  }
 
   return status;
 }
@@ -828,10 +1117,21 @@ Status DirWriter::Open(const DirOptions& _opts, const std::string& dirname,
           int(options.skip_sort) ? "Yes" : "No");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.fixed_kv_length -> %s",
           int(options.fixed_kv_length) ? "Yes" : "No");
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.var_array_blocks -> %s",
+          int(options.var_array_blocks) ? "Yes" : "No");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.key_size -> %s",
           PrettySize(options.key_size).c_str());
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.value_size -> %s",
           PrettySize(options.value_size).c_str());
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.value_log -> %s (threshold=%s)",
+          int(options.value_log) ? "Yes" : "No",
+          PrettySize(options.value_log_threshold).c_str());
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.summary_bits_per_key -> %d",
+          int(options.summary_bits_per_key));
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.summary_max_keys -> %d",
+          int(options.summary_max_keys));
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.attr_extractor -> %s",
+          options.attr_extractor != NULL ? "Set" : "Not set");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.filter -> %s",
           FilterOptions(options).c_str());
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.filter_bits_per_key -> %d",
@@ -858,6 +1158,10 @@ Status DirWriter::Open(const DirOptions& _opts, const std::string& dirname,
           options.compaction_pool != NULL
               ? options.compaction_pool->ToDebugString().c_str()
               : "None");
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.compression_pool -> %s",
+          options.compression_pool != NULL
+              ? options.compression_pool->ToDebugString().c_str()
+              : "None");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.compression -> %s",
           options.compression == kSnappyCompression ? "Snappy" : "None");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.index_compression -> %s",
@@ -881,6 +1185,14 @@ Status DirWriter::Open(const DirOptions& _opts, const std::string& dirname,
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.my_rank -> %d", options.rank);
 #endif
 
+  // Compactions wait for their blocks to be compressed. With a shared pool,
+  // compactions may take every thread and leave none to compress.
+  if (options.compression_pool != NULL &&
+      options.compression_pool == options.compaction_pool) {
+    return Status::InvalidArgument(
+        "Compression pool must not be the compaction pool");
+  }
+
   Rep* rep = new Rep(options, dirname);
   Status status = TryOpen(rep);
   if (status.ok()) {
@@ -900,10 +1212,14 @@ class DirReaderImpl : public DirReader {
   virtual Status Count(const CountOp& op, size_t* result);
   virtual Status Read(const ReadOp& op, const Slice& fid, std::string* dst);
   virtual Status Scan(const ScanOp& op, ScanSaver, void*);
+  virtual Status Aggregate(const ScanOp& op, const AggregateSpec& spec,
+                           AggregateResult* result);
 
   virtual IoStats TEST_iostats() const;
 
  private:
+  Status DoScan(const ScanOp& op, ScanSaver saver, void* arg,
+                const AggregateSpec* spec, AggregateResult* result);
   Status OpenDir(size_t part);
   RandomAccessFileStats io_stats_;
   friend class DirReader;
@@ -918,6 +1234,7 @@ class DirReaderImpl : public DirReader {
   // Lazily initialized directory partitions
   Dir** dirs_;
   LogSource* data_;
+  LogSource* vlog_;  // NULL if the value log is disabled
 };
 
 DirReaderImpl::DirReaderImpl(const DirOptions& opts, const std::string& name)
@@ -927,7 +1244,8 @@ DirReaderImpl::DirReaderImpl(const DirOptions& opts, const std::string& name)
       part_mask_(~static_cast<uint32_t>(0)),
       cond_cv_(&mutex_),
       dirs_(NULL),
-      data_(NULL) {}
+      data_(NULL),
+      vlog_(NULL) {}
 
 DirReaderImpl::~DirReaderImpl() {
   MutexLock ml(&mutex_);
@@ -940,6 +1258,9 @@ DirReaderImpl::~DirReaderImpl() {
   if (data_ != NULL) {
     data_->Unref();
   }
+  if (vlog_ != NULL) {
+    vlog_->Unref();
+  }
 }
 
 // Open a directory partition if it has not been opened before.
@@ -968,6 +1289,7 @@ Status DirReaderImpl::OpenDir(size_t part) {
     mutex_.Lock();
     if (status.ok()) {
       dir->InstallDataSource(data_);
+      dir->InstallValueSource(vlog_);
       if (dirs_[part] != NULL) dirs_[part]->Unref();
       dirs_[part] = dir;
       dirs_[part]->Ref();
@@ -1013,9 +1335,26 @@ Status DirReaderImpl::Count(const CountOp& op, size_t* result) {
   return status;
 }
 
-// Perform a scan operation on all partitions.
-// Return OK on success, or a non-OK status on errors.
 Status DirReaderImpl::Scan(const ScanOp& op, ScanSaver saver, void* arg) {
+  return DoScan(op, saver, arg, NULL, NULL);
+}
+
+Status DirReaderImpl::Aggregate(const ScanOp& op, const AggregateSpec& spec,
+                                AggregateResult* result) {
+  *result = AggregateResult();
+  if (spec.field_size != 0 && spec.field_size != 1 && spec.field_size != 2 &&
+      spec.field_size != 4 && spec.field_size != 8) {
+    return Status::InvalidArgument("Bad aggregate field size");
+  }
+  return DoScan(op, NULL, NULL, &spec, result);
+}
+
+// Perform a scan operation on all partitions. Pairs are either passed
+// to "saver" or aggregated into *result if "spec" is not NULL.
+// Return OK on success, or a non-OK status on errors.
+Status DirReaderImpl::DoScan(const ScanOp& op, ScanSaver saver, void* arg,
+                             const AggregateSpec* spec,
+                             AggregateResult* result) {
   Status status;
   MutexLock ml(&mutex_);
   Dir::ScanStats stats;
@@ -1033,9 +1372,14 @@ Status DirReaderImpl::Scan(const ScanOp& op, ScanSaver saver, void* arg) {
       opts.epoch_start = op.epoch_start;
       opts.epoch_end = op.epoch_end;
       opts.force_serial_reads = op.no_parallel_reads;
+      opts.has_attr_range = op.has_attr_range;
+      opts.attr_lo = op.attr_lo;
+      opts.attr_hi = op.attr_hi;
       Dir::Saver dir_saver = static_cast<Dir::Saver>(saver);
       opts.usr_cb = reinterpret_cast<void*>(dir_saver);
       opts.arg_cb = arg;
+      opts.agg = spec;
+      opts.agg_result = result;
       char tmp[256];  // Temporary buffer space for the read operation
       opts.tmp_length = sizeof(tmp);
       opts.tmp = tmp;
@@ -1148,6 +1492,9 @@ void DirReader::ReadOp::SetEpoch(int epoch) {
 DirReader::ScanOp::ScanOp()
     : epoch_start(0),
       epoch_end(~static_cast<uint32_t>(0)),
+      has_attr_range(false),
+      attr_lo(0),
+      attr_hi(~static_cast<uint64_t>(0)),
       no_parallel_reads(false),
       table_seeks(NULL),
       seeks(NULL),
@@ -1161,6 +1508,13 @@ void DirReader::ScanOp::SetEpoch(int epoch) {
   }
 }
 
+void DirReader::ScanOp::SetAttrRange(uint64_t lo, uint64_t hi) {
+  assert(lo <= hi);
+  has_attr_range = true;
+  attr_lo = lo;
+  attr_hi = hi;
+}
+
 DirReader::~DirReader() {}
 
 // Return the name of the filter for printing.
@@ -1209,6 +1563,13 @@ static DirOptions MaybeRewriteOptions(  // Only a subset of options are checked
   if (result.mode != origin.mode)
     Warn(__LOG_ARGS__, "Dfs.plfsdir.mode -> %s (was %s)",
          DirModeName(result.mode).c_str(), DirModeName(origin.mode).c_str());
+  if (result.value_log != origin.value_log)
+    Warn(__LOG_ARGS__, "Dfs.plfsdir.value_log -> %s (was %s)",
+         result.value_log ? "Yes" : "No", origin.value_log ? "Yes" : "No");
+  if (result.var_array_blocks != origin.var_array_blocks)
+    Warn(__LOG_ARGS__, "Dfs.plfsdir.var_array_blocks -> %s (was %s)",
+         result.var_array_blocks ? "Yes" : "No",
+         origin.var_array_blocks ? "Yes" : "No");
   if (result.num_epochs != origin.num_epochs)
     Warn(__LOG_ARGS__, "Dfs.plfsdir.num_epochs -> %d (was %d)",
          result.num_epochs, origin.num_epochs);
@@ -1250,6 +1611,10 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
           PrettySize(options.read_size).c_str());
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.parallel_reads -> %s",
           int(options.parallel_reads) ? "Yes" : "No");
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.direct_io_reads -> %s",
+          int(options.direct_io_reads) ? "Yes" : "No");
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.prefetch_blocks -> %d",
+          int(options.prefetch_blocks));
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.paranoid_checks -> %s",
           int(options.paranoid_checks) ? "Yes" : "No");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.ignore_filters -> %s",
@@ -1268,6 +1633,8 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
           int(options.is_env_pfs) ? "Yes" : "No");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.mode -> %s",
           DirModeName(options.mode).c_str());
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.value_log -> %s",
+          int(options.value_log) ? "Yes" : "No");
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.num_epochs -> %d", options.num_epochs);
   Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.memtable_parts -> %d (lg_parts=%d)",
           int(num_parts), options.lg_parts);
@@ -1284,7 +1651,7 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
     status = ReadFileToString(env, DirInfoFileName(dirname).c_str(), &dir_info);
     if (!status.ok()) {
       return status;
-    } else if (dir_info.size() < Footer::kEncodedLength) {
+    } else if (dir_info.size() < Footer::kLegacyEncodedLength) {
       return Status::Corruption("Truncated dir info");
     }
     // Get rid of the padding
@@ -1310,19 +1677,25 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
   io_opts.sub_partition = -1;  // The data file does not have any sub-partitions
   if (options.epoch_log_rotation) io_opts.num_rotas = options.num_epochs + 1;
   if (options.measure_reads) io_opts.stats = &impl->io_stats_;
+  io_opts.direct_io = options.direct_io_reads;
   io_opts.env = env;
   status = LogSource::Open(io_opts, dirname, &data);
   if (!status.ok()) {
     // Error
-  } else if (data->Size(data->LastFileIndex()) < Footer::kEncodedLength) {
+  } else if (data->Size(data->LastFileIndex()) <
+             Footer::kLegacyEncodedLength) {
     status = Status::Corruption("Data log too short to be valid");
   } else if (options.paranoid_checks) {
     // Also verify the replicated footer if requested
     Slice contents;
     char tmp[Footer::kEncodedLength];
-    uint64_t off = data->Size(data->LastFileIndex()) - Footer::kEncodedLength;
-    status = data->Read(off, Footer::kEncodedLength, &contents, tmp,
-                        data->LastFileIndex());
+    const size_t n = footer.encoded_length();
+    if (data->Size(data->LastFileIndex()) < n) {
+      status = Status::Corruption("Data log too short to be valid");
+    } else {
+      uint64_t off = data->Size(data->LastFileIndex()) - n;
+      status = data->Read(off, n, &contents, tmp, data->LastFileIndex());
+    }
     if (status.ok()) {
       if (!Slice(dir_info).ends_with(contents)) {
         status = Status::Corruption("Footer replica corrupted");
@@ -1330,6 +1703,13 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
     }
   }
 
+  LogSource* vlog = NULL;
+  if (status.ok() && options.value_log) {
+    LogSource::LogOptions val_opts = io_opts;
+    val_opts.type = kValIoType;
+    status = LogSource::Open(val_opts, dirname, &vlog);
+  }
+
   if (status.ok()) {
     // Dir indexes to be fetched later
     impl->dirs_ = new Dir*[num_parts]();
@@ -1337,6 +1717,10 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
     impl->num_parts_ = num_parts;
     impl->data_ = data;
     impl->data_->Ref();
+    impl->vlog_ = vlog;
+    if (impl->vlog_ != NULL) {
+      impl->vlog_->Ref();
+    }
 
     *result = impl;
   } else {
@@ -1346,6 +1730,241 @@ Status DirReader::Open(const DirOptions& _opts, const std::string& dirname,
   if (data != NULL) {
     data->Unref();
   }
+  if (vlog != NULL) {
+    vlog->Unref();
+  }
+
+  return status;
+}
+
+// Load the bloom filter of a rank summary into *filter. Set *filter to
+// empty if the rank has no summary so that it will be probed for every key.
+// Return OK on success, or a non-OK status on errors.
+static Status ReadRankSummary(Env* env, const std::string& dirname, int rank,
+                              std::string* filter) {
+  filter->clear();
+  const std::string fname = RankSummaryFileName(dirname, rank);
+  if (!env->FileExists(fname.c_str())) {
+    return Status::OK();
+  }
+  std::string contents;
+  Status status = ReadFileToString(env, fname.c_str(), &contents);
+  if (!status.ok()) {
+    return status;
+  } else if (contents.size() < 4) {
+    return Status::Corruption("Rank summary too short", fname);
+  }
+  const size_t n = contents.size() - 4;
+  const uint32_t crc = crc32c::Unmask(DecodeFixed32(&contents[n]));
+  if (crc32c::Value(contents.data(), n) != crc) {
+    return Status::Corruption("Rank summary checksum mismatch", fname);
+  }
+  contents.resize(n);
+  filter->swap(contents);
+  return status;
+}
+
+// The job-level summary stores the filter of each rank as a length-prefixed
+// slice, followed by the number of ranks and a masked crc32c of all
+// preceding contents.
+Status MergeDirSummaries(const std::string& dirname, const DirOptions& opts,
+                         int num_ranks) {
+  Env* const env = opts.env != NULL ? opts.env : Env::Default();
+  Status status;
+  std::string contents;
+  std::string filter;
+  for (int rank = 0; rank < num_ranks; rank++) {
+    status = ReadRankSummary(env, dirname, rank, &filter);
+    if (!status.ok()) {
+      return status;
+    }
+    PutLengthPrefixedSlice(&contents, filter);
+  }
+  PutFixed32(&contents, static_cast<uint32_t>(num_ranks));
+  PutFixed32(&contents,
+             crc32c::Mask(crc32c::Value(contents.data(), contents.size())));
+  return WriteStringToFileSync(env, contents,
+                               DirSummaryFileName(dirname).c_str());
+}
+
+// Load the job-level summary. Return NotFound if there is no such summary.
+static Status ReadDirSummary(Env* env, const std::string& dirname,
+                             int num_ranks, std::vector<std::string>* filters) {
+  const std::string fname = DirSummaryFileName(dirname);
+  if (!env->FileExists(fname.c_str())) {
+    return Status::NotFound(fname);
+  }
+  std::string contents;
+  Status status = ReadFileToString(env, fname.c_str(), &contents);
+  if (!status.ok()) {
+    return status;
+  } else if (contents.size() < 8) {
+    return Status::Corruption("Dir summary too short", fname);
+  }
+  const size_t n = contents.size() - 4;
+  const uint32_t crc = crc32c::Unmask(DecodeFixed32(&contents[n]));
+  if (crc32c::Value(contents.data(), n) != crc) {
+    return Status::Corruption("Dir summary checksum mismatch", fname);
+  }
+  if (DecodeFixed32(&contents[n - 4]) != static_cast<uint32_t>(num_ranks)) {
+    return Status::InvalidArgument("Dir summary rank count mismatch", fname);
+  }
+  Slice input(contents.data(), n - 4);
+  Slice filter;
+  filters->clear();
+  for (int rank = 0; rank < num_ranks; rank++) {
+    if (!GetLengthPrefixedSlice(&input, &filter)) {
+      return Status::Corruption("Bad dir summary", fname);
+    }
+    filters->push_back(filter.ToString());
+  }
+  return status;
+}
+
+class MultiDirReaderImpl : public MultiDirReader {
+ public:
+  MultiDirReaderImpl(const DirOptions& opts, const std::string& name,
+                     int num_ranks);
+  virtual ~MultiDirReaderImpl();
+
+  virtual Status Read(const ReadOp& op, const Slice& fid, std::string* dst);
+
+ private:
+  Status OpenRank(int rank, DirReader** result);
+  friend class MultiDirReader;
+
+  DirOptions options_;
+  const std::string name_;
+  const int num_ranks_;
+
+  port::Mutex mutex_;
+  // Summary filter of each rank. Empty if the rank has no summary
+  std::vector<std::string> filters_;
+  // Lazily opened ranks
+  std::vector<DirReader*> readers_;
+};
+
+MultiDirReaderImpl::MultiDirReaderImpl(const DirOptions& opts,
+                                       const std::string& name, int num_ranks)
+    : options_(opts),
+      name_(name),
+      num_ranks_(num_ranks),
+      filters_(num_ranks),
+      readers_(num_ranks, static_cast<DirReader*>(NULL)) {}
+
+MultiDirReaderImpl::~MultiDirReaderImpl() {
+  for (size_t i = 0; i < readers_.size(); i++) {
+    delete readers_[i];
+  }
+}
+
+Status MultiDirReaderImpl::OpenRank(int rank, DirReader** result) {
+  MutexLock ml(&mutex_);
+  Status status;
+  if (readers_[rank] == NULL) {
+    DirOptions options = options_;
+    options.rank = rank;
+    status = DirReader::Open(options, name_, &readers_[rank]);
+  }
+  *result = readers_[rank];
+  return status;
+}
+
+Status MultiDirReaderImpl::Read(const ReadOp& op, const Slice& fid,
+                                std::string* dst) {
+  Status status;
+  size_t rank_probes = 0;
+  size_t table_seeks = 0;
+  size_t seeks = 0;
+  for (int rank = 0; rank < num_ranks_; rank++) {
+    const std::string& filter = filters_[rank];
+    if (!filter.empty() && !BloomKeyMayMatch(fid, filter)) {
+      continue;  // The rank does not have the key
+    }
+    DirReader* reader;
+    status = OpenRank(rank, &reader);
+    if (!status.ok()) {
+      break;
+    }
+    DirReader::ReadOp rop;
+    rop.epoch_start = op.epoch_start;
+    rop.epoch_end = op.epoch_end;
+    rop.no_parallel_reads = op.no_parallel_reads;
+    size_t rank_table_seeks = 0;
+    size_t rank_seeks = 0;
+    rop.table_seeks = &rank_table_seeks;
+    rop.seeks = &rank_seeks;
+    status = reader->Read(rop, fid, dst);
+    if (!status.ok()) {
+      break;
+    }
+    table_seeks += rank_table_seeks;
+    seeks += rank_seeks;
+    rank_probes++;
+  }
+
+  if (status.ok()) {
+    if (op.rank_probes != NULL) {
+      *op.rank_probes = rank_probes;
+    }
+    if (op.table_seeks != NULL) {
+      *op.table_seeks = table_seeks;
+    }
+    if (op.seeks != NULL) {
+      *op.seeks = seeks;
+    }
+  }
+
+  return status;
+}
+
+MultiDirReader::ReadOp::ReadOp()
+    : epoch_start(0),
+      epoch_end(~static_cast<uint32_t>(0)),
+      no_parallel_reads(false),
+      rank_probes(NULL),
+      table_seeks(NULL),
+      seeks(NULL) {}
+
+void MultiDirReader::ReadOp::SetEpoch(int epoch) {
+  assert(epoch >= -1);
+  if (epoch != -1) {
+    epoch_start = static_cast<uint32_t>(epoch);
+    epoch_end = epoch_start + 1;
+  }
+}
+
+MultiDirReader::~MultiDirReader() {}
+
+Status MultiDirReader::Open(const DirOptions& _opts, const std::string& dirname,
+                            int num_ranks, MultiDirReader** result) {
+  *result = NULL;
+  DirOptions options = _opts;
+  if (options.env == NULL) options.env = Env::Default();
+  Env* const env = options.env;
+  MultiDirReaderImpl* impl =
+      new MultiDirReaderImpl(options, dirname, num_ranks);
+  Status status = ReadDirSummary(env, dirname, num_ranks, &impl->filters_);
+  if (status.IsNotFound()) {  // Fall back to per-rank summaries
+    status = Status::OK();
+    for (int rank = 0; rank < num_ranks; rank++) {
+      status = ReadRankSummary(env, dirname, rank, &impl->filters_[rank]);
+      if (!status.ok()) {
+        break;
+      }
+    }
+  }
+#if VERBOSE >= 2
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.name -> %s (mode=multi-read)",
+          dirname.c_str());
+  Verbose(__LOG_ARGS__, 2, "Dfs.plfsdir.num_ranks -> %d", num_ranks);
+#endif
+
+  if (status.ok()) {
+    *result = impl;
+  } else {
+    delete impl;
+  }
 
   return status;
 }
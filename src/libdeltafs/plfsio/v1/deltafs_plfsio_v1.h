@@ -22,6 +22,10 @@ class DirWriter {
   // Report the I/O stats for logging the data and the indexes.
   IoStats TEST_iostats() const;
 
+  // Report the time spent in each phase of Finish().
+  // All zeros before Finish() is called.
+  FinishStats TEST_finish_stats() const;
+
   // Return the estimated size of each SSTable.
   // The actual memory, and storage, used by each sst may differ.
   uint64_t TEST_estimated_sstable_size() const;
@@ -61,6 +65,9 @@ class DirWriter {
   // Return the aggregated size of all inserted values.
   uint64_t TEST_value_bytes() const;
 
+  // Return the aggregated size of all values stored in the value log.
+  uint64_t TEST_value_log_bytes() const;
+
   // Return the total amount of memory reserved by this directory.
   uint64_t TEST_total_memory_usage() const;
 
@@ -148,8 +155,16 @@ class DirReader {
   struct ScanOp {
     ScanOp();
     void SetEpoch(int epoch);
+    // Only return values whose attributes are within [lo, hi]. Requires the
+    // directory to be written with an attribute extractor. Values are
+    // filtered individually only if the reader is opened with the same
+    // extractor. Otherwise, only non-matching tables and blocks are skipped.
+    void SetAttrRange(uint64_t lo, uint64_t hi);
     uint32_t epoch_start;
     uint32_t epoch_end;
+    bool has_attr_range;
+    uint64_t attr_lo;
+    uint64_t attr_hi;
     bool no_parallel_reads;
     size_t* table_seeks;
     size_t* seeks;
@@ -161,6 +176,16 @@ class DirReader {
   // Return OK on success, or a non-OK status on errors.
   virtual Status Scan(const ScanOp& op, ScanSaver, void*) = 0;
 
+  // Compute an aggregate over all pairs a scan would visit and store it in
+  // *result. Partial results are computed by each reader thread without
+  // locking and merged at the end. Directories written with fixed-sized
+  // key-value pairs are aggregated directly from their data blocks if no
+  // predicate is set. Report operation stats in *table_seeks, *seeks,
+  // and *n, where *n counts the pairs actually aggregated. Return OK on
+  // success, or a non-OK status on errors.
+  virtual Status Aggregate(const ScanOp& op, const AggregateSpec& spec,
+                           AggregateResult* result) = 0;
+
   // Return the aggregated I/O stats accumulated so far.
   virtual IoStats TEST_iostats() const = 0;
 
@@ -170,5 +195,52 @@ class DirReader {
   DirReader(const DirReader&);
 };
 
+// Merge the key summaries written by ranks [0, num_ranks) of a directory into
+// a single job-level summary file. Ranks with no summary are recorded as
+// possibly holding every key. Designed to be called by a single process once
+// all ranks have finished writing.
+// Return OK on success, or a non-OK status on errors.
+extern Status MergeDirSummaries(const std::string& dirname,
+                                const DirOptions& options, int num_ranks);
+
+// Deltafs Plfs Multi-Rank Dir Reader. Looks up keys without knowing which
+// ranks wrote them. Rank summaries are used to open and probe only the ranks
+// that may hold a key. Each rank is opened at most once and kept open
+// until the reader is deleted.
+class MultiDirReader {
+ public:
+  MultiDirReader() {}
+  virtual ~MultiDirReader();
+
+  // Open a reader against ranks [0, num_ranks) of a plfs-style directory.
+  // The job-level summary is used if present. Otherwise, the summary of each
+  // rank is loaded individually. options.rank is ignored.
+  // Return OK on success, or a non-OK status on errors.
+  static Status Open(const DirOptions& options, const std::string& dirname,
+                     int num_ranks, MultiDirReader** result);
+
+  // Default: fetch all epochs and allow parallel reads
+  struct ReadOp {
+    ReadOp();
+    void SetEpoch(int epoch);
+    uint32_t epoch_start;
+    uint32_t epoch_end;
+    bool no_parallel_reads;
+    size_t* rank_probes;  // Total ranks probed
+    size_t* table_seeks;
+    size_t* seeks;
+  };
+  // Obtain the values to a specific key stored in any rank in a given epoch
+  // range. Values from different ranks are concatenated in rank order.
+  // Report operation stats in *rank_probes, *table_seeks, and *seeks.
+  // Return OK on success, or a non-OK status on errors.
+  virtual Status Read(const ReadOp& op, const Slice& fid, std::string* dst) = 0;
+
+ private:
+  // No copying allowed
+  void operator=(const MultiDirReader&);
+  MultiDirReader(const MultiDirReader&);
+};
+
 }  // namespace plfsio
 }  // namespace pdlfs